@@ -35,35 +35,6 @@ namespace corbautil
 {
 
 
-	class PersistentPolicyFinder : public PolicyFactory
-	{
-	public:
-		PersistentPolicyFinder()
-		{ m_found_persistent_policy = 0; }
-		virtual ~PersistentPolicyFinder() {}
-
-		virtual CORBA::Policy_ptr create(
-				CORBA::ORB_ptr	orb,
-				const char *	policyName,
-				NameValue *	nvArray,
-				int		nvArraySize)
-		{
-			if (strcmp(policyName, "persistent") == 0) {
-				m_found_persistent_policy = 1;
-			}
-			return CORBA::Policy::_nil();
-		}
-
-		CORBA::Boolean	found_persistent_policy()
-		{ return m_found_persistent_policy; }
-
-	private:
-		CORBA::Boolean	m_found_persistent_policy;
-	};
-
-
-
-
 
 
 //----------------------------------------------------------------------
@@ -130,6 +101,10 @@ PoaUtility::PoaUtility(CORBA::ORB_ptr orb, DeploymentModel deployModel)
 	m_firstPoaMgr   = 1; // true
 	m_orb           = CORBA::ORB::_duplicate(orb);
 	m_poa_mgr_count = 1;
+	m_poa_mgrs      = 0;
+	m_poa_mgrs_len  = 0;
+	m_poa_mgrs_max  = 0;
+	m_policy_pool   = 0;
 	try {
 		tmpObj = m_orb->resolve_initial_references("RootPOA");
 		m_root = POA::_narrow(tmpObj);
@@ -198,6 +173,12 @@ PoaUtility::PoaUtility(CORBA::ORB_ptr orb, DeploymentModel deployModel)
 	}
 	assert(!CORBA::is_nil(m_poaMgrFactory));
 #endif
+
+	//--------
+	// Created last, as the destructor does not run if the
+	// constructor throws an exception.
+	//--------
+	m_policy_pool = new PolicyPool();
 }
 
 
@@ -212,9 +193,37 @@ PoaUtility::PoaUtility(CORBA::ORB_ptr orb, DeploymentModel deployModel)
 
 PoaUtility::~PoaUtility()
 {
-	//--------
-	// Nothing to do
-	//--------
+	delete [] m_poa_mgrs;
+	delete m_policy_pool;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	recordPoaManager()
+//
+// Description:	Remember a POA Manager created by createPoaManager()
+//----------------------------------------------------------------------
+
+void
+PoaUtility::recordPoaManager(const LabelledPOAManager & mgr)
+{
+	LabelledPOAManager *		bigger;
+	CORBA::ULong			i;
+
+	if (m_poa_mgrs_len == m_poa_mgrs_max) {
+		m_poa_mgrs_max = (m_poa_mgrs_max == 0) ? 4 : m_poa_mgrs_max * 2;
+		bigger = new LabelledPOAManager[m_poa_mgrs_max];
+		for (i = 0; i < m_poa_mgrs_len; i++) {
+			bigger[i] = m_poa_mgrs[i];
+		}
+		delete [] m_poa_mgrs;
+		m_poa_mgrs = bigger;
+	}
+	m_poa_mgrs[m_poa_mgrs_len] = mgr;
+	m_poa_mgrs_len ++;
 }
 
 
@@ -242,21 +251,11 @@ PoaUtility::createPoa(
 					      policies_str);
 		poa = parent_poa->create_POA(poa_name, labelled_mgr.mgr(),
 							policies.in());
-#if !defined(P_USE_ORBIX)
 		//--------
-		// According to the CORBA specification, you should destroy()
-		// all policy objects when you are finished with them.
-		// Otherwise, you might leak memory. In reality, most CORBA
-		// products do not leak memory in these circumstances.
-		// We choose to not destroy() the policy objects if compiling
-		// with Orbix to work around a bug associated with the
-		// destruction of an Orbix-proprietary lease policy object.
+		// The policy objects come from m_policy_pool and are
+		// shared with other POAs, so they must not be destroy()ed
+		// here. The pool destroys them when it is deleted.
 		//--------
-		CORBA::ULong len = policies->length();
-		for (CORBA::ULong i = 0; i < len; i++) {
-			policies[i]->destroy();
-		}
-#endif
 	} catch (PortableServer::POA::InvalidPolicy ex) {
 		strstream		buf;
 		CORBA::String_var	full_poa_name;
@@ -362,52 +361,59 @@ PoaUtility::createPolicyList(
 	const char *		poa_mgr_label,
 	const char *		policy_list_str) throw(PoaUtilityException)
 {
-	CORBA::PolicyList_var	seq;
+	CORBA::PolicyList_var		seq;
+	const ParsedPolicyList *	parsed;
 
+	//--------
+	// The parsed policy list comes from a cache, so a string that
+	// has been seen before is not lexed and parsed again. The parser
+	// is given the root POA, so creating the policies does not look
+	// it up.
+	//--------
 	try {
-		corbautil::PolicyListParser	parser(m_orb.in());
-		seq = parser.parsePolicyList(policy_list_str);
+		corbautil::PolicyListParser	parser(m_orb.in(),
+						&defaultPolicyFactory,
+						m_policy_pool,
+						m_root.in());
+		parsed = defaultPolicyListCache.lookup(policy_list_str);
+		seq = parser.createPolicyList(policy_list_str, *parsed);
 
 	} catch(const corbautil::ParserException & ex) {
 		throw PoaUtilityException(ex.msg);
 	}
 
 #if defined(P_USE_ORBIX)
-	CORBA::PolicyList_var		dummySeq;
 	CORBA::Boolean			has_persistent_policy;
-	PersistentPolicyFinder *	factory;
 
-	try {
-		//--------
-		// Parse the policy list again to see if it has the
-		// persistent policy.
-		//--------
-		factory = new PersistentPolicyFinder();
-		corbautil::PolicyListParser  dummyParser(m_orb.in(), factory);
-		dummySeq = dummyParser.parsePolicyList(policy_list_str);
-		has_persistent_policy = factory->found_persistent_policy();
-	} catch(const corbautil::ParserException &) {
-		assert(0); // Bug!
-	}
+	has_persistent_policy = parsed->hasPersistentPolicy();
 
 	//--------
 	// To use fixed port numbers and/or deploy persistent POAs without
 	// an IMR in an Orbix application, you have to apply proprietary
-	// policies to POAs.
+	// policies to POAs. They are pooled, like the other policies,
+	// under names that cannot be written in a policy list.
 	//--------
 	CORBA::ULong seq_len = seq->length();
+	CORBA::Policy_ptr policy;
 	if (m_deployModel   == FIXED_PORTS_NO_IMR
 	   || m_deployModel == RANDOM_PORTS_NO_IMR)
 	{
 		CORBA::Any	tmp_any;
 
 		if (has_persistent_policy) {
-			tmp_any <<= IT_PortableServer::DIRECT_PERSISTENCE;
+			policy = m_policy_pool->find(
+					"<orbix.direct_persistence>", 0, 0);
+			if (CORBA::is_nil(policy)) {
+				tmp_any <<= IT_PortableServer::DIRECT_PERSISTENCE;
+				policy = m_policy_pool->add(
+					"<orbix.direct_persistence>", 0, 0,
+					m_orb->create_policy(
+				IT_PortableServer::PERSISTENCE_MODE_POLICY_ID,
+					tmp_any));
+			}
 			seq_len++;
 			seq->length(seq_len);
-			seq[seq_len-1] = m_orb->create_policy(
-				IT_PortableServer::PERSISTENCE_MODE_POLICY_ID,
-				tmp_any);
+			seq[seq_len-1] = policy;
 		}
 	}
 
@@ -415,13 +421,24 @@ PoaUtility::createPolicyList(
 	    || m_deployModel == FIXED_PORTS_WITH_IMR)
 	{
 		CORBA::Any	tmp_any;
-		tmp_any <<= CORBA::Any::from_string(
-				CORBA::string_dup(poa_mgr_label), 0, 1);
+		NameValue	nv;
+
+		nv.name  = CORBA::string_dup("");
+		nv.value = CORBA::string_dup(poa_mgr_label);
+		policy = m_policy_pool->find(
+				"<orbix.well_known_addressing>", &nv, 1);
+		if (CORBA::is_nil(policy)) {
+			tmp_any <<= CORBA::Any::from_string(
+					CORBA::string_dup(poa_mgr_label), 0, 1);
+			policy = m_policy_pool->add(
+				"<orbix.well_known_addressing>", &nv, 1,
+				m_orb->create_policy(
+				IT_CORBA::WELL_KNOWN_ADDRESSING_POLICY_ID,
+				tmp_any));
+		}
 		seq_len++;
 		seq->length(seq_len);
-		seq[seq_len-1] = m_orb->create_policy(
-			IT_CORBA::WELL_KNOWN_ADDRESSING_POLICY_ID,
-			tmp_any);
+		seq[seq_len-1] = policy;
 	}
 #endif
 
@@ -509,6 +526,7 @@ PoaUtility::createPoaManager(const char * label) throw (PoaUtilityException)
 	}
 
 	m_firstPoaMgr = 0; // false
+	recordPoaManager(result);
 	return result;
 }
 
@@ -526,8 +544,6 @@ LabelledPOAManager
 PoaUtility::createPoaManager(const char * label) throw (PoaUtilityException)
 {
 	LabelledPOAManager		result;
-	CORBA::ULong			i;
-	CORBA::ULong			len;
 
 	try {
 		result.m_label = CORBA::string_dup(label);
@@ -548,10 +564,6 @@ PoaUtility::createPoaManager(const char * label) throw (PoaUtilityException)
 			result.m_helper_poa = m_root->create_POA(poa_name,
 					POAManager::_nil(), tmp_policies.in());
 			result.m_mgr = result.m_helper_poa->the_POAManager();
-			len = tmp_policies->length();
-			for (i = 0; i < len; i++) {
-				tmp_policies[i]->destroy();
-			}
 		}
 	} catch(CORBA::Exception & ex) {
 		strstream	buf;
@@ -564,6 +576,7 @@ PoaUtility::createPoaManager(const char * label) throw (PoaUtilityException)
 		throw PoaUtilityException(buf);
 	}
 
+	recordPoaManager(result);
 	return result;
 }
 #endif /* if/else defined(P_USE_ORBACUS) */
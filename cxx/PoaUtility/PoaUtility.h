@@ -29,6 +29,8 @@ using namespace PortableServer;
 
 namespace corbautil
 {
+	class PolicyPool;
+
 	//--------
 	// Exception thrown by some of the public APIs of PoaUtility.
 	//--------
@@ -121,7 +123,21 @@ namespace corbautil
 		POA_ptr		   root()	{ return m_root; }
 
 		//--------
-		// Additional Orbix-specific public API
+		// The POA Managers created by createPoaManager(), in the
+		// order in which they were created. ShutdownCoordinator
+		// uses these.
+		//--------
+		CORBA::ULong	   numPoaManagers() { return m_poa_mgrs_len; }
+		LabelledPOAManager & poaManager(CORBA::ULong i)
+					{ return m_poa_mgrs[i]; }
+
+		//--------
+		// Additional Orbix-specific public API. The threads of an
+		// automatic work queue are started inside the ORB, so
+		// they cannot be given a p_thread_attr (see
+		// "p_thread_attr.h"). To pin the threads that serve a
+		// POA, use a manual work queue and serve it from threads
+		// started with create_detached_thread().
 		//--------
 #if defined(P_USE_ORBIX)
 		LabelledOrbixWorkQueue createAutoWorkQueue(
@@ -161,12 +177,18 @@ namespace corbautil
 				const char *	policy_list_str)
 					throw(PoaUtilityException);
 
+		void	recordPoaManager(const LabelledPOAManager & mgr);
+
 		POA_var			m_root;
 		CORBA::ORB_var		m_orb;
 		CORBA::Boolean		m_firstPoaMgr;
 		CORBA::Boolean		m_useFixedPorts;
 		DeploymentModel		m_deployModel;
 		int			m_poa_mgr_count;
+		LabelledPOAManager *	m_poa_mgrs;
+		CORBA::ULong		m_poa_mgrs_len;
+		CORBA::ULong		m_poa_mgrs_max;
+		PolicyPool *		m_policy_pool;
 
 		//--------
 		// Orbix-specific implementation details
@@ -189,6 +211,14 @@ namespace corbautil
 #if defined(P_USE_ORBACUS) && P_ORBACUS_VERSION >= 420
 		PortableServer::POAManagerFactory_var	m_poaMgrFactory;
 #endif
+
+		//--------
+		// Not implemented. m_poa_mgrs and m_policy_pool are
+		// deleted by the destructor, so a copy would delete them
+		// twice.
+		//--------
+		PoaUtility(const PoaUtility &);
+		PoaUtility & operator=(const PoaUtility &);
 	};
 
 }; // namespace corbautil
@@ -0,0 +1,189 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ShutdownCoordinator.cxx
+//
+// Description: Class that drains a server gracefully before it shuts
+//		down
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "ShutdownCoordinator.h"
+#include "gsp_atomic.h"
+#include "gsp_timeout.h"
+#include <assert.h>
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+
+
+
+
+namespace corbautil
+{
+
+//--------
+// How often drain() checks the number of requests being processed
+//--------
+static const long	pollIntervalMs = 5;
+
+
+
+static void
+sleepMs(long ms)
+{
+#if defined(WIN32)
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	Constructor
+//
+// Description:
+//----------------------------------------------------------------------
+
+ShutdownCoordinator::ShutdownCoordinator(PoaUtility & poa_util)
+	: m_poa_util(poa_util)
+{
+	m_in_flight = 0;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	Destructor
+//
+// Description:
+//----------------------------------------------------------------------
+
+ShutdownCoordinator::~ShutdownCoordinator()
+{
+	//--------
+	// Nothing to do
+	//--------
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	drain()
+//
+// Description:	Hold new requests, wait for in-flight requests to
+//		complete, and then deactivate the POA Managers.
+//----------------------------------------------------------------------
+
+CORBA::Boolean
+ShutdownCoordinator::drain(long timeout_ms)
+{
+	CORBA::ULong			i;
+	CORBA::ULong			len;
+	CORBA::Boolean			drained;
+	double				deadline;
+
+	//--------
+	// Stop dispatching new requests. They queue up in the ORB
+	// until the POA Managers are deactivated, and then the ORB
+	// rejects them with TRANSIENT so that clients can retry them
+	// on another server.
+	//--------
+	len = m_poa_util.numPoaManagers();
+	for (i = 0; i < len; i++) {
+		try {
+			m_poa_util.poaManager(i).mgr()->hold_requests(0);
+		} catch (const CORBA::Exception &) {
+			//--------
+			// AdapterInactive: it is already deactivated
+			//--------
+		}
+	}
+
+	//--------
+	// Wait, but not beyond the deadline, for the requests that
+	// are being processed to complete.
+	//--------
+	deadline = gsp_now_usecs() + timeout_ms * 1000.0;
+	while (inFlight() > 0 && gsp_now_usecs() < deadline) {
+		sleepMs(pollIntervalMs);
+	}
+	drained = (inFlight() == 0);
+
+	//--------
+	// Deactivate in the reverse order of creation. The first POA
+	// Manager is usually the root POA Manager, which also controls
+	// the helper POAs of the others.
+	//--------
+	for (i = len; i > 0; i--) {
+		try {
+			m_poa_util.poaManager(i - 1).mgr()->deactivate(1, 0);
+		} catch (const CORBA::Exception &) {
+			//--------
+			// AdapterInactive: it is already deactivated
+			//--------
+		}
+	}
+	return drained;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	inFlight()
+//
+// Description:
+//----------------------------------------------------------------------
+
+long
+ShutdownCoordinator::inFlight()
+{
+	return gsp_atomic_load(&m_in_flight);
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	RequestOp
+//
+// Description:	Counts a request while it is being processed
+//----------------------------------------------------------------------
+
+ShutdownCoordinator::RequestOp::RequestOp(ShutdownCoordinator & coord)
+	: m_coord(coord)
+{
+	gsp_atomic_fetch_add(&m_coord.m_in_flight, 1L);
+}
+
+
+
+ShutdownCoordinator::RequestOp::~RequestOp()
+{
+	gsp_atomic_fetch_add(&m_coord.m_in_flight, -1L);
+}
+
+
+
+}; // namespace corbautil
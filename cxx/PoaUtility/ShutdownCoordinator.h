@@ -0,0 +1,87 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ShutdownCoordinator.h
+//
+// Description: Class that drains a server gracefully before it shuts
+//		down. drain() puts every POA Manager that a PoaUtility
+//		has created into the holding state, waits (up to a
+//		deadline) for the requests that are being processed to
+//		complete, and then deactivates the POA Managers in the
+//		reverse of the order in which they were created, so
+//		that the root POA Manager is deactivated last.
+//
+//		Servants count the requests that are being processed by
+//		declaring a ShutdownCoordinator::RequestOp at the start
+//		of each operation.
+//
+// Example of usage:
+//
+//	corbautil::ShutdownCoordinator * coord;
+//
+//	void sig_handler()
+//	{
+//		coord->drain(5000);	// wait at most 5 seconds
+//		orb->shutdown(0);
+//	}
+//	...
+//	coord = new corbautil::ShutdownCoordinator(poaUtil);
+//	p_register_signal_handler_deferred(sig_handler);
+//----------------------------------------------------------------------
+
+#ifndef SHUTDOWN_COORDINATOR_H_
+#define SHUTDOWN_COORDINATOR_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "PoaUtility.h"
+
+
+
+namespace corbautil
+{
+	class ShutdownCoordinator
+	{
+	public:
+		ShutdownCoordinator(PoaUtility & poa_util);
+		~ShutdownCoordinator();
+
+		//--------
+		// Returns true if all requests completed within
+		// "timeout_ms" milliseconds. The POA Managers are
+		// deactivated in either case. drain() must not be
+		// called by a thread that is processing a request.
+		//--------
+		CORBA::Boolean	drain(long timeout_ms);
+
+		//--------
+		// The number of requests being processed
+		//--------
+		long		inFlight();
+
+		class RequestOp {
+		public:
+			RequestOp(ShutdownCoordinator & coord);
+			~RequestOp();
+
+		private:
+			ShutdownCoordinator &	m_coord;
+		};
+
+	private:
+		friend class RequestOp;
+
+		PoaUtility &		m_poa_util;
+		volatile long		m_in_flight;
+	};
+
+}; // namespace corbautil
+
+
+#endif /* SHUTDOWN_COORDINATOR_H_ */
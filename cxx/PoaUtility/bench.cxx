@@ -0,0 +1,196 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	bench.cxx
+//
+// Description:	Benchmark for the creation of policies and POAs. Each
+//		pass is run once with the root POA looked up for every
+//		predefined policy, as PolicyListParser used to do
+//		("before"), and once with the root POA given to the
+//		PolicyListParser, as PoaUtility does ("after"):
+//
+//		policies  PolicyListParser::parsePolicyList(), without
+//			  a PolicyPool
+//		poas	  create_POA() with the policies from
+//			  parsePolicyList(), then destroy() of the POA
+//
+//		It prints the time per operation and operations per
+//		second.
+//
+//		Usage: bench [-n iterations] [ORB options]
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "PoaUtility.h"
+#include "PolicyListParser.h"
+#include "gsp_timeout.h"
+#include "p_iostream.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+
+
+
+//--------
+// Every policy in this list is created by the root POA
+//--------
+static const char *	policyListStr =
+		"persistent user_id retain use_active_object_map_only "
+		"multiple_id no_implicit_activation orb_ctrl_model";
+
+
+
+
+
+static void
+report(const char * pass, const char * variant, int iterations, double usecs)
+{
+	printf("%-8s  %-6s  %10.2f  %10.0f\n",
+		pass,
+		variant,
+		usecs / iterations,
+		iterations * 1000000.0 / usecs);
+}
+
+
+
+static void
+destroyPolicies(CORBA::PolicyList & seq)
+{
+	CORBA::ULong			i;
+
+	for (i = 0; i < seq.length(); i++) {
+		seq[i]->destroy();
+	}
+}
+
+
+
+//--------
+// "root" is nil for the "before" variant
+//--------
+static void
+benchPolicies(
+	CORBA::ORB_ptr			orb,
+	POA_ptr				root,
+	const char *			variant,
+	int				iterations)
+{
+	corbautil::PolicyListParser	parser(orb,
+					&corbautil::defaultPolicyFactory,
+					0, root);
+	CORBA::PolicyList_var		seq;
+	double				start;
+	int				i;
+
+	start = gsp_now_usecs();
+	for (i = 0; i < iterations; i++) {
+		seq = parser.parsePolicyList(policyListStr);
+		destroyPolicies(seq.inout());
+	}
+	report("policies", variant, iterations, gsp_now_usecs() - start);
+}
+
+
+
+static void
+benchPoas(
+	CORBA::ORB_ptr			orb,
+	POA_ptr				root,
+	POA_ptr				parser_root,
+	const char *			variant,
+	int				iterations)
+{
+	corbautil::PolicyListParser	parser(orb,
+					&corbautil::defaultPolicyFactory,
+					0, parser_root);
+	CORBA::PolicyList_var		seq;
+	POAManager_var			mgr;
+	POA_var				poa;
+	char				name[64];
+	double				start;
+	int				i;
+
+	mgr = root->the_POAManager();
+	start = gsp_now_usecs();
+	for (i = 0; i < iterations; i++) {
+		sprintf(name, "bench_%s_%d", variant, i);
+		seq = parser.parsePolicyList(policyListStr);
+		poa = root->create_POA(name, mgr.in(), seq.in());
+		destroyPolicies(seq.inout());
+		poa->destroy(0, 0);
+	}
+	report("poas", variant, iterations, gsp_now_usecs() - start);
+}
+
+
+
+
+
+int
+main(int argc, char ** argv)
+{
+	CORBA::ORB_var			orb;
+	corbautil::PoaUtility *		poaUtil;
+	POA_ptr				root;
+	int				iterations;
+	int				exit_code;
+
+	exit_code = 0;
+	poaUtil = 0;
+	try {
+		orb = CORBA::ORB_init(argc, argv);
+		iterations = 1000;
+		if (argc == 3 && strcmp(argv[1], "-n") == 0) {
+			iterations = atoi(argv[2]);
+		} else if (argc != 1) {
+			fprintf(stderr, "usage: %s [-n iterations]\n",
+				argv[0]);
+			throw -1;
+		}
+		if (iterations <= 0) {
+			iterations = 1;
+		}
+
+		poaUtil = new corbautil::PoaUtility(orb.in(),
+				corbautil::PoaUtility::RANDOM_PORTS_NO_IMR);
+		root = poaUtil->root();
+
+		printf("%-8s  %-6s  %10s  %10s\n",
+			"pass", "", "usecs/op", "ops/sec");
+		benchPolicies(orb.in(), POA::_nil(), "before", iterations);
+		benchPolicies(orb.in(), root, "after", iterations);
+		benchPoas(orb.in(), root, POA::_nil(), "before", iterations);
+		benchPoas(orb.in(), root, root, "after", iterations);
+	} catch(const CORBA::Exception & ex) {
+		cerr << ex << endl;
+		exit_code = 1;
+	} catch(const corbautil::PoaUtilityException & ex) {
+		cerr << ex << endl;
+		exit_code = 1;
+	} catch(const corbautil::ParserException & ex) {
+		cerr << ex << endl;
+		exit_code = 1;
+	} catch(int) {
+		exit_code = 1;
+	}
+
+	delete poaUtil;
+	try {
+		if (!CORBA::is_nil(orb)) {
+			orb->destroy();
+		}
+	} catch(const CORBA::Exception & ex) {
+		exit_code = 1;
+	}
+	return exit_code;
+}
@@ -17,6 +17,7 @@
 #include "PolicyListParser.h"
 #include "p_iostream.h"
 #include "PoaUtility.h"
+#include "gsp_mutex.h"
 #include <assert.h>
 #if P_ORBIX_VERSION >= 61
 #include "orbix/leasing.hh"
@@ -27,20 +28,74 @@
 
 
 //--------
-// Singleton object
+// Singleton objects
 //--------
 corbautil::ExtendablePolicyFactory corbautil::defaultPolicyFactory;
+corbautil::PolicyListCache corbautil::defaultPolicyListCache;
 
 
 
 
 
 //--------
-// Forward declaration of static functions
+// The predefined policies. ExtendablePolicyFactory enters them into its
+// hash table, and create() switches on the PredefinedPolicy value of
+// the entry it finds.
 //--------
 namespace corbautil {
-	static CORBA::Boolean isPredefinedPolicyName(const char * name);
-}
+
+enum PredefinedPolicy {
+	pp_orb_ctrl_model = 1,	// 0 means "not a predefined policy"
+	pp_single_thread_model,
+	pp_transient,
+	pp_persistent,
+	pp_unique_id,
+	pp_multiple_id,
+	pp_user_id,
+	pp_system_id,
+	pp_implicit_activation,
+	pp_no_implicit_activation,
+	pp_retain,
+	pp_non_retain,
+	pp_use_active_object_map_only,
+	pp_use_default_servant,
+	pp_use_servant_manager,
+	pp_orbix_deliver,
+	pp_orbix_discard,
+	pp_orbix_hold,
+	pp_orbix_no_lease
+};
+
+static const struct {
+	const char *		name;
+	PredefinedPolicy	policy;
+} predefinedPolicies[] = {
+#if defined(P_USE_ORBIX)
+	{ "orbix.deliver",		pp_orbix_deliver },
+	{ "orbix.discard",		pp_orbix_discard },
+	{ "orbix.hold",			pp_orbix_hold },
+#if P_ORBIX_VERSION >= 61
+	{ "orbix.no_lease",		pp_orbix_no_lease },
+#endif
+#endif
+	{ "orb_ctrl_model",		pp_orb_ctrl_model },
+	{ "single_thread_model",	pp_single_thread_model },
+	{ "transient",			pp_transient },
+	{ "persistent",			pp_persistent },
+	{ "unique_id",			pp_unique_id },
+	{ "multiple_id",		pp_multiple_id },
+	{ "user_id",			pp_user_id },
+	{ "system_id",			pp_system_id },
+	{ "implicit_activation",	pp_implicit_activation },
+	{ "no_implicit_activation",	pp_no_implicit_activation },
+	{ "retain",			pp_retain },
+	{ "non_retain",			pp_non_retain },
+	{ "use_active_object_map_only",	pp_use_active_object_map_only },
+	{ "use_default_servant",	pp_use_default_servant },
+	{ "use_servant_manager",	pp_use_servant_manager }
+};
+
+}; // namespace corbautil
 
 
 
@@ -89,9 +144,9 @@ ostream& operator << (ostream & out, const corbautil::Token & t)
 {
 	out	<< "token(kind="
 		<< t.kind()
-		<< "; spelling='"
-		<< t.spelling()
-		<< "')";
+		<< "; spelling='";
+	out.write(t.start(), t.length());
+	out	<< "')";
 	return out;
 }
 
@@ -122,7 +177,7 @@ namespace corbautil
 
 LexicalAnalyser::LexicalAnalyser(const char * str)
 {
-	m_str            = CORBA::string_dup(str);
+	m_str            = str;
 	m_len            = strlen(m_str);
 	m_i              = 0;
 	m_in_parenthesis = 0;
@@ -156,7 +211,7 @@ LexicalAnalyser::~LexicalAnalyser()
 void
 LexicalAnalyser::reset(const char * str)
 {
-	m_str            = CORBA::string_dup(str);
+	m_str            = str;
 	m_len            = strlen(m_str);
 	m_i              = 0;
 	m_in_parenthesis = 0;
@@ -169,14 +224,15 @@ LexicalAnalyser::reset(const char * str)
 //----------------------------------------------------------------------
 // Function:	nextToken()
 //
-// Description:	
+// Description:	The spelling of "tok" points into m_str, so this
+//		does not allocate memory.
 //----------------------------------------------------------------------
 
 void
 LexicalAnalyser::nextToken(Token & tok)
 {
-	CORBA::ULong	start;
-	char *		identSpelling;
+	static const char	eosSpelling[] = "<end-of-policy-list>";
+	CORBA::ULong		start;
 
 	//--------
 	// Skip over whitespace. Note that a plus sign is always consisdered
@@ -199,8 +255,7 @@ LexicalAnalyser::nextToken(Token & tok)
 	//--------
 	if (start == m_len) {
 		m_i = start;
-		tok.kind(t_EOS);
-		tok.spelling("<end-of-policy-list>");
+		tok.reset(t_EOS, eosSpelling, sizeof(eosSpelling) - 1);
 		return;
 	}
 
@@ -212,11 +267,7 @@ LexicalAnalyser::nextToken(Token & tok)
 		while (m_i < m_len && isValidIdentChar(m_str[m_i])) {
 			m_i ++;
 		}
-		identSpelling = new char[m_i - start + 1];
-		strncpy(identSpelling, &m_str[start], m_i-start);
-		identSpelling[m_i-start] = '\0';
-		tok.reset(t_ident, identSpelling);
-		delete [] identSpelling;
+		tok.reset(t_ident, &m_str[start], m_i - start);
 		return;
 	}
 
@@ -224,20 +275,16 @@ LexicalAnalyser::nextToken(Token & tok)
 	// Handle string literal values
 	//--------
 	if (m_str[start] == '\'') {
+		start ++; // skip after opening '\''
 		m_i = start;
 		while (m_i < m_len && m_str[m_i] != '\'') {
 			m_i ++;
 		}
-		if (m_str[m_i] != '\'') {
+		if (m_i == m_len) {
 			throw ParserException(
 				"Unterminated string literal in policy list");
 		}
-		start ++; // skip after opening '\''
-		identSpelling = new char[m_i - start + 1];
-		strncpy(identSpelling, &m_str[start], m_i-start);
-		identSpelling[m_i-start] = '\0';
-		tok.reset(t_ident, identSpelling);
-		delete [] identSpelling;
+		tok.reset(t_ident, &m_str[start], m_i - start);
 		m_i ++; // skip over closing '\''
 		return;
 	}
@@ -252,7 +299,7 @@ LexicalAnalyser::nextToken(Token & tok)
 				"Unexpected '(' inside a parameter list");
 		}
 		m_in_parenthesis = 1;
-		tok.reset(corbautil::t_open_p, "(");
+		tok.reset(corbautil::t_open_p, &m_str[start], 1);
 		m_i = start + 1;
 		break;
 	case ')':
@@ -261,16 +308,16 @@ LexicalAnalyser::nextToken(Token & tok)
 				"Unexpected ')' outside a parameter list");
 		}
 		m_in_parenthesis = 0;
-		tok.reset(corbautil::t_close_p, ")");
+		tok.reset(corbautil::t_close_p, &m_str[start], 1);
 		m_i = start + 1;
 		break;
 	case ',':
 		assert(m_in_parenthesis);
-		tok.reset(corbautil::t_comma, "'");
+		tok.reset(corbautil::t_comma, &m_str[start], 1);
 		m_i = start + 1;
 		break;
 	case '=':
-		tok.reset(corbautil::t_equals, "=");
+		tok.reset(corbautil::t_equals, &m_str[start], 1);
 		m_i = start + 1;
 		break;
 	default:
@@ -422,6 +469,36 @@ PolicyFactory::rootPoa(CORBA::ORB_ptr orb) throw(ParserException)
 
 
 
+PortableServer::POA_ptr
+PolicyFactory::rootPoa(
+	CORBA::ORB_ptr			orb,
+	PortableServer::POA_ptr		root) throw(ParserException)
+{
+	if (!CORBA::is_nil(root)) {
+		return PortableServer::POA::_duplicate(root);
+	}
+	return rootPoa(orb);
+}
+
+
+
+
+
+CORBA::Policy_ptr
+PolicyFactory::createWithRootPoa(
+	CORBA::ORB_ptr			orb,
+	PortableServer::POA_ptr		root,
+	const char *			policyName,
+	NameValue *			nvArray,
+	int				nvArraySize)
+{
+	return create(orb, policyName, nvArray, nvArraySize);
+}
+
+
+
+
+
 //======================================================================
 // ExtendablePolicyFactory
 //======================================================================
@@ -432,7 +509,21 @@ PolicyFactory::rootPoa(CORBA::ORB_ptr orb) throw(ParserException)
 
 ExtendablePolicyFactory::ExtendablePolicyFactory()
 {
-	// nothing to do
+	PolicyFactoryList *		entry;
+	int				i;
+
+	for (i = 0; i < numBuckets; i++) {
+		m_buckets[i] = 0;
+	}
+	for (i = 0;
+	     i < (int)(sizeof(predefinedPolicies)/sizeof(predefinedPolicies[0]));
+	     i++)
+	{
+		entry = new PolicyFactoryList();
+		entry->m_predefined = predefinedPolicies[i].policy;
+		entry->m_name = CORBA::string_dup(predefinedPolicies[i].name);
+		insert(entry);
+	}
 }
 
 
@@ -441,7 +532,46 @@ ExtendablePolicyFactory::ExtendablePolicyFactory()
 
 ExtendablePolicyFactory::~ExtendablePolicyFactory()
 {
-	// nothing to do
+	int				i;
+
+	//--------
+	// Deleting the head of a list deletes the rest of it
+	//--------
+	for (i = 0; i < numBuckets; i++) {
+		delete m_buckets[i];
+	}
+}
+
+
+
+
+
+PolicyFactoryList *
+ExtendablePolicyFactory::lookup(const char * policyName)
+{
+	PolicyFactoryList *		ptr;
+
+	ptr = m_buckets[PolicyListCache::hash(policyName) % numBuckets];
+	for (; ptr != 0; ptr = ptr->m_next) {
+		if (strcmp(ptr->m_name.in(), policyName) == 0) {
+			return ptr;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+void
+ExtendablePolicyFactory::insert(PolicyFactoryList * entry)
+{
+	unsigned long			index;
+
+	index = PolicyListCache::hash(entry->m_name.in()) % numBuckets;
+	entry->m_next = m_buckets[index];
+	m_buckets[index] = entry;
 }
 
 
@@ -459,7 +589,8 @@ ExtendablePolicyFactory::registerPolicyFactory(
 	// Check that the policyName does not conflict with any
 	// predefined policies
 	//--------
-	if (isPredefinedPolicyName(policyName)) {
+	ptr = lookup(policyName);
+	if (ptr != 0 && ptr->m_factory == 0) {
 		strstream	buf;
 		buf	<< "PoaUtility::registerPolicyFactory() "
 			<< "failed: attempted registration of '"
@@ -473,26 +604,23 @@ ExtendablePolicyFactory::registerPolicyFactory(
 	//--------
 	// Check that a similarly-named factory is not already registered
 	//--------
-	for (ptr = m_head.m_next; ptr != 0; ptr = ptr->m_next) {
-		if (strcmp(policyName, ptr->m_name.in()) == 0) {
-			strstream	buf;
-			buf	<< "PoaUtility::registerPolicyFactory() "
-				<< "failed: attempted re-registration of '"
-				<< policyName
-				<< "' policy" 
-				<< ends;
-			throw ParserException(buf);
-		}
+	if (ptr != 0) {
+		strstream	buf;
+		buf	<< "PoaUtility::registerPolicyFactory() "
+			<< "failed: attempted re-registration of '"
+			<< policyName
+			<< "' policy" 
+			<< ends;
+		throw ParserException(buf);
 	}
 
 	//--------
-	// Insert the factory at the start of the list
+	// Insert the factory into the hash table
 	//--------
 	ptr = new PolicyFactoryList();
 	ptr->m_factory = factory;
 	ptr->m_name = CORBA::string_dup(policyName);
-	ptr->m_next = m_head.m_next;
-	m_head.m_next = ptr;
+	insert(ptr);
 }
 
 
@@ -505,102 +633,154 @@ ExtendablePolicyFactory::create(
 	const char *			name,
 	NameValue *			nvArray,
 	int				nvArraySize)
+{
+	return createWithRootPoa(orb, PortableServer::POA::_nil(), name,
+				 nvArray, nvArraySize);
+}
+
+
+
+
+
+CORBA::Policy_ptr
+ExtendablePolicyFactory::createWithRootPoa(
+	CORBA::ORB_ptr			orb,
+	PortableServer::POA_ptr		root,
+	const char *			name,
+	NameValue *			nvArray,
+	int				nvArraySize)
 {
 	CORBA::Policy_var		result;
+	PortableServer::POA_var		poa;
 	PolicyFactoryList *		ptr;
-	CORBA::String_var		parameterlessName;
 	strstream			buf;
 
+	ptr = lookup(name);
+	if (ptr == 0) {
+		//--------
+		// Illegal policy name. Throw back a descriptive exception.
+		//--------
+		buf << "illegal policy name" << ends;
+		throw ParserException(buf);
+	}
+
+	if (ptr->m_factory != 0) {
+		try {
+			return ptr->m_factory->createWithRootPoa(orb, root,
+						name, nvArray, nvArraySize);
+		} catch(const ParserException &) {
+			throw;
+		} catch(const CORBA::Exception & ex) {
+			buf	<< ex
+				<< ends;
+			throw ParserException(buf);
+		}
+	}
 
-	if (isPredefinedPolicyName(name) && nvArraySize != 0) {
+	if (nvArraySize != 0) {
 		buf << "policy '" << name << "' does not take any parameters"
 		    << ends;
 		throw ParserException(buf);
+	}
 
+	//--------
+	// The proprietary Orbix policies are created by the ORB, not
+	// by the root POA.
+	//--------
+	if (ptr->m_predefined <= pp_use_servant_manager) {
+		poa = rootPoa(orb, root);
 	}
 
-	if (strcmp(name, "orb_ctrl_model") == 0) {
-		result = rootPoa(orb)->create_thread_policy(ORB_CTRL_MODEL);
-	} else if (strcmp(name, "single_thread_model") == 0) {
-		result = rootPoa(orb)->create_thread_policy(
-							SINGLE_THREAD_MODEL);
-	} else if (strcmp(name, "transient") == 0) {
-		result = rootPoa(orb)->create_lifespan_policy(TRANSIENT);
-	} else if (strcmp(name, "persistent") == 0) {
-		result = rootPoa(orb)->create_lifespan_policy(PERSISTENT);
-	} else if (strcmp(name, "unique_id") == 0) {
-		result = rootPoa(orb)->create_id_uniqueness_policy(UNIQUE_ID);
-	} else if (strcmp(name, "multiple_id") == 0) {
-		result = rootPoa(orb)->create_id_uniqueness_policy(MULTIPLE_ID);
-	} else if (strcmp(name, "user_id") == 0) {
-		result = rootPoa(orb)->create_id_assignment_policy(USER_ID);
-	} else if (strcmp(name, "system_id") == 0) {
-		result = rootPoa(orb)->create_id_assignment_policy(SYSTEM_ID);
-	} else if (strcmp(name, "implicit_activation") == 0) {
-		result = rootPoa(orb)->create_implicit_activation_policy(
+	switch (ptr->m_predefined) {
+	case pp_orb_ctrl_model:
+		result = poa->create_thread_policy(ORB_CTRL_MODEL);
+		break;
+	case pp_single_thread_model:
+		result = poa->create_thread_policy(SINGLE_THREAD_MODEL);
+		break;
+	case pp_transient:
+		result = poa->create_lifespan_policy(TRANSIENT);
+		break;
+	case pp_persistent:
+		result = poa->create_lifespan_policy(PERSISTENT);
+		break;
+	case pp_unique_id:
+		result = poa->create_id_uniqueness_policy(UNIQUE_ID);
+		break;
+	case pp_multiple_id:
+		result = poa->create_id_uniqueness_policy(MULTIPLE_ID);
+		break;
+	case pp_user_id:
+		result = poa->create_id_assignment_policy(USER_ID);
+		break;
+	case pp_system_id:
+		result = poa->create_id_assignment_policy(SYSTEM_ID);
+		break;
+	case pp_implicit_activation:
+		result = poa->create_implicit_activation_policy(
 					IMPLICIT_ACTIVATION);
-	} else if (strcmp(name, "no_implicit_activation") == 0) {
-		result = rootPoa(orb)->create_implicit_activation_policy(
+		break;
+	case pp_no_implicit_activation:
+		result = poa->create_implicit_activation_policy(
 					NO_IMPLICIT_ACTIVATION);
-	} else if (strcmp(name, "retain") == 0) {
-		result = rootPoa(orb)->create_servant_retention_policy(RETAIN);
-	} else if (strcmp(name, "non_retain") == 0) {
-		result = rootPoa(orb)->create_servant_retention_policy(
-								NON_RETAIN);
-	} else if (strcmp(name, "use_active_object_map_only") == 0) {
-		result = rootPoa(orb)->create_request_processing_policy(
+		break;
+	case pp_retain:
+		result = poa->create_servant_retention_policy(RETAIN);
+		break;
+	case pp_non_retain:
+		result = poa->create_servant_retention_policy(NON_RETAIN);
+		break;
+	case pp_use_active_object_map_only:
+		result = poa->create_request_processing_policy(
 					USE_ACTIVE_OBJECT_MAP_ONLY);
-	} else if (strcmp(name, "use_default_servant") == 0) {
-		result = rootPoa(orb)->create_request_processing_policy(
+		break;
+	case pp_use_default_servant:
+		result = poa->create_request_processing_policy(
 					USE_DEFAULT_SERVANT);
-	} else if (strcmp(name, "use_servant_manager") == 0) {
-		result = rootPoa(orb)->create_request_processing_policy(
+		break;
+	case pp_use_servant_manager:
+		result = poa->create_request_processing_policy(
 					USE_SERVANT_MANAGER);
+		break;
 #if defined(P_USE_ORBIX)
-	} else if (strcmp(name, "orbix.deliver") == 0) {
-		CORBA::Any	a;
-		a <<= IT_PortableServer::DELIVER;
-		result = orb->create_policy(
-			IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
-	} else if (strcmp(name, "orbix.discard") == 0) {
-		CORBA::Any	a;
-		a <<= IT_PortableServer::DISCARD;
-		result = orb->create_policy(
-			IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
-	} else if (strcmp(name, "orbix.hold") == 0) {
-		CORBA::Any	a;
-		a <<= IT_PortableServer::HOLD;
-		result = orb->create_policy(
-			IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
+	case pp_orbix_deliver:
+		{
+			CORBA::Any	a;
+			a <<= IT_PortableServer::DELIVER;
+			result = orb->create_policy(
+			    IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
+		}
+		break;
+	case pp_orbix_discard:
+		{
+			CORBA::Any	a;
+			a <<= IT_PortableServer::DISCARD;
+			result = orb->create_policy(
+			    IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
+		}
+		break;
+	case pp_orbix_hold:
+		{
+			CORBA::Any	a;
+			a <<= IT_PortableServer::HOLD;
+			result = orb->create_policy(
+			    IT_PortableServer::OBJECT_DEACTIVATION_POLICY_ID, a);
+		}
+		break;
 #if P_ORBIX_VERSION >= 61
-	} else if (strcmp(name, "orbix.no_lease") == 0) {
-		CORBA::Any	a;
-		a <<= CORBA::Any::from_boolean(0);
-		result = orb->create_policy(IT_Leasing::LEASING_POLICY_ID, a);
+	case pp_orbix_no_lease:
+		{
+			CORBA::Any	a;
+			a <<= CORBA::Any::from_boolean(0);
+			result = orb->create_policy(
+					IT_Leasing::LEASING_POLICY_ID, a);
+		}
+		break;
 #endif
 #endif
-	} else {
-		for (ptr = m_head.m_next; ptr != 0; ptr = ptr->m_next) {
-			if (strcmp(ptr->m_name.in(), name) == 0) {
-				try {
-					return ptr->m_factory->create(
-							orb, name,
-							nvArray, nvArraySize);
-				} catch(const ParserException &) {
-					throw;
-				} catch(const CORBA::Exception & ex) {
-					buf	<< ex
-						<< ends;
-					throw ParserException(buf);
-				}
-			}
-		}
-
-		//--------
-		// Illegal policy name. Throw back a descriptive exception.
-		//--------
-		buf << "illegal policy name" << ends;
-		throw ParserException(buf);
+	default:
+		assert(0);
+		break;
 	}
 	return result._retn();
 }
@@ -619,19 +799,17 @@ ExtendablePolicyFactory::create(
 
 PolicyListParser::PolicyListParser(
 	CORBA::ORB_ptr			orb,
-	PolicyFactory *			factory)
+	PolicyFactory *			factory,
+	PolicyPool *			pool,
+	PortableServer::POA_ptr		root)
 		: m_lex("")
 {
 	m_orb             = orb;
 	m_factory         = factory;
+	m_pool            = pool;
+	m_root            = PortableServer::POA::_duplicate(root);
 	m_policy_list_str = "";
 	m_lex.nextToken(m_token);
-
-	//--------
-	// Pre-allocate some space for the sequence of policies
-	//--------
-	m_seq.length(7);
-	m_seq.length(0);
 }
 
 
@@ -640,15 +818,29 @@ PolicyListParser::PolicyListParser(
 
 CORBA::PolicyList *
 PolicyListParser::parsePolicyList(const char * policy_list_str)
+{
+	const ParsedPolicyList *	parsed;
+
+	parsed = defaultPolicyListCache.lookup(policy_list_str);
+	return createPolicyList(policy_list_str, *parsed);
+}
+
+
+
+
+
+void
+PolicyListParser::parse(
+	const char *			policy_list_str,
+	ParsedPolicyList &		result)
 {
 	m_policy_list_str = policy_list_str;
 	m_lex.reset(policy_list_str);
 	m_lex.nextToken(m_token);
 	while (m_token.kind() == t_ident) {
-		parsePolicy();
+		parsePolicy(result);
 	}
 	accept(t_EOS, "unexpected end of policy list");
-	return new CORBA::PolicyList(m_seq);
 }
 
 
@@ -656,25 +848,25 @@ PolicyListParser::parsePolicyList(const char * policy_list_str)
 
 
 void
-PolicyListParser::parsePolicy()
+PolicyListParser::parsePolicy(ParsedPolicyList & result)
 {
 	CORBA::String_var		policyName;
-	CORBA::StringSeq		paramNameSeq(20);
-	CORBA::StringSeq		paramValueSeq(20);
-	CORBA::ULong			paramCount;
+	NameValue *			nvArray;
+	int				nvArraySize;
+	int				nvArrayMax;
 
 	//--------
 	// Record the name of the policy
 	//--------
-	policyName = CORBA::string_dup(m_token.spelling());
+	policyName = m_token.dupSpelling();
 	m_lex.nextToken(m_token);
 
 	//--------
-	// If there is no parameter list for the policy then process
+	// If there is no parameter list for the policy then record
 	// it immediately and return.
 	//--------
 	if (m_token.kind() != t_open_p) {
-		processPolicy(policyName.in(), paramNameSeq, paramValueSeq);
+		result.add(policyName._retn(), 0, 0);
 		return;
 	}
 
@@ -683,55 +875,81 @@ PolicyListParser::parsePolicy()
 	//--------
 	assert(m_token.kind() == t_open_p);
 	m_lex.nextToken(m_token); // consume '('
-	paramCount = 0;
-
-	if (m_token.kind() != t_close_p) {
-		parsePolicyParam(paramNameSeq, paramValueSeq, paramCount);
-		while (m_token.kind() == t_comma) {
-			m_lex.nextToken(m_token); // consume ','
-			parsePolicyParam(paramNameSeq, paramValueSeq,
-						paramCount);
+	nvArray     = 0;
+	nvArraySize = 0;
+	nvArrayMax  = 0;
+
+	try {
+		if (m_token.kind() != t_close_p) {
+			parsePolicyParam(nvArray, nvArraySize, nvArrayMax);
+			while (m_token.kind() == t_comma) {
+				m_lex.nextToken(m_token); // consume ','
+				parsePolicyParam(nvArray, nvArraySize,
+						 nvArrayMax);
+			}
 		}
+		accept(t_close_p, "Expecting \",\" or \")\"");
+	} catch(const ParserException &) {
+		delete [] nvArray;
+		throw;
 	}
-	accept(t_close_p, "Expecting \",\" or \")\"");
 
 	//--------
-	// Process the policy.
+	// Record the policy and its parameters.
 	//--------
-	processPolicy(policyName.in(), paramNameSeq, paramValueSeq);
+	result.add(policyName._retn(), nvArray, nvArraySize);
 }
 
 
 
 
 
+//----------------------------------------------------------------------
+// Function:	parsePolicyParam()
+//
+// Description:	Parse "name=value" or "value" and append it to
+//		"nvArray", which is grown by doubling. The tokens are
+//		copied into strings only once they are known to be
+//		valid.
+//----------------------------------------------------------------------
+
 void
 PolicyListParser::parsePolicyParam(
-	CORBA::StringSeq &	paramNameSeq,
-	CORBA::StringSeq &	paramValueSeq,
-	CORBA::ULong &		paramCount)
+	NameValue *&		nvArray,
+	int &			nvArraySize,
+	int &			nvArrayMax)
 {
-	CORBA::String_var		ident1;
-	CORBA::String_var		ident2;
+	Token			ident1;
+	Token			ident2;
+	NameValue *		bigger;
+	int			i;
 
-	ident1 = CORBA::string_dup(m_token.spelling());
+	ident1 = m_token;
 	accept(t_ident, "Expecting a parameter name, value or \")\"");
 	if (m_token.kind() == t_equals) {
 		m_lex.nextToken(m_token); // consume '='
-		ident2 = CORBA::string_dup(m_token.spelling());
+		ident2 = m_token;
 		accept(t_ident, "Expecting a parameter value");
-		paramCount++;
-		paramNameSeq.length(paramCount);
-		paramValueSeq.length(paramCount);
-		paramNameSeq[paramCount-1]  = CORBA::string_dup(ident1);
-		paramValueSeq[paramCount-1] = CORBA::string_dup(ident2);
+	}
+
+	if (nvArraySize == nvArrayMax) {
+		nvArrayMax = (nvArrayMax == 0) ? 4 : nvArrayMax * 2;
+		bigger = new NameValue[nvArrayMax];
+		for (i = 0; i < nvArraySize; i++) {
+			bigger[i].name  = nvArray[i].name._retn();
+			bigger[i].value = nvArray[i].value._retn();
+		}
+		delete [] nvArray;
+		nvArray = bigger;
+	}
+	if (ident2.kind() == t_ident) {
+		nvArray[nvArraySize].name  = ident1.dupSpelling();
+		nvArray[nvArraySize].value = ident2.dupSpelling();
 	} else {
-		paramCount++;
-		paramNameSeq.length(paramCount);
-		paramValueSeq.length(paramCount);
-		paramNameSeq[paramCount-1]  = CORBA::string_dup("");
-		paramValueSeq[paramCount-1] = CORBA::string_dup(ident1);
+		nvArray[nvArraySize].name  = CORBA::string_dup("");
+		nvArray[nvArraySize].value = ident1.dupSpelling();
 	}
+	nvArraySize ++;
 }
 
 
@@ -748,9 +966,9 @@ PolicyListParser::accept(TokenKind expectedKind, const char * errMsg)
 
 		buf	<< "error parsing policy list '"
 			<< m_policy_list_str
-			<< "' near '"
-			<< m_token.spelling()
-			<< "': "
+			<< "' near '";
+		buf.write(m_token.start(), m_token.length());
+		buf	<< "': "
 			<< errMsg
 			<< endl;
 		throw corbautil::ParserException(buf);
@@ -761,58 +979,284 @@ PolicyListParser::accept(TokenKind expectedKind, const char * errMsg)
 
 
 
+CORBA::PolicyList *
+PolicyListParser::createPolicyList(
+	const char *			policy_list_str,
+	const ParsedPolicyList &	parsed)
+{
+	CORBA::PolicyList_var		seq;
+	const char *			name;
+	int				i;
+	int				len;
+
+	len = parsed.numPolicies();
+	seq = new CORBA::PolicyList(len);
+	seq->length(len);
+	for (i = 0; i < len; i++) {
+		name = parsed.policyName(i);
+		try {
+			if (m_pool != 0) {
+				seq[(CORBA::ULong)i] = m_pool->intern(m_orb,
+						m_root.in(), m_factory, name,
+						parsed.params(i),
+						parsed.numParams(i));
+			} else {
+				seq[(CORBA::ULong)i] =
+					m_factory->createWithRootPoa(m_orb,
+						m_root.in(), name,
+						parsed.params(i),
+						parsed.numParams(i));
+			}
+		} catch(const corbautil::ParserException & ex) {
+			strstream	buf;
+			buf	<< "error creating policy '"
+				<< name
+				<< "' in '"
+				<< policy_list_str
+				<< "': "
+				<< ex
+				<< endl;
+			throw corbautil::ParserException(buf);
+		} catch(const CORBA::Exception & ex) {
+			strstream	buf;
+			buf	<< "error creating policy '"
+				<< name
+				<< "' in '"
+				<< policy_list_str
+				<< "': "
+				<< ex
+				<< endl;
+			throw corbautil::ParserException(buf);
+		}
+	}
+	return seq._retn();
+}
+
+
+
+
+
+//======================================================================
+// ParsedPolicyList
+//======================================================================
+
+
+
+
+
+ParsedPolicyList::ParsedPolicyList()
+{
+	m_entries               = 0;
+	m_len                   = 0;
+	m_max                   = 0;
+	m_has_persistent_policy = 0;
+}
+
+
+
+
+
+ParsedPolicyList::~ParsedPolicyList()
+{
+	int			i;
+
+	for (i = 0; i < m_len; i++) {
+		delete [] m_entries[i].nvArray;
+	}
+	delete [] m_entries;
+}
+
+
+
+
+
 void
-PolicyListParser::processPolicy(
-	const char *			name,
-	const CORBA::StringSeq &	paramNameSeq,
-	const CORBA::StringSeq &	paramValueSeq)
+ParsedPolicyList::add(
+	char *			policyName,
+	NameValue *		nvArray,
+	int			nvArraySize)
 {
-	strstream			buf;
-	CORBA::ULong			len;
-	CORBA::ULong			i;
-	NameValue *			nvArray;
-	int				nvArraySize;
+	Entry *			bigger;
+	int			i;
 
-	assert(paramNameSeq.length() == paramValueSeq.length());
-	nvArraySize = paramNameSeq.length();
-	if (nvArraySize == 0) {
-		nvArray = 0;
-	} else {
-		nvArray = new NameValue[nvArraySize];
-		for (i = 0; i < nvArraySize; i++) {
-			nvArray[i].name
-				= CORBA::string_dup(paramNameSeq[i]);
-			nvArray[i].value
-				= CORBA::string_dup(paramValueSeq[i]);
+	if (m_len == m_max) {
+		m_max = (m_max == 0) ? 8 : m_max * 2;
+		bigger = new Entry[m_max];
+		for (i = 0; i < m_len; i++) {
+			bigger[i].name        = m_entries[i].name._retn();
+			bigger[i].nvArray     = m_entries[i].nvArray;
+			bigger[i].nvArraySize = m_entries[i].nvArraySize;
 		}
+		delete [] m_entries;
+		m_entries = bigger;
+	}
+	m_entries[m_len].name        = policyName;
+	m_entries[m_len].nvArray     = nvArray;
+	m_entries[m_len].nvArraySize = nvArraySize;
+	m_len ++;
+
+	if (strcmp(policyName, "persistent") == 0) {
+		m_has_persistent_policy = 1;
+	}
+}
+
+
+
+
+
+//======================================================================
+// PolicyListCache
+//======================================================================
+
+
+
+
+
+PolicyListCache::PolicyListCache()
+{
+	int			i;
+
+	for (i = 0; i < numBuckets; i++) {
+		m_buckets[i] = 0;
 	}
+	m_mutex = new GSP_Mutex();
+}
 
-	len = m_seq.length();
-	m_seq.length(len+1);
+
+
+
+
+PolicyListCache::~PolicyListCache()
+{
+	int			i;
+	Entry *			e;
+	Entry *			next;
+
+	for (i = 0; i < numBuckets; i++) {
+		for (e = m_buckets[i]; e != 0; e = next) {
+			next = e->next;
+			delete e->parsed;
+			delete e;
+		}
+	}
+	delete m_mutex;
+}
+
+
+
+
+
+const ParsedPolicyList *
+PolicyListCache::lookup(const char * policy_list_str)
+{
+	CORBA::String_var	key;
+	unsigned long		index;
+	Entry *			e;
+	ParsedPolicyList *	parsed;
+
+	key = normalise(policy_list_str);
+	index = hash(key.in()) % numBuckets;
+
+	GSP_Mutex::Op		scopedLock(*m_mutex);
+
+	for (e = m_buckets[index]; e != 0; e = e->next) {
+		if (strcmp(e->key.in(), key.in()) == 0) {
+			return e->parsed;
+		}
+	}
+
+	//--------
+	// Not found. Parse it (this might throw an exception) and then
+	// insert it.
+	//--------
+	parsed = new ParsedPolicyList();
 	try {
-		m_seq[len] = m_factory->create(
-					m_orb, name, nvArray, nvArraySize);
-	} catch(const corbautil::ParserException & ex) {
-		delete [] nvArray;
-		buf	<< "error creating policy '"
-			<< name
-			<< "' in '"
-			<< m_policy_list_str
-			<< "': "
-			<< ex
-			<< endl;
-		throw corbautil::ParserException(buf);
-	} catch(const CORBA::Exception & ex) {
-		delete [] nvArray;
-		buf	<< "error creating policy '"
-			<< name
-			<< "' in '"
-			<< m_policy_list_str
-			<< "': "
-			<< ex
-			<< endl;
-		throw corbautil::ParserException(buf);
+		PolicyListParser	parser(CORBA::ORB::_nil());
+		parser.parse(policy_list_str, *parsed);
+	} catch(const ParserException &) {
+		delete parsed;
+		throw;
+	}
+	e = new Entry;
+	e->key    = key._retn();
+	e->parsed = parsed;
+	e->next   = m_buckets[index];
+	m_buckets[index] = e;
+	return parsed;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	normalise()
+//
+// Description:	Replace each run of separators (which the lexical
+//		analyser skips) with a single space, and remove leading
+//		and trailing separators. String literals are copied
+//		unchanged.
+//----------------------------------------------------------------------
+
+char *
+PolicyListCache::normalise(const char * str)
+{
+	char *			result;
+	CORBA::ULong		i;
+	CORBA::ULong		j;
+	CORBA::Boolean		in_parenthesis;
+	CORBA::Boolean		pending_space;
+	char			ch;
+
+	result = CORBA::string_alloc(strlen(str));
+	in_parenthesis = 0;
+	pending_space = 0;
+	j = 0;
+	for (i = 0; str[i] != '\0'; i++) {
+		ch = str[i];
+		if (isspace(ch) || ch == '+' || (ch == ',' && !in_parenthesis)) {
+			pending_space = (j > 0);
+			continue;
+		}
+		if (pending_space) {
+			result[j++] = ' ';
+			pending_space = 0;
+		}
+		if (ch == '\'') {
+			do {
+				result[j++] = str[i++];
+			} while (str[i] != '\0' && str[i] != '\'');
+			if (str[i] == '\0') {
+				break;
+			}
+			result[j++] = str[i];
+			continue;
+		}
+		if (ch == '(') {
+			in_parenthesis = 1;
+		} else if (ch == ')') {
+			in_parenthesis = 0;
+		}
+		result[j++] = ch;
 	}
+	result[j] = '\0';
+	return result;
+}
+
+
+
+
+
+unsigned long
+PolicyListCache::hash(const char * str)
+{
+	unsigned long		h;
+
+	h = 5381;
+	for (; *str != '\0'; str++) {
+		h = h * 33 + (unsigned char)*str;
+	}
+	return h;
 }
 
 
@@ -820,51 +1264,234 @@ PolicyListParser::processPolicy(
 
 
 //======================================================================
-// Static utility functions.
+// PolicyPool
 //======================================================================
 
 
 
 
 
-static const char * predefined_policy_names[] = {
-#if defined(P_USE_ORBIX)
-	"orbix.deliver",
-	"orbix.discard",
-	"orbix.hold",
-#if P_ORBIX_VERSION >= 61
-	"orbix.no_lease",
-#endif
+//--------
+// Releases a policy that is no longer needed. According to the CORBA
+// specification, you should destroy() a policy object when you are
+// finished with it. We do not do so with Orbix, to work around a bug
+// associated with the destruction of an Orbix-proprietary lease policy
+// object. As each distinct policy is created only once, the memory
+// that this leaks is bounded.
+//--------
+static void
+discardPolicy(CORBA::Policy_ptr policy)
+{
+#if !defined(P_USE_ORBIX)
+	try {
+		policy->destroy();
+	} catch(const CORBA::Exception &) {
+		// ignore
+	}
 #endif
-	"orb_ctrl_model",
-	"single_thread_model",
-	"transient",
-	"persistent",
-	"unique_id",
-	"multiple_id",
-	"user_id",
-	"system_id",
-	"implicit_activation",
-	"no_implicit_activation",
-	"retain",
-	"non_retain",
-	"use_active_object_map_only",
-	"use_default_servant",
-	"use_servant_manager"
-};
+	CORBA::release(policy);
+}
 
 
 
 
 
-static CORBA::Boolean
-isPredefinedPolicyName(const char * name)
+PolicyPool::PolicyPool()
 {
 	int			i;
 
-	for (i = 0; i < sizeof(predefined_policy_names)/sizeof(char*); i++) {
-		if (strcmp(name, predefined_policy_names[i]) == 0) {
-			return 1;
+	for (i = 0; i < numBuckets; i++) {
+		m_buckets[i] = 0;
+	}
+	m_size = 0;
+	m_mutex = new GSP_Mutex();
+}
+
+
+
+
+
+PolicyPool::~PolicyPool()
+{
+	int			i;
+	Entry *			e;
+	Entry *			next;
+
+	for (i = 0; i < numBuckets; i++) {
+		for (e = m_buckets[i]; e != 0; e = next) {
+			next = e->next;
+			discardPolicy(e->policy._retn());
+			delete e;
+		}
+	}
+	delete m_mutex;
+}
+
+
+
+
+
+CORBA::Policy_ptr
+PolicyPool::intern(
+	CORBA::ORB_ptr			orb,
+	PortableServer::POA_ptr		root,
+	PolicyFactory *			factory,
+	const char *			policyName,
+	NameValue *			nvArray,
+	int				nvArraySize)
+{
+	CORBA::String_var		key;
+	unsigned long			index;
+	Entry *				e;
+	CORBA::Policy_ptr		policy;
+
+	key = makeKey(policyName, nvArray, nvArraySize);
+	index = PolicyListCache::hash(key.in()) % numBuckets;
+
+	GSP_Mutex::Op			scopedLock(*m_mutex);
+
+	e = findEntry(key.in(), index);
+	if (e == 0) {
+		//--------
+		// Not found. Create it (this might throw an exception)
+		// and then insert it.
+		//--------
+		policy = factory->createWithRootPoa(orb, root, policyName,
+						    nvArray, nvArraySize);
+		e = addEntry(key._retn(), index, policy);
+	}
+	return CORBA::Policy::_duplicate(e->policy.in());
+}
+
+
+
+
+
+CORBA::Policy_ptr
+PolicyPool::find(
+	const char *			policyName,
+	NameValue *			nvArray,
+	int				nvArraySize)
+{
+	CORBA::String_var		key;
+	unsigned long			index;
+	Entry *				e;
+
+	key = makeKey(policyName, nvArray, nvArraySize);
+	index = PolicyListCache::hash(key.in()) % numBuckets;
+
+	GSP_Mutex::Op			scopedLock(*m_mutex);
+
+	e = findEntry(key.in(), index);
+	if (e == 0) {
+		return CORBA::Policy::_nil();
+	}
+	return CORBA::Policy::_duplicate(e->policy.in());
+}
+
+
+
+
+
+CORBA::Policy_ptr
+PolicyPool::add(
+	const char *			policyName,
+	NameValue *			nvArray,
+	int				nvArraySize,
+	CORBA::Policy_ptr		policy)
+{
+	CORBA::String_var		key;
+	unsigned long			index;
+	Entry *				e;
+
+	key = makeKey(policyName, nvArray, nvArraySize);
+	index = PolicyListCache::hash(key.in()) % numBuckets;
+
+	GSP_Mutex::Op			scopedLock(*m_mutex);
+
+	e = findEntry(key.in(), index);
+	if (e == 0) {
+		e = addEntry(key._retn(), index, policy);
+	} else {
+		discardPolicy(policy);
+	}
+	return CORBA::Policy::_duplicate(e->policy.in());
+}
+
+
+
+
+
+CORBA::ULong
+PolicyPool::size()
+{
+	GSP_Mutex::Op			scopedLock(*m_mutex);
+
+	return m_size;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	makeKey()
+//
+// Description:	Each string in the key is preceded by its length, so
+//		that different (name, parameters) tuples cannot have the
+//		same key, whatever characters the strings contain. For
+//		example, ("p", [("", "a b")]) has the key "1:p0:3:a b".
+//----------------------------------------------------------------------
+
+char *
+PolicyPool::makeKey(
+	const char *			policyName,
+	NameValue *			nvArray,
+	int				nvArraySize)
+{
+	char *				result;
+	CORBA::ULong			len;
+	char *				p;
+	int				i;
+
+	//--------
+	// Each length prefix is at most 20 digits followed by ':'
+	//--------
+	len = strlen(policyName) + 21;
+	for (i = 0; i < nvArraySize; i++) {
+		len += strlen(nvArray[i].name.in()) + 21;
+		len += strlen(nvArray[i].value.in()) + 21;
+	}
+	result = CORBA::string_alloc(len);
+	p = result;
+	p += sprintf(p, "%lu:%s", (unsigned long)strlen(policyName),
+		     policyName);
+	for (i = 0; i < nvArraySize; i++) {
+		p += sprintf(p, "%lu:%s",
+			     (unsigned long)strlen(nvArray[i].name.in()),
+			     nvArray[i].name.in());
+		p += sprintf(p, "%lu:%s",
+			     (unsigned long)strlen(nvArray[i].value.in()),
+			     nvArray[i].value.in());
+	}
+	return result;
+}
+
+
+
+
+
+//--------
+// The caller must hold m_mutex
+//--------
+PolicyPool::Entry *
+PolicyPool::findEntry(const char * key, unsigned long index)
+{
+	Entry *				e;
+
+	for (e = m_buckets[index]; e != 0; e = e->next) {
+		if (strcmp(e->key.in(), key) == 0) {
+			return e;
 		}
 	}
 	return 0;
@@ -874,4 +1501,28 @@ isPredefinedPolicyName(const char * name)
 
 
 
+//--------
+// The caller must hold m_mutex. Takes ownership of "key" and "policy".
+//--------
+PolicyPool::Entry *
+PolicyPool::addEntry(
+	char *				key,
+	unsigned long			index,
+	CORBA::Policy_ptr		policy)
+{
+	Entry *				e;
+
+	e = new Entry;
+	e->key    = key;
+	e->policy = policy;
+	e->next   = m_buckets[index];
+	m_buckets[index] = e;
+	m_size ++;
+	return e;
+}
+
+
+
+
+
 }; // namespace corbautil
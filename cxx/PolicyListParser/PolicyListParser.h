@@ -21,6 +21,17 @@
 #include "p_poa.h"
 #include "p_strstream.h"
 #include "p_iostream.h"
+#include <string.h>
+
+
+
+
+
+//--------
+// The mutexes are allocated in PolicyListParser.cxx, so that users of
+// this header do not need the GSP headers.
+//--------
+class GSP_Mutex;
 
 
 
@@ -68,41 +79,45 @@ namespace corbautil
 	//--------------------------------------------------------------
 	// Class:	Token
 	//
-	// Descritpion:	Tokens created by the lexical analyser.
+	// Descritpion:	Tokens created by the lexical analyser. A token
+	//		does not own its spelling: it is the "length()"
+	//		characters starting at "start()", which usually
+	//		point into the string being analysed, and it is
+	//		not nul-terminated. dupSpelling() returns a copy
+	//		that must be freed with CORBA::string_free().
 	//--------------------------------------------------------------
 	class Token {
 	public:
 		//--------
-		// Constructors, destructor and assignment operator
+		// Constructor
 		//--------
 		inline Token(
 			TokenKind	kind = t_EOS,
-			const char *	spelling = "");
-		inline Token(const Token & other);
-		inline ~Token();
-
-		//--------
-		// Assignment operator
-		//--------
-		inline Token & operator=(const Token & other);
+			const char *	start = "",
+			CORBA::ULong	length = 0);
 
 		//--------
 		// Accessor and modifier operations
 		//--------
-		inline void reset(TokenKind kind, const char * spelling);
+		inline void reset(
+			TokenKind	kind,
+			const char *	start,
+			CORBA::ULong	length);
 
 		inline TokenKind     kind() const;
 		inline void          kind(TokenKind spelling);
 
-		inline const char *  spelling() const;
-		inline void          spelling(const char * spelling);
+		inline const char *  start() const;
+		inline CORBA::ULong  length() const;
+		inline char *        dupSpelling() const;
 
 	private:
 		//--------
 		// Instance variables
 		//--------
 		TokenKind		m_kind;
-		CORBA::String_var	m_spelling;
+		const char *		m_start;
+		CORBA::ULong		m_length;
 	};
 
 
@@ -112,7 +127,9 @@ namespace corbautil
 	//--------------------------------------------------------------
 	// Class:	LexicalAnalyser
 	//
-	// Descritpion:	Lexical analyser used by PolicyListParser.
+	// Descritpion:	Lexical analyser used by PolicyListParser. It
+	//		does not copy the string it analyses, so the string
+	//		must outlive the lexical analyser and its tokens.
 	//--------------------------------------------------------------
 	class LexicalAnalyser
 	{
@@ -131,7 +148,7 @@ namespace corbautil
 		//--------
 		// Instance variables
 		//--------
-		CORBA::String_var	m_str;
+		const char *		m_str;
 		CORBA::ULong		m_i;
 		CORBA::ULong		m_len;
 		CORBA::Boolean		m_in_parenthesis;
@@ -161,6 +178,61 @@ namespace corbautil
 
 
 
+	//--------------------------------------------------------------
+	// Class:	ParsedPolicyList
+	//
+	// Descritpion:	The result of parsing a stringified list of
+	//		policies, before any Policy objects are created:
+	//		the name and parameters of each policy.
+	//--------------------------------------------------------------
+	class ParsedPolicyList {
+	public:
+		ParsedPolicyList();
+		~ParsedPolicyList();
+
+		int		numPolicies() const { return m_len; }
+		const char *	policyName(int i) const
+					{ return m_entries[i].name.in(); }
+		NameValue *	params(int i) const
+					{ return m_entries[i].nvArray; }
+		int		numParams(int i) const
+					{ return m_entries[i].nvArraySize; }
+		CORBA::Boolean	hasPersistentPolicy() const
+					{ return m_has_persistent_policy; }
+
+		//--------
+		// Takes ownership of "policyName", which must have been
+		// allocated with CORBA::string_alloc(), and of "nvArray",
+		// which must have been allocated with new[].
+		//--------
+		void		add(
+					char *		policyName,
+					NameValue *	nvArray,
+					int		nvArraySize);
+
+	private:
+		struct Entry {
+			CORBA::String_var	name;
+			NameValue *		nvArray;
+			int			nvArraySize;
+		};
+
+		Entry *			m_entries;
+		int			m_len;
+		int			m_max;
+		CORBA::Boolean		m_has_persistent_policy;
+
+		//--------
+		// The following are not implemented
+		//--------
+		ParsedPolicyList(const ParsedPolicyList &);
+		ParsedPolicyList & operator = (const ParsedPolicyList &);
+	};
+
+
+
+
+
 	//--------------------------------------------------------------
 	// Class:	PolicyFactory
 	//
@@ -183,6 +255,18 @@ namespace corbautil
 				NameValue *	nvArray,
 				int		nvArraySize) = 0;
 
+		//--------
+		// As create(), for callers that already have the root
+		// POA of "orb". "root" may be nil. The default
+		// implementation ignores "root" and calls create().
+		//--------
+		virtual CORBA::Policy_ptr createWithRootPoa(
+				CORBA::ORB_ptr		orb,
+				PortableServer::POA_ptr	root,
+				const char *		policyName,
+				NameValue *		nvArray,
+				int			nvArraySize);
+
 		//--------
 		// Utility string-to-<type> conversion operations.
 		//--------
@@ -194,10 +278,16 @@ namespace corbautil
 					throw(ParserException);
 
 		//--------
-		// Utility function. Obtain root POA from the ORB
+		// Utility functions. Obtain root POA from the ORB. The
+		// second one returns (a duplicate of) "root" instead if
+		// it is not nil.
 		//--------
 		PortableServer::POA_ptr rootPoa(CORBA::ORB_ptr orb)
 					throw(ParserException);
+		PortableServer::POA_ptr rootPoa(
+					CORBA::ORB_ptr		orb,
+					PortableServer::POA_ptr	root)
+					throw(ParserException);
 	};
 
 
@@ -208,14 +298,17 @@ namespace corbautil
 	// Class:	PolicyFactoryList
 	//
 	// Descritpion:	Singly-linked list of
-	//		(policyName, PolicyFactory) tuples.
+	//		(policyName, PolicyFactory) tuples. For a
+	//		predefined policy, m_factory is 0 and m_predefined
+	//		identifies the policy.
 	//--------------------------------------------------------------
 	class PolicyFactoryList {
 	public:
 		PolicyFactoryList()
 		{
-			m_factory = 0;
-			m_next    = 0;
+			m_factory    = 0;
+			m_predefined = 0;
+			m_next       = 0;
 		}
 		~PolicyFactoryList()
 		{
@@ -223,6 +316,7 @@ namespace corbautil
 			delete m_factory;
 		}
 		PolicyFactory *		m_factory;
+		int			m_predefined;
 		CORBA::String_var	m_name;
 		PolicyFactoryList *	m_next;
 	};
@@ -234,7 +328,11 @@ namespace corbautil
 	//--------------------------------------------------------------
 	// Class:	ExtendablePolicyFactory
 	//
-	// Descritpion:	
+	// Descritpion:	Creates the predefined policies and the policies
+	//		of registered factories. Both are kept in one hash
+	//		table that is keyed by policy name, so the cost of
+	//		create() does not grow with the number of
+	//		registered factories.
 	//--------------------------------------------------------------
 	class ExtendablePolicyFactory : public PolicyFactory
 	{
@@ -243,13 +341,21 @@ namespace corbautil
 		virtual ~ExtendablePolicyFactory();
 
 		//--------
-		// This class re-implements the create() operation.
+		// This class re-implements the create() operations.
+		// The predefined policies are created by "root", or by
+		// the root POA of "orb" if "root" is nil.
 		//--------
 		virtual CORBA::Policy_ptr create(
 				CORBA::ORB_ptr			orb,
 				const char *			policyName,
 				NameValue *			nvArray,
 				int				nvArraySize);
+		virtual CORBA::Policy_ptr createWithRootPoa(
+				CORBA::ORB_ptr			orb,
+				PortableServer::POA_ptr		root,
+				const char *			policyName,
+				NameValue *			nvArray,
+				int				nvArraySize);
 
 		//--------
 		// Register a factory with us to extend our functionality.
@@ -259,10 +365,15 @@ namespace corbautil
 				corbautil::PolicyFactory *	factory);
 
 	private:
+		enum { numBuckets = 64 };
+
+		PolicyFactoryList *	lookup(const char * policyName);
+		void			insert(PolicyFactoryList * entry);
+
 		//--------
 		// Instance variables.
 		//--------
-		PolicyFactoryList	m_head;
+		PolicyFactoryList *	m_buckets[numBuckets];
 
 		//--------
 		// The following are not implemented.
@@ -285,6 +396,12 @@ namespace corbautil
 
 
 
+	class PolicyPool;
+
+
+
+
+
 	//--------------------------------------------------------------
 	// Class:	PolicyListParser
 	//
@@ -294,31 +411,50 @@ namespace corbautil
 	{
 	public:
 		//--------
-		// Constructor and destructor
+		// Constructor and destructor. If "pool" is not null then
+		// the policies are obtained from it instead of being
+		// created each time. If "root" is not nil then it is
+		// passed to factory->createWithRootPoa(), so that the
+		// predefined policies are created without looking up
+		// the root POA of "orb".
 		//--------
 		PolicyListParser(
-			CORBA::ORB_ptr	orb,
-			PolicyFactory *	factory = & defaultPolicyFactory);
+			CORBA::ORB_ptr		orb,
+			PolicyFactory *		factory = & defaultPolicyFactory,
+			PolicyPool *		pool = 0,
+			PortableServer::POA_ptr	root =
+						PortableServer::POA::_nil());
 		~PolicyListParser() { }
 
+		//--------
+		// Parses the string (or finds the result of parsing an
+		// equivalent string in defaultPolicyListCache) and then
+		// creates the policies.
+		//--------
 		CORBA::PolicyList *	parsePolicyList(
 						const char * policy_list_str);
 
+		//--------
+		// The two steps of parsePolicyList(). parse() does not
+		// use the ORB or the factory.
+		//--------
+		void			parse(
+						const char *	    policy_list_str,
+						ParsedPolicyList &  result);
+		CORBA::PolicyList *	createPolicyList(
+						const char *	    policy_list_str,
+						const ParsedPolicyList & parsed);
+
 	private:
 		//--------
 		// Helper operations.
 		//--------
-		void parsePolicy();
+		void parsePolicy(ParsedPolicyList & result);
 
 		void parsePolicyParam(
-			CORBA::StringSeq &	paramNameSeq,
-			CORBA::StringSeq &	paramValueSeq,
-			CORBA::ULong &		paramCount);
-
-		void processPolicy(
-			const char *			policyName,
-			const CORBA::StringSeq &	paramNameSeq,
-			const CORBA::StringSeq &	paramValueSeq);
+			NameValue *&		nvArray,
+			int &			nvArraySize,
+			int &			nvArrayMax);
 
 		void accept(TokenKind expectedKind, const char * errMsg);
 	private:
@@ -328,9 +464,10 @@ namespace corbautil
 		LexicalAnalyser		m_lex;
 		Token			m_token;
 		const char *		m_policy_list_str;
-		CORBA::PolicyList	m_seq;
 		CORBA::ORB_ptr		m_orb;
 		PolicyFactory *		m_factory;
+		PolicyPool *		m_pool;
+		PortableServer::POA_var	m_root;
 
 		//--------
 		// The following are not implemented
@@ -344,38 +481,190 @@ namespace corbautil
 
 
 	//--------------------------------------------------------------
-	// Start of inline implementation for the Token class
+	// Class:	PolicyListCache
+	//
+	// Descritpion:	A thread-safe cache of ParsedPolicyList objects,
+	//		keyed by a normalised version of the policy list
+	//		string, so that a string is lexed and parsed only
+	//		once. The normalised string differs from the
+	//		original only in its separators (whitespace, '+'
+	//		and commas outside of parameter lists), so
+	//		strings with the same normalised version have the
+	//		same tokens. Entries are never removed, so the
+	//		pointers returned by lookup() remain valid for
+	//		the lifetime of the cache.
 	//--------------------------------------------------------------
-	inline Token::Token(TokenKind kind, const char * spelling)
+	class PolicyListCache
 	{
-		m_kind = kind;
-		m_spelling = CORBA::string_dup(spelling);
-	}
-	inline Token::Token(const Token & other)
+	public:
+		PolicyListCache();
+		~PolicyListCache();
+
+		//--------
+		// Parses "policy_list_str" if it is not already in the
+		// cache. Strings that fail to parse are not cached.
+		//--------
+		const ParsedPolicyList *	lookup(
+						const char * policy_list_str);
+
+		static char *	normalise(const char * policy_list_str);
+
+		static unsigned long	hash(const char * str);
+
+	private:
+		enum { numBuckets = 256 };
+
+		struct Entry {
+			CORBA::String_var	key;
+			ParsedPolicyList *	parsed;
+			Entry *			next;
+		};
+
+		Entry *			m_buckets[numBuckets];
+		GSP_Mutex *		m_mutex;
+
+		//--------
+		// The following are not implemented
+		//--------
+		PolicyListCache(const PolicyListCache &);
+		PolicyListCache & operator = (const PolicyListCache &);
+	};
+
+
+
+
+
+	//--------------------------------------------------------------
+	// Singleton cache object.
+	//--------------------------------------------------------------
+	extern PolicyListCache defaultPolicyListCache;
+
+
+
+
+
+	//--------------------------------------------------------------
+	// Class:	PolicyPool
+	//
+	// Descritpion:	A thread-safe pool of Policy objects, keyed by
+	//		policy name and parameters, so that POAs created
+	//		with the same policies share Policy objects instead
+	//		of each creating their own. The operations return a
+	//		new reference, which the caller releases as usual
+	//		but must not destroy(). The pool destroy()s the
+	//		policies when it is destroyed (except with Orbix;
+	//		see PoaUtility::createPoa()). A pool must be used
+	//		with only one ORB and one PolicyFactory.
+	//--------------------------------------------------------------
+	class PolicyPool
 	{
-		m_kind = other.m_kind;
-		m_spelling = CORBA::string_dup(other.m_spelling);
-	}
-	inline Token::~Token() { }
+	public:
+		PolicyPool();
+		~PolicyPool();
+
+		//--------
+		// Returns the pooled policy, first creating it with
+		// factory->createWithRootPoa() if it is not in the pool.
+		//--------
+		CORBA::Policy_ptr	intern(
+						CORBA::ORB_ptr	orb,
+						PortableServer::POA_ptr root,
+						PolicyFactory *	factory,
+						const char *	policyName,
+						NameValue *	nvArray,
+						int		nvArraySize);
+
+		//--------
+		// For policies that are not created by a PolicyFactory.
+		// find() returns nil if the policy is not in the pool.
+		// add() takes ownership of "policy" and returns the
+		// pooled policy, which is a different one if another
+		// thread has added the same policy in the meantime.
+		//--------
+		CORBA::Policy_ptr	find(
+						const char *	policyName,
+						NameValue *	nvArray,
+						int		nvArraySize);
+		CORBA::Policy_ptr	add(
+						const char *	policyName,
+						NameValue *	nvArray,
+						int		nvArraySize,
+						CORBA::Policy_ptr policy);
+
+		CORBA::ULong		size();
+
+	private:
+		enum { numBuckets = 64 };
+
+		struct Entry {
+			CORBA::String_var	key;
+			CORBA::Policy_var	policy;
+			Entry *			next;
+		};
+
+		static char *		makeKey(
+						const char *	policyName,
+						NameValue *	nvArray,
+						int		nvArraySize);
+		Entry *			findEntry(
+						const char *	key,
+						unsigned long	index);
+		Entry *			addEntry(
+						char *		key,
+						unsigned long	index,
+						CORBA::Policy_ptr policy);
+
+		Entry *			m_buckets[numBuckets];
+		CORBA::ULong		m_size;
+		GSP_Mutex *		m_mutex;
+
+		//--------
+		// The following are not implemented
+		//--------
+		PolicyPool(const PolicyPool &);
+		PolicyPool & operator = (const PolicyPool &);
+	};
+
+
+
 
-	inline Token & Token::operator=(const Token & other)
+
+	//--------------------------------------------------------------
+	// Start of inline implementation for the Token class
+	//--------------------------------------------------------------
+	inline Token::Token(
+		TokenKind	kind,
+		const char *	start,
+		CORBA::ULong	length)
 	{
-		m_kind = other.m_kind;
-		m_spelling = CORBA::string_dup(other.m_spelling);
-		return *this;
+		m_kind   = kind;
+		m_start  = start;
+		m_length = length;
 	}
 
-	inline void Token::reset(TokenKind kind, const char * spelling)
+	inline void Token::reset(
+		TokenKind	kind,
+		const char *	start,
+		CORBA::ULong	length)
 	{
-		m_kind = kind;
-		m_spelling = CORBA::string_dup(spelling);
+		m_kind   = kind;
+		m_start  = start;
+		m_length = length;
 	}
 	inline TokenKind Token::kind() const         { return m_kind; }
 	inline void      Token::kind(TokenKind kind) { m_kind = kind; }
 
-	inline const char * Token::spelling() const  { return m_spelling.in(); }
-	inline void         Token::spelling(const char * spelling)
-	                    { m_spelling = CORBA::string_dup(spelling); }
+	inline const char *  Token::start() const    { return m_start; }
+	inline CORBA::ULong  Token::length() const   { return m_length; }
+	inline char *        Token::dupSpelling() const
+	{
+		char *		result;
+
+		result = CORBA::string_alloc(m_length);
+		strncpy(result, m_start, m_length);
+		result[m_length] = '\0';
+		return result;
+	}
 	//--------------------------------------------------------------
 	// End of inline implementation for the Token class
 	//--------------------------------------------------------------
@@ -0,0 +1,219 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	bench.cxx
+//
+// Description:	Benchmark for the lexical analyser and parser of policy
+//		lists. For each sample policy list it measures three
+//		passes and prints the number of heap allocations and
+//		the time per policy list:
+//
+//		lex	LexicalAnalyser::nextToken() until end of string
+//		parse	PolicyListParser::parse() into a ParsedPolicyList
+//		cached	PolicyListCache::lookup() of a string that is
+//			already in the cache
+//
+//		Allocations are counted by replacing the global
+//		operator new and operator new[], so allocations that
+//		an ORB makes with malloc() are not counted. No policies
+//		are created, so the ORB is not initialised.
+//
+//		Usage: bench [-n iterations]
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "PolicyListParser.h"
+#include "gsp_timeout.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+
+
+
+
+
+//--------
+// Count the allocations made by the code being measured
+//--------
+static unsigned long	allocCount = 0;
+
+
+
+void *
+operator new(size_t size) throw(std::bad_alloc)
+{
+	void *			ptr;
+
+	allocCount ++;
+	ptr = malloc(size == 0 ? 1 : size);
+	if (ptr == 0) {
+		throw std::bad_alloc();
+	}
+	return ptr;
+}
+
+
+
+void *
+operator new[](size_t size) throw(std::bad_alloc)
+{
+	return operator new(size);
+}
+
+
+
+void
+operator delete(void * ptr) throw()
+{
+	free(ptr);
+}
+
+
+
+void
+operator delete[](void * ptr) throw()
+{
+	free(ptr);
+}
+
+
+
+
+
+//--------
+// Sample policy lists, from the simplest to one with parameters
+//--------
+static const char *	samples[] = {
+	"persistent",
+	"persistent user_id retain use_active_object_map_only",
+	"single_thread_model + transient, system_id no_implicit_activation",
+	"persistent user_id orbix.deliver my_policy(a, b=1, c='x y', d=2.5)",
+	0
+};
+
+
+
+
+
+static void
+report(
+	const char *		pass,
+	const char *		str,
+	int			iterations,
+	unsigned long		allocs,
+	double			usecs)
+{
+	printf("%-6s  %8.2f  %10.1f  %s\n",
+		pass,
+		(double)allocs / iterations,
+		usecs * 1000.0 / iterations,
+		str);
+}
+
+
+
+static void
+benchLex(const char * str, int iterations)
+{
+	corbautil::LexicalAnalyser	lex;
+	corbautil::Token		tok;
+	unsigned long			allocs;
+	double				start;
+	int				i;
+
+	allocs = allocCount;
+	start = gsp_now_usecs();
+	for (i = 0; i < iterations; i++) {
+		lex.reset(str);
+		do {
+			lex.nextToken(tok);
+		} while (tok.kind() != corbautil::t_EOS);
+	}
+	report("lex", str, iterations, allocCount - allocs,
+	       gsp_now_usecs() - start);
+}
+
+
+
+static void
+benchParse(const char * str, int iterations)
+{
+	corbautil::PolicyListParser	parser(CORBA::ORB::_nil());
+	unsigned long			allocs;
+	double				start;
+	int				i;
+
+	allocs = allocCount;
+	start = gsp_now_usecs();
+	for (i = 0; i < iterations; i++) {
+		corbautil::ParsedPolicyList	parsed;
+
+		parser.parse(str, parsed);
+	}
+	report("parse", str, iterations, allocCount - allocs,
+	       gsp_now_usecs() - start);
+}
+
+
+
+static void
+benchCached(const char * str, int iterations)
+{
+	corbautil::PolicyListCache	cache;
+	unsigned long			allocs;
+	double				start;
+	int				i;
+
+	cache.lookup(str);
+	allocs = allocCount;
+	start = gsp_now_usecs();
+	for (i = 0; i < iterations; i++) {
+		cache.lookup(str);
+	}
+	report("cached", str, iterations, allocCount - allocs,
+	       gsp_now_usecs() - start);
+}
+
+
+
+
+
+int
+main(int argc, char ** argv)
+{
+	int			iterations;
+	int			i;
+
+	iterations = 100000;
+	if (argc == 3 && strcmp(argv[1], "-n") == 0) {
+		iterations = atoi(argv[2]);
+	} else if (argc != 1) {
+		fprintf(stderr, "usage: %s [-n iterations]\n", argv[0]);
+		return 1;
+	}
+	if (iterations <= 0) {
+		iterations = 1;
+	}
+
+	try {
+		printf("%-6s  %8s  %10s  %s\n",
+			"pass", "allocs", "ns", "policy list");
+		for (i = 0; samples[i] != 0; i++) {
+			benchLex(samples[i], iterations);
+			benchParse(samples[i], iterations);
+			benchCached(samples[i], iterations);
+		}
+	} catch(const corbautil::ParserException & ex) {
+		fprintf(stderr, "%s\n", ex.msg.in());
+		return 1;
+	}
+	return 0;
+}
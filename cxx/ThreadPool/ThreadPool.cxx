@@ -0,0 +1,553 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ThreadPool.cxx
+//
+// Description: A pool of worker threads with per-worker Chase-Lev
+//		deques and work stealing
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "ThreadPool.h"
+#include <assert.h>
+
+
+
+
+
+namespace corbautil
+{
+
+//--------
+// Initial number of slots in a WorkStealingDeque. It must be a power of 2.
+//--------
+static const long	initialDequeSize = 64;
+
+
+
+
+
+//--------
+// Implementation of class WorkStealingDeque. The algorithm is
+// that of "Dynamic Circular Work-Stealing Deque" by Chase and Lev, with
+// the memory barriers of "Correct and Efficient Work-Stealing for Weak
+// Memory Models" by Le, Pop, Cohen and Zappa Nardelli.
+//--------
+
+WorkStealingDeque::WorkStealingDeque()
+{
+	Array *			a;
+
+	a = new Array;
+	a->m_size  = initialDequeSize;
+	a->m_slots = new ThreadPoolTask * volatile[initialDequeSize];
+	a->m_prev  = 0;
+
+	m_top    = 0;
+	m_bottom = 0;
+	m_array  = a;
+}
+
+
+
+WorkStealingDeque::~WorkStealingDeque()
+{
+	Array *			a;
+	Array *			prev;
+
+	assert(m_top == m_bottom);
+	for (a = m_array; a != 0; a = prev) {
+		prev = a->m_prev;
+		delete [] a->m_slots;
+		delete a;
+	}
+}
+
+
+
+WorkStealingDeque::Array *
+WorkStealingDeque::grow(Array * a, long top, long bottom)
+{
+	Array *			bigger;
+	long			i;
+
+	bigger = new Array;
+	bigger->m_size  = a->m_size * 2;
+	bigger->m_slots = new ThreadPoolTask * volatile[bigger->m_size];
+	bigger->m_prev  = a;
+	for (i = top; i < bottom; i++) {
+		bigger->m_slots[i & (bigger->m_size - 1)] =
+					a->m_slots[i & (a->m_size - 1)];
+	}
+	gsp_atomic_store(&m_array, bigger);
+	return bigger;
+}
+
+
+
+void
+WorkStealingDeque::push(ThreadPoolTask * task)
+{
+	long			bottom;
+	long			top;
+	Array *			a;
+
+	bottom = m_bottom;
+	top    = gsp_atomic_load(&m_top);
+	a      = m_array;
+	if (bottom - top > a->m_size - 1) {
+		a = grow(a, top, bottom);
+	}
+	gsp_atomic_store(&a->m_slots[bottom & (a->m_size - 1)], task);
+	gsp_atomic_store(&m_bottom, bottom + 1);
+}
+
+
+
+ThreadPoolTask *
+WorkStealingDeque::take()
+{
+	long			bottom;
+	long			top;
+	Array *			a;
+	ThreadPoolTask *	task;
+
+	bottom = m_bottom - 1;
+	a      = m_array;
+	gsp_atomic_store(&m_bottom, bottom);
+	gsp_memory_barrier();
+	top = gsp_atomic_load(&m_top);
+
+	if (top > bottom) {
+		//--------
+		// The deque is empty
+		//--------
+		gsp_atomic_store(&m_bottom, bottom + 1);
+		return 0;
+	}
+
+	task = a->m_slots[bottom & (a->m_size - 1)];
+	if (top == bottom) {
+		//--------
+		// This is the last task, so race with thieves for it
+		//--------
+		if (!gsp_atomic_cas(&m_top, top, top + 1)) {
+			task = 0;
+		}
+		gsp_atomic_store(&m_bottom, bottom + 1);
+	}
+	return task;
+}
+
+
+
+ThreadPoolTask *
+WorkStealingDeque::steal()
+{
+	long			bottom;
+	long			top;
+	Array *			a;
+	ThreadPoolTask *	task;
+
+	for (;;) {
+		top = gsp_atomic_load(&m_top);
+		gsp_memory_barrier();
+		bottom = gsp_atomic_load(&m_bottom);
+		if (top >= bottom) {
+			return 0;
+		}
+		a    = gsp_atomic_load(&m_array);
+		task = gsp_atomic_load(&a->m_slots[top & (a->m_size - 1)]);
+		if (gsp_atomic_cas(&m_top, top, top + 1)) {
+			return task;
+		}
+		//--------
+		// We lost a race with another thief or with the owner
+		//--------
+		gsp_cpu_relax();
+	}
+}
+
+
+
+bool
+WorkStealingDeque::isEmpty()
+{
+	long			top;
+	long			bottom;
+
+	top    = gsp_atomic_load(&m_top);
+	bottom = gsp_atomic_load(&m_bottom);
+	return top >= bottom;
+}
+
+
+
+
+
+//--------
+// Implementation of class ThreadPool
+//--------
+
+ThreadPool::ThreadPool(int num_threads, const p_thread_attr * attr)
+{
+	int			i;
+	Worker *		w;
+	P_THREAD_ID_TYPE *	thread_ids;
+
+	assert(num_threads > 0);
+	m_num_threads  = num_threads;
+	m_pending      = 0;
+	m_stopping     = 0;
+	m_inject_head  = 0;
+	m_inject_tail  = 0;
+	m_inject_count = 0;
+	m_sleepers     = 0;
+	m_done_waiters = 0;
+
+#if defined(WIN32)
+	m_tls_key = TlsAlloc();
+	assert(m_tls_key != TLS_OUT_OF_INDEXES);
+#else
+	int			status;
+
+	status = pthread_key_create(&m_tls_key, 0);
+	assert(status == 0);
+#endif
+
+	//--------
+	// Create all the workers before starting any of their threads,
+	// because a worker may steal from any other worker.
+	//--------
+	m_workers = new Worker *[m_num_threads];
+	for (i = 0; i < m_num_threads; i++) {
+		w = new Worker;
+		w->m_pool  = this;
+		w->m_index = i;
+		w->m_seed  = 2 * i + 1;
+		m_workers[i] = w;
+	}
+	thread_ids = new P_THREAD_ID_TYPE[m_num_threads];
+	create_joinable_threads(m_num_threads, workerMain, (void **)m_workers,
+				thread_ids, attr);
+	for (i = 0; i < m_num_threads; i++) {
+		m_workers[i]->m_thread_id = thread_ids[i];
+	}
+	delete [] thread_ids;
+}
+
+
+
+ThreadPool::~ThreadPool()
+{
+	int			i;
+
+	wait_all();
+
+	gsp_atomic_store(&m_stopping, 1L);
+	gsp_memory_barrier();
+	wakeAll(m_sleepers, m_wakeup);
+	for (i = 0; i < m_num_threads; i++) {
+		join_with_thread(m_workers[i]->m_thread_id);
+	}
+	for (i = 0; i < m_num_threads; i++) {
+		delete m_workers[i];
+	}
+	delete [] m_workers;
+
+#if defined(WIN32)
+	TlsFree(m_tls_key);
+#else
+	pthread_key_delete(m_tls_key);
+#endif
+}
+
+
+
+void
+ThreadPool::submit(ThreadPoolTask * task)
+{
+	Worker *		self;
+
+	assert(task != 0);
+	assert(!m_stopping);
+	gsp_atomic_fetch_add(&m_pending, 1L);
+
+	self = currentWorker();
+	if (self != 0) {
+		self->m_deque.push(task);
+	} else {
+		GSP_Mutex::Op		scopedLock(m_inject_mutex);
+
+		task->m_next = 0;
+		if (m_inject_tail == 0) {
+			m_inject_head = task;
+		} else {
+			m_inject_tail->m_next = task;
+		}
+		m_inject_tail = task;
+		gsp_atomic_store(&m_inject_count, m_inject_count + 1);
+	}
+	wakeOne();
+}
+
+
+
+void
+ThreadPool::wait_all()
+{
+	ThreadPoolTask *	task;
+
+	assert(currentWorker() == 0);
+	while (gsp_atomic_load(&m_pending) > 0) {
+		task = findTask(0);
+		if (task != 0) {
+			runTask(task);
+			continue;
+		}
+		gsp_atomic_fetch_add(&m_done_waiters, 1L);
+		gsp_memory_barrier();
+		if (gsp_atomic_load(&m_pending) == 0) {
+			cancelWait(m_done_waiters, m_done);
+			break;
+		}
+		GSP_ProdCons::GetOp	scopedLock(m_done);
+	}
+}
+
+
+
+void *
+ThreadPool::workerMain(void * arg)
+{
+	Worker *		self = (Worker *)arg;
+
+	self->m_pool->workerLoop(self);
+	return 0;
+}
+
+
+
+void
+ThreadPool::workerLoop(Worker * self)
+{
+	ThreadPoolTask *	task;
+
+#if defined(WIN32)
+	TlsSetValue(m_tls_key, self);
+#else
+	pthread_setspecific(m_tls_key, self);
+#endif
+
+	for (;;) {
+		task = findTask(self);
+		if (task != 0) {
+			runTask(task);
+			continue;
+		}
+		if (gsp_atomic_load(&m_stopping)) {
+			break;
+		}
+
+		//--------
+		// Register as a sleeper and then check again for work, so
+		// that a concurrent submit() either sees us as a sleeper
+		// or we see its task. There is no need to cancel the
+		// registration if the pool is stopping.
+		//--------
+		gsp_atomic_fetch_add(&m_sleepers, 1L);
+		gsp_memory_barrier();
+		if (gsp_atomic_load(&m_stopping)) {
+			break;
+		}
+		if (hasWork()) {
+			cancelWait(m_sleepers, m_wakeup);
+			continue;
+		}
+		GSP_ProdCons::GetOp	scopedLock(m_wakeup);
+	}
+}
+
+
+
+ThreadPool::Worker *
+ThreadPool::currentWorker()
+{
+#if defined(WIN32)
+	return (Worker *)TlsGetValue(m_tls_key);
+#else
+	return (Worker *)pthread_getspecific(m_tls_key);
+#endif
+}
+
+
+
+ThreadPoolTask *
+ThreadPool::findTask(Worker * self)
+{
+	ThreadPoolTask *	task;
+	int			start;
+	int			i;
+	Worker *		victim;
+
+	if (self != 0) {
+		task = self->m_deque.take();
+		if (task != 0) {
+			return task;
+		}
+	}
+	task = takeInjected();
+	if (task != 0) {
+		return task;
+	}
+
+	//--------
+	// Steal from the other workers, starting at a random one
+	//--------
+	if (self != 0) {
+		self->m_seed = self->m_seed * 1103515245 + 12345;
+		start = (int)((self->m_seed >> 16) % m_num_threads);
+	} else {
+		start = 0;
+	}
+	for (i = 0; i < m_num_threads; i++) {
+		victim = m_workers[(start + i) % m_num_threads];
+		if (victim == self) {
+			continue;
+		}
+		task = victim->m_deque.steal();
+		if (task != 0) {
+			return task;
+		}
+	}
+	return 0;
+}
+
+
+
+ThreadPoolTask *
+ThreadPool::takeInjected()
+{
+	ThreadPoolTask *	task;
+
+	if (gsp_atomic_load(&m_inject_count) == 0) {
+		return 0;
+	}
+
+	GSP_Mutex::Op		scopedLock(m_inject_mutex);
+
+	task = m_inject_head;
+	if (task != 0) {
+		m_inject_head = task->m_next;
+		if (m_inject_head == 0) {
+			m_inject_tail = 0;
+		}
+		gsp_atomic_store(&m_inject_count, m_inject_count - 1);
+	}
+	return task;
+}
+
+
+
+bool
+ThreadPool::hasWork()
+{
+	int			i;
+
+	if (gsp_atomic_load(&m_inject_count) > 0) {
+		return true;
+	}
+	for (i = 0; i < m_num_threads; i++) {
+		if (!m_workers[i]->m_deque.isEmpty()) {
+			return true;
+		}
+	}
+	return false;
+}
+
+
+
+void
+ThreadPool::runTask(ThreadPoolTask * task)
+{
+	try {
+		task->run();
+	} catch (...) {
+		//--------
+		// Discard it so that wait_all() does not hang.
+		//--------
+	}
+	delete task;
+
+	if (gsp_atomic_fetch_add(&m_pending, -1L) == 1) {
+		wakeAll(m_done_waiters, m_done);
+	}
+}
+
+
+
+void
+ThreadPool::wakeOne()
+{
+	long			count;
+
+	gsp_memory_barrier();
+	for (;;) {
+		count = gsp_atomic_load(&m_sleepers);
+		if (count == 0) {
+			return;
+		}
+		if (gsp_atomic_cas(&m_sleepers, count, count - 1)) {
+			GSP_ProdCons::PutOp	scopedLock(m_wakeup);
+			return;
+		}
+	}
+}
+
+
+
+void
+ThreadPool::wakeAll(volatile long & count, GSP_ProdCons & sync)
+{
+	long			n;
+
+	n = gsp_atomic_exchange(&count, 0L);
+	if (n > 0) {
+		GSP_ProdCons::PutBatchOp	scopedLock(sync, n);
+	}
+}
+
+
+
+//--------
+// Undo a registration in "count". If a waker has already claimed the
+// registration then it has put, or is about to put, a token into
+// "sync", so we must take that token to keep the two in step.
+//--------
+void
+ThreadPool::cancelWait(volatile long & count, GSP_ProdCons & sync)
+{
+	long			n;
+
+	for (;;) {
+		n = gsp_atomic_load(&count);
+		if (n == 0) {
+			GSP_ProdCons::GetOp	scopedLock(sync);
+			return;
+		}
+		if (gsp_atomic_cas(&count, n, n - 1)) {
+			return;
+		}
+	}
+}
+
+
+
+}; // namespace corbautil
@@ -0,0 +1,186 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ThreadPool.h
+//
+// Description: A pool of worker threads that execute ThreadPoolTask
+//		objects. Each worker has its own Chase-Lev deque: a task
+//		submitted by a running task goes onto the deque of the
+//		worker running it, and idle workers steal tasks from the
+//		deques of other workers. Tasks submitted by other
+//		threads, such as the threads of an ORB, go onto a
+//		shared injection queue.
+//----------------------------------------------------------------------
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "p_create_joinable_thread.h"
+#include "gsp_mutex.h"
+#include "gsp_atomic.h"
+#if defined(WIN32)
+#	define P_TLS_KEY_TYPE	DWORD
+#else
+#	include <pthread.h>
+#	define P_TLS_KEY_TYPE	pthread_key_t
+#endif
+
+
+
+namespace corbautil
+{
+	//--------
+	// Base class for tasks. The pool deletes a task after its run()
+	// operation returns. run() should not throw an exception; if it
+	// does then the exception is discarded.
+	//--------
+	class ThreadPoolTask {
+	public:
+		ThreadPoolTask() : m_next(0) { }
+		virtual ~ThreadPoolTask() { }
+		virtual void run() = 0;
+
+	private:
+		ThreadPoolTask *	m_next;	// link in the injection queue
+		friend class ThreadPool;
+	};
+
+
+	//--------
+	// A Chase-Lev work-stealing deque. Only the owning thread may
+	// call push() and take(), which operate on the bottom of the
+	// deque; any thread may call steal(), which removes a task from
+	// the top. The deque grows when it is full; the arrays it has
+	// outgrown are kept until it is destroyed, because a concurrent
+	// steal() may still be reading one of them.
+	//--------
+	class WorkStealingDeque {
+	public:
+		WorkStealingDeque();
+		~WorkStealingDeque();
+
+		void			push(ThreadPoolTask * task);
+		ThreadPoolTask *	take();
+		ThreadPoolTask *	steal();
+		bool			isEmpty();
+
+	private:
+		struct Array {
+			long			m_size;	// a power of 2
+			ThreadPoolTask * volatile *	m_slots;
+			Array *			m_prev;
+		};
+
+		Array *			grow(Array * a, long top, long bottom);
+
+		volatile long		m_top;
+		char			m_pad1[GSP_CACHE_LINE_SIZE];
+		volatile long		m_bottom;
+		Array * volatile	m_array;
+		char			m_pad2[GSP_CACHE_LINE_SIZE];
+
+		//--------
+		// Not implemented
+		//--------
+		WorkStealingDeque(const WorkStealingDeque &);
+		WorkStealingDeque & operator=(const WorkStealingDeque &);
+	};
+
+
+	class ThreadPool {
+	public:
+		//--------
+		// The worker threads are created with "attr", if it is
+		// not null. For example, it can pin all the workers to
+		// the CPUs of one NUMA node.
+		//--------
+		ThreadPool(int num_threads, const p_thread_attr * attr = 0);
+
+		//--------
+		// The destructor calls wait_all() and then terminates
+		// the worker threads.
+		//--------
+		~ThreadPool();
+
+		//--------
+		// Schedules "task" for execution and takes ownership of
+		// it. It can be called by any thread, including from
+		// within the run() operation of a task.
+		//--------
+		void		submit(ThreadPoolTask * task);
+
+		//--------
+		// Blocks until every task submitted to the pool,
+		// including tasks submitted by running tasks, has
+		// completed. The calling thread executes tasks while it
+		// waits. It must not be called from within a task.
+		//--------
+		void		wait_all();
+
+		int		num_threads() const { return m_num_threads; }
+
+	private:
+		struct Worker {
+			ThreadPool *		m_pool;
+			int			m_index;
+			unsigned long		m_seed;
+			P_THREAD_ID_TYPE	m_thread_id;
+			WorkStealingDeque	m_deque;
+		};
+
+		static void *		workerMain(void * arg);
+		void			workerLoop(Worker * self);
+		Worker *		currentWorker();
+		ThreadPoolTask *	findTask(Worker * self);
+		ThreadPoolTask *	takeInjected();
+		bool			hasWork();
+		void			runTask(ThreadPoolTask * task);
+		void			wakeOne();
+		void			wakeAll(volatile long & count,
+						GSP_ProdCons & sync);
+		void			cancelWait(volatile long & count,
+						GSP_ProdCons & sync);
+
+		int			m_num_threads;
+		Worker **		m_workers;
+		P_TLS_KEY_TYPE		m_tls_key;
+		volatile long		m_pending;	// submitted, not done
+		volatile long		m_stopping;
+
+		//--------
+		// Injection queue for tasks submitted by non-workers
+		//--------
+		GSP_Mutex		m_inject_mutex;
+		ThreadPoolTask *	m_inject_head;
+		ThreadPoolTask *	m_inject_tail;
+		volatile long		m_inject_count;
+
+		//--------
+		// Idle workers, and threads in wait_all(), increment a
+		// count and then wait for a "token" to be put into a
+		// GSP_ProdCons, which is used as a counting semaphore.
+		//--------
+		volatile long		m_sleepers;
+		GSP_ProdCons		m_wakeup;
+		volatile long		m_done_waiters;
+		GSP_ProdCons		m_done;
+
+		//--------
+		// Not implemented
+		//--------
+		ThreadPool(const ThreadPool &);
+		ThreadPool & operator=(const ThreadPool &);
+	};
+
+}; // namespace corbautil
+
+
+#endif /* THREAD_POOL_H_ */
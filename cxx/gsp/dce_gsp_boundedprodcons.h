@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	dce_gsp_boundedprodcons.h
 //
-// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp,
+//			PutBatchOp(long n), GetBatchOp(long max, long & got)]
 //
 // Description:	The bounded producer-consumer synchronisation policy.
 //
@@ -39,6 +40,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <pthread.h>
 #include <assert.h>
 
@@ -87,16 +89,49 @@ public:
 		GSP_BoundedProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp waits until there are "n" free slots and puts
+	// "n" items with one lock acquisition. GetBatchOp waits until
+	// there is at least one item and then gets up to "max" items;
+	// "got" is set to the number actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_BoundedProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_BoundedProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_got;
+	};
+
 protected:
 	friend class	::GSP_BoundedProdCons::PutOp;
 	friend class	::GSP_BoundedProdCons::GetOp;
 	friend class	::GSP_BoundedProdCons::OtherOp;
+	friend class	::GSP_BoundedProdCons::PutBatchOp;
+	friend class	::GSP_BoundedProdCons::GetBatchOp;
+
+	inline static void wakeUp(pthread_cond_t * cond, long waiting, long n);
 
 	pthread_mutex_t	m_mutex;
 	pthread_cond_t	m_notEmpty;
 	pthread_cond_t	m_notFull;
 	long		m_item_count;
 	long		m_buf_size;
+	long		m_get_waiting_count;
+	long		m_put_waiting_count;
+	long		m_batch_put_waiting_count;
 };
 
 
@@ -113,6 +148,9 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 
 	m_item_count = 0;
 	m_buf_size = size;
+	m_get_waiting_count = 0;
+	m_put_waiting_count = 0;
+	m_batch_put_waiting_count = 0;
 
 	status = pthread_mutex_init(&m_mutex, pthread_mutexattr_default);
 	assert(status == 0);
@@ -140,6 +178,26 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 }
 
 
+inline void
+GSP_BoundedProdCons::wakeUp(pthread_cond_t * cond, long waiting, long n)
+{
+	int	status;
+	long	i;
+
+	if (n >= waiting) {
+		if (waiting > 0) {
+			status = pthread_cond_broadcast(cond);
+			assert(status == 0);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			status = pthread_cond_signal(cond);
+			assert(status == 0);
+		}
+	}
+}
+
+
 
 
 
@@ -155,9 +213,14 @@ inline GSP_BoundedProdCons::PutOp::PutOp(GSP_BoundedProdCons &sync_data)
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_item_count == m_sync.m_buf_size) {
-		status = pthread_cond_wait(&m_sync.m_notFull, &m_sync.m_mutex);
-		assert(status == 0);
+	if (m_sync.m_item_count == m_sync.m_buf_size) {
+		m_sync.m_put_waiting_count ++;
+		while (m_sync.m_item_count == m_sync.m_buf_size) {
+			status = pthread_cond_wait(&m_sync.m_notFull,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_put_waiting_count --;
 	}
 }
 
@@ -191,9 +254,14 @@ inline GSP_BoundedProdCons::GetOp::GetOp(GSP_BoundedProdCons &sync_data)
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_item_count == 0) {
-		status = pthread_cond_wait(&m_sync.m_notEmpty, &m_sync.m_mutex);
-		assert(status == 0);
+	if (m_sync.m_item_count == 0) {
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_item_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
 	}
 }
 
@@ -201,13 +269,24 @@ inline GSP_BoundedProdCons::GetOp::GetOp(GSP_BoundedProdCons &sync_data)
 inline GSP_BoundedProdCons::GetOp::~GetOp()
 {
 	int	status;
+	long	batch_waiting;
 
 	m_sync.m_item_count --;
+	batch_waiting = m_sync.m_batch_put_waiting_count;
 
 	status = pthread_mutex_unlock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	status = pthread_cond_signal(&m_sync.m_notFull);
+	//--------
+	// A batch producer might need more than the one slot we have
+	// freed, so a signal might wake it instead of a producer
+	// that could proceed. Wake everyone in that case.
+	//--------
+	if (batch_waiting > 0) {
+		status = pthread_cond_broadcast(&m_sync.m_notFull);
+	} else {
+		status = pthread_cond_signal(&m_sync.m_notFull);
+	}
 	assert(status == 0);
 }
 
@@ -241,4 +320,125 @@ inline GSP_BoundedProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutBatchOp
+//--------
+
+inline GSP_BoundedProdCons::PutBatchOp::PutBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(n >= 0 && n <= m_sync.m_buf_size);
+	m_n = n;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_buf_size - m_sync.m_item_count < m_n) {
+		m_sync.m_put_waiting_count ++;
+		m_sync.m_batch_put_waiting_count ++;
+		while (m_sync.m_buf_size - m_sync.m_item_count < m_n) {
+			status = pthread_cond_wait(&m_sync.m_notFull,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_batch_put_waiting_count --;
+		m_sync.m_put_waiting_count --;
+	}
+}
+
+
+inline GSP_BoundedProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	waiting;
+
+	m_sync.m_item_count += m_n;
+	waiting = m_sync.m_get_waiting_count;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	wakeUp(&m_sync.m_notEmpty, waiting, m_n);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::GetBatchOp
+//--------
+
+inline GSP_BoundedProdCons::GetBatchOp::GetBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(max > 0);
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_item_count == 0) {
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_item_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+	}
+
+	m_got = (m_sync.m_item_count < max) ? m_sync.m_item_count : max;
+	got = m_got;
+}
+
+
+inline GSP_BoundedProdCons::GetBatchOp::~GetBatchOp()
+{
+	int	status;
+	long	waiting;
+	long	batch_waiting;
+
+	m_sync.m_item_count -= m_got;
+	waiting = m_sync.m_put_waiting_count;
+	batch_waiting = m_sync.m_batch_put_waiting_count;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (batch_waiting > 0) {
+		status = pthread_cond_broadcast(&m_sync.m_notFull);
+		assert(status == 0);
+	} else {
+		wakeUp(&m_sync.m_notFull, waiting, m_got);
+	}
+}
+
+
+
+
+
+//--------
+// GSP_BoundedProdCons does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_BoundedProdCons &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
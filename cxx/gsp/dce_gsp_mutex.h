@@ -36,6 +36,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <pthread.h>
 #include <assert.h>
 
@@ -126,4 +127,19 @@ inline GSP_Mutex::Op::~Op()
 
 
 
+//--------
+// GSP_Mutex does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_Mutex &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	dce_gsp_prodcons.h
 //
-// Policy:	ProdCons[PutOp, GetOp, OtherOp]
+// Policy:	ProdCons[PutOp, GetOp, OtherOp,
+//			 PutBatchOp(long n), GetBatchOp(long max, long & got)]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -42,6 +43,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <pthread.h>
 #include <assert.h>
 
@@ -90,14 +92,45 @@ public:
 		GSP_ProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp puts "n" items with one lock acquisition.
+	// GetBatchOp waits until there is at least one item and
+	// then gets up to "max" items; "got" is set to the number
+	// actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_ProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_ProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_got;
+	};
+
 protected:
 	friend class	::GSP_ProdCons::PutOp;
 	friend class	::GSP_ProdCons::GetOp;
 	friend class	::GSP_ProdCons::OtherOp;
+	friend class	::GSP_ProdCons::PutBatchOp;
+	friend class	::GSP_ProdCons::GetBatchOp;
+
+	inline static void wakeUp(pthread_cond_t * cond, long waiting, long n);
 
 	pthread_mutex_t	m_mutex;
 	pthread_cond_t	m_notEmpty;
 	long		m_count;
+	long		m_get_waiting_count;
 };
 
 
@@ -116,6 +149,7 @@ inline GSP_ProdCons::GSP_ProdCons()
 	assert(status == 0);
 
 	m_count = 0;
+	m_get_waiting_count = 0;
 
 	status = pthread_cond_init(&this->m_notEmpty, pthread_condattr_default);
 	assert(status == 0);
@@ -134,6 +168,26 @@ inline GSP_ProdCons::~GSP_ProdCons()
 }
 
 
+inline void
+GSP_ProdCons::wakeUp(pthread_cond_t * cond, long waiting, long n)
+{
+	int	status;
+	long	i;
+
+	if (n >= waiting) {
+		if (waiting > 0) {
+			status = pthread_cond_broadcast(cond);
+			assert(status == 0);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			status = pthread_cond_signal(cond);
+			assert(status == 0);
+		}
+	}
+}
+
+
 
 
 
@@ -180,9 +234,14 @@ inline GSP_ProdCons::GetOp::GetOp(GSP_ProdCons &sync_data)
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_count == 0) {
-		status = pthread_cond_wait(&m_sync.m_notEmpty, &m_sync.m_mutex);
-		assert(status == 0);
+	if (m_sync.m_count == 0) {
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
 	}
 }
 
@@ -227,4 +286,100 @@ inline GSP_ProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_ProdCons::PutBatchOp
+//--------
+
+inline GSP_ProdCons::PutBatchOp::PutBatchOp(GSP_ProdCons &sync_data, long n)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(n >= 0);
+	m_n = n;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+inline GSP_ProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	waiting;
+
+	m_sync.m_count += m_n;
+	waiting = m_sync.m_get_waiting_count;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	wakeUp(&m_sync.m_notEmpty, waiting, m_n);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::GetBatchOp
+//--------
+
+inline GSP_ProdCons::GetBatchOp::GetBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(max > 0);
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_count == 0) {
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+	}
+
+	m_got = (m_sync.m_count < max) ? m_sync.m_count : max;
+	got = m_got;
+}
+
+
+inline GSP_ProdCons::GetBatchOp::~GetBatchOp()
+{
+	int	status;
+
+	m_sync.m_count -= m_got;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// GSP_ProdCons does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_ProdCons &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
@@ -40,6 +40,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <pthread.h>
 #include <assert.h>
 
@@ -264,4 +265,19 @@ inline GSP_RW::WriteOp::~WriteOp()
 
 
 
+//--------
+// GSP_RW does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_RW &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
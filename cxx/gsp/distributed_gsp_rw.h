@@ -0,0 +1,358 @@
+//-----------------------------------------------------------------------
+// File:	distributed_gsp_rw.h
+//
+// Policy:	DistributedRW[ReadOp, WriteOp]	// readers-writer lock
+//
+// Description:	A readers-writer lock that is optimised for workloads
+//		with many concurrent readers on multi-processor machines.
+//
+//		GSP_RW keeps its state in one place, so every ReadOp
+//		writes to the same cache line. GSP_DistributedRW
+//		instead counts readers in an array of slots, each in
+//		its own cache line. A reader updates only the slot for
+//		the CPU it is running on (or, on platforms other than
+//		Linux, a slot chosen by hashing the thread's stack
+//		address), so readers do not contend with each other.
+//		The price is paid by writers: a WriteOp has to wait for
+//		the reader count in every slot to drop to zero.
+//
+//		Once a writer has announced itself, new readers back off
+//		and wait until it has finished, so a steady stream of
+//		readers cannot starve writers.
+//
+//		The number of slots is GSP_DISTRIBUTED_RW_SLOTS, which
+//		must be a power of two.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef DISTRIBUTED_GSP_RW_H_
+#define DISTRIBUTED_GSP_RW_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_atomic.h"
+#include "gsp_futex.h"
+#include "gsp_stats.h"
+#include <limits.h>
+#include <assert.h>
+#if defined(__linux__)
+#	include <sched.h>
+#endif
+
+
+
+
+
+//--------
+// Number of reader slots. It is best set to (at least) the number of
+// CPUs on the machine.
+//--------
+#if !defined(GSP_DISTRIBUTED_RW_SLOTS)
+#	define GSP_DISTRIBUTED_RW_SLOTS	64
+#endif
+
+//--------
+// Number of times a writer re-checks a slot before sleeping.
+//--------
+#if !defined(GSP_DISTRIBUTED_RW_SPIN_COUNT)
+#	define GSP_DISTRIBUTED_RW_SPIN_COUNT	100
+#endif
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_DistributedRW;
+
+
+
+
+
+class GSP_DistributedRW {
+public:
+	inline GSP_DistributedRW();
+	inline ~GSP_DistributedRW();
+
+	class ReadOp {
+	public:
+		inline ReadOp(GSP_DistributedRW &);
+		inline ~ReadOp();
+
+	protected:
+		GSP_DistributedRW	&m_sync;
+		int			m_slot;
+	};
+
+	class WriteOp {
+	public:
+		inline WriteOp(GSP_DistributedRW &);
+		inline ~WriteOp();
+
+	protected:
+		GSP_DistributedRW	&m_sync;
+	};
+
+protected:
+	friend  class ::GSP_DistributedRW::ReadOp;
+	friend  class ::GSP_DistributedRW::WriteOp;
+
+	struct Slot {
+		volatile long	m_reader_count;
+		char		m_pad[GSP_CACHE_LINE_SIZE - sizeof(long)];
+	};
+
+	inline static int currentSlot();
+	inline void waitForWriter();
+	inline void waitForReaders(Slot & slot);
+
+	//--------
+	// m_writer is 0 when there is no writer, 1 when a writer holds
+	// (or is acquiring) the lock, and 2 when, in addition, some
+	// threads may be sleeping until the writer finishes.
+	//--------
+	Slot		m_slots[GSP_DISTRIBUTED_RW_SLOTS];
+	volatile int	m_writer;
+	volatile int	m_drain_seq;
+	char		m_pad[GSP_CACHE_LINE_SIZE];
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_DistributedRW
+//--------
+
+inline GSP_DistributedRW::GSP_DistributedRW()
+{
+	int	i;
+
+	assert((GSP_DISTRIBUTED_RW_SLOTS & (GSP_DISTRIBUTED_RW_SLOTS-1)) == 0);
+	for (i = 0; i < GSP_DISTRIBUTED_RW_SLOTS; i++) {
+		m_slots[i].m_reader_count = 0;
+	}
+	m_writer    = 0;
+	m_drain_seq = 0;
+}
+
+
+
+inline GSP_DistributedRW::~GSP_DistributedRW()
+{
+	int	i;
+
+	//--------
+	// Sanity checks
+	//--------
+	assert(m_writer == 0);
+	for (i = 0; i < GSP_DISTRIBUTED_RW_SLOTS; i++) {
+		assert(m_slots[i].m_reader_count == 0);
+	}
+}
+
+
+
+inline int
+GSP_DistributedRW::currentSlot()
+{
+#if defined(__linux__)
+	int		cpu;
+
+	cpu = sched_getcpu();
+	if (cpu >= 0) {
+		return cpu & (GSP_DISTRIBUTED_RW_SLOTS - 1);
+	}
+#endif
+	//--------
+	// Threads have disjoint stacks, so the address of a local
+	// variable is a cheap, portable way to tell threads apart.
+	//--------
+	char		dummy;
+	unsigned long	hash;
+
+	hash = (unsigned long)&dummy >> 12;
+	hash ^= hash >> 7;
+	return (int)(hash & (GSP_DISTRIBUTED_RW_SLOTS - 1));
+}
+
+
+
+inline void
+GSP_DistributedRW::waitForWriter()
+{
+	int	c;
+
+	while ((c = gsp_atomic_load(&m_writer)) != 0) {
+		if (c == 1 && !gsp_atomic_cas(&m_writer, 1, 2)) {
+			continue;
+		}
+		gsp_futex_wait(&m_writer, 2);
+	}
+}
+
+
+
+inline void
+GSP_DistributedRW::waitForReaders(Slot & slot)
+{
+	int	i;
+	int	seq;
+
+	for (i = 0; i < GSP_DISTRIBUTED_RW_SPIN_COUNT; i++) {
+		if (gsp_atomic_load(&slot.m_reader_count) == 0) {
+			return;
+		}
+		gsp_cpu_relax();
+	}
+	for (;;) {
+		seq = gsp_atomic_load(&m_drain_seq);
+		if (gsp_atomic_load(&slot.m_reader_count) == 0) {
+			return;
+		}
+		gsp_futex_wait(&m_drain_seq, seq);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_DistributedRW::ReadOp
+//--------
+
+inline GSP_DistributedRW::ReadOp::ReadOp(GSP_DistributedRW &sync_data)
+        : m_sync(sync_data)
+{
+	Slot *		slot;
+
+	m_slot = currentSlot();
+	slot = &m_sync.m_slots[m_slot];
+	for (;;) {
+		//--------
+		// Announce ourself, then check for a writer. A writer does
+		// the same in the opposite order, so at least one of us
+		// is guaranteed to notice the other.
+		//--------
+		gsp_atomic_fetch_add(&slot->m_reader_count, 1L);
+		gsp_memory_barrier();
+		if (gsp_atomic_load(&m_sync.m_writer) == 0) {
+			return;
+		}
+
+		//--------
+		// A writer is active or waiting. Back off, let it know
+		// that it need not wait for us, and wait until it is done.
+		//--------
+		gsp_atomic_fetch_add(&slot->m_reader_count, -1L);
+		gsp_atomic_fetch_add(&m_sync.m_drain_seq, 1);
+		gsp_futex_wake(&m_sync.m_drain_seq, 1);
+		m_sync.waitForWriter();
+	}
+}
+
+
+
+inline GSP_DistributedRW::ReadOp::~ReadOp()
+{
+	gsp_atomic_fetch_add(&m_sync.m_slots[m_slot].m_reader_count, -1L);
+	gsp_memory_barrier();
+	if (gsp_atomic_load(&m_sync.m_writer) != 0) {
+		gsp_atomic_fetch_add(&m_sync.m_drain_seq, 1);
+		gsp_futex_wake(&m_sync.m_drain_seq, 1);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_DistributedRW::WriteOp
+//--------
+
+inline GSP_DistributedRW::WriteOp::WriteOp(GSP_DistributedRW &sync_data)
+        : m_sync(sync_data)
+{
+	int	c;
+	int	i;
+
+	//--------
+	// Exclude other writers.
+	//--------
+	if (!gsp_atomic_cas(&m_sync.m_writer, 0, 1)) {
+		c = gsp_atomic_exchange(&m_sync.m_writer, 2);
+		while (c != 0) {
+			gsp_futex_wait(&m_sync.m_writer, 2);
+			c = gsp_atomic_exchange(&m_sync.m_writer, 2);
+		}
+	}
+	gsp_memory_barrier();
+
+	//--------
+	// Wait for the readers that got in before us to leave.
+	//--------
+	for (i = 0; i < GSP_DISTRIBUTED_RW_SLOTS; i++) {
+		m_sync.waitForReaders(m_sync.m_slots[i]);
+	}
+}
+
+
+
+inline GSP_DistributedRW::WriteOp::~WriteOp()
+{
+	if (gsp_atomic_exchange(&m_sync.m_writer, 0) == 2) {
+		gsp_futex_wake(&m_sync.m_writer, INT_MAX);
+	}
+}
+
+
+
+
+
+//--------
+// GSP_DistributedRW does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_DistributedRW &, const char *)
+{
+}
+#endif
+
+
+
+
+
+#endif
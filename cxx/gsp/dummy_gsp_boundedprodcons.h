@@ -1,7 +1,10 @@
 //-----------------------------------------------------------------------
 // File:	dummy_gsp_boundedprodcons.h
 //
-// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp,
+//			PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			TryPutOp, TimedPutOp(long timeout_ms),
+//			TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The bounded producer-consumer synchronisation policy.
 //
@@ -39,6 +42,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <assert.h>
 
 
@@ -58,6 +62,9 @@ class GSP_BoundedProdCons {
 public:
 	inline GSP_BoundedProdCons(int size);
 	inline ~GSP_BoundedProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class PutOp {
 	public:
@@ -86,14 +93,97 @@ public:
 		GSP_BoundedProdCons	&m_sync;
 	};
 
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_BoundedProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_BoundedProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+	};
+
+	//--------
+	// The Try and Timed operations fail, instead of asserting, if
+	// the buffer is full (for a put) or empty (for a get). The
+	// caller must check acquired() before entering the critical
+	// section.
+	//--------
+	class TryPutOp {
+	public:
+		inline TryPutOp(GSP_BoundedProdCons &);
+		inline ~TryPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedPutOp {
+	public:
+		inline TimedPutOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_BoundedProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
 protected:
 	friend class	::GSP_BoundedProdCons::PutOp;
 	friend class	::GSP_BoundedProdCons::GetOp;
 	friend class	::GSP_BoundedProdCons::OtherOp;
+	friend class	::GSP_BoundedProdCons::PutBatchOp;
+	friend class	::GSP_BoundedProdCons::GetBatchOp;
+	friend class	::GSP_BoundedProdCons::TryPutOp;
+	friend class	::GSP_BoundedProdCons::TimedPutOp;
+	friend class	::GSP_BoundedProdCons::TryGetOp;
+	friend class	::GSP_BoundedProdCons::TimedGetOp;
+
+	inline bool acquirePut(long timeout_ms);
+	inline void releasePut();
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	int	m_in_critical_section; // Boolean
 	long	m_item_count;
 	long	m_buf_size;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -109,6 +199,8 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 	m_in_critical_section = 0;
 	m_item_count = 0;
 	m_buf_size = size;
+
+	GSP_STATS_KIND(m_stats, "GSP_BoundedProdCons");
 }
 
 
@@ -117,6 +209,64 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_BoundedProdCons::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+//--------
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. With no other threads, waiting for a timeout
+// could not change anything, so they never wait. They fail, instead
+// of asserting, if the operation cannot proceed.
+//--------
+
+inline bool
+GSP_BoundedProdCons::acquirePut(long)
+{
+	if (m_in_critical_section || m_item_count == m_buf_size) {
+		return false;
+	}
+	m_in_critical_section = 1;
+	m_item_count ++;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_BoundedProdCons::releasePut()
+{
+	assert(m_in_critical_section);
+	m_in_critical_section = 0;
+}
+
+
+inline bool
+GSP_BoundedProdCons::acquireGet(long)
+{
+	if (m_in_critical_section || m_item_count == 0) {
+		return false;
+	}
+	m_in_critical_section = 1;
+	m_item_count --;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_BoundedProdCons::releaseGet()
+{
+	assert(m_in_critical_section);
+	m_in_critical_section = 0;
+}
+
+
 
 
 
@@ -132,6 +282,7 @@ inline GSP_BoundedProdCons::PutOp::PutOp(GSP_BoundedProdCons &sync_data)
 
 	m_sync.m_item_count ++;
 	assert(m_sync.m_item_count <= m_sync.m_buf_size);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -157,6 +308,7 @@ inline GSP_BoundedProdCons::GetOp::GetOp(GSP_BoundedProdCons &sync_data)
 
 	m_sync.m_item_count --;
 	assert(m_sync.m_item_count >= 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -179,6 +331,7 @@ inline GSP_BoundedProdCons::OtherOp::OtherOp(GSP_BoundedProdCons &sync_data)
 {
 	assert(!m_sync.m_in_critical_section);
 	m_sync.m_in_critical_section = 1;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -192,4 +345,184 @@ inline GSP_BoundedProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutBatchOp
+//--------
+
+inline GSP_BoundedProdCons::PutBatchOp::PutBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	assert(n >= 0 && n <= m_sync.m_buf_size);
+	assert(!m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 1;
+
+	m_sync.m_item_count += n;
+	assert(m_sync.m_item_count <= m_sync.m_buf_size);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_BoundedProdCons::PutBatchOp::~PutBatchOp()
+{
+	assert(m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 0;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::GetBatchOp
+//--------
+
+inline GSP_BoundedProdCons::GetBatchOp::GetBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	assert(max > 0);
+	assert(!m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 1;
+
+	assert(m_sync.m_item_count > 0);
+	got = (m_sync.m_item_count < max) ? m_sync.m_item_count : max;
+	m_sync.m_item_count -= got;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_BoundedProdCons::GetBatchOp::~GetBatchOp()
+{
+	assert(m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 0;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryPutOp
+//--------
+
+inline GSP_BoundedProdCons::TryPutOp::TryPutOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(0);
+}
+
+
+inline GSP_BoundedProdCons::TryPutOp::~TryPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedPutOp
+//--------
+
+inline GSP_BoundedProdCons::TimedPutOp::TimedPutOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedPutOp::~TimedPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryGetOp
+//--------
+
+inline GSP_BoundedProdCons::TryGetOp::TryGetOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_BoundedProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedGetOp
+//--------
+
+inline GSP_BoundedProdCons::TimedGetOp::TimedGetOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	dummy_gsp_mutex.h
 //
-// Policy:	GSP_Mutex[Op]	// non-recursive mutex
+// Policy:	GSP_Mutex[Op, TryOp, TimedOp(long timeout_ms)]
+//		// non-recursive mutex
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -36,6 +37,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <assert.h>
 
 
@@ -55,6 +57,9 @@ class GSP_Mutex {
 public:
 	inline GSP_Mutex();
 	inline ~GSP_Mutex();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
  
 	class Op {
 	public:
@@ -64,11 +69,44 @@ public:
 	protected:
 		GSP_Mutex	&m_sync;
 	};
+
+	//--------
+	// TryOp and TimedOp fail, instead of deadlocking, if the mutex
+	// is already held. With no other threads, waiting for a timeout
+	// could not change that, so TimedOp does not wait.
+	//--------
+	class TryOp {
+	public:
+		inline TryOp(GSP_Mutex &);
+		inline ~TryOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedOp {
+	public:
+		inline TimedOp(GSP_Mutex &, long timeout_ms);
+		inline ~TimedOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
  
 protected:
 	friend class	Op;
+	friend class	TryOp;
+	friend class	TimedOp;
 
 	int	m_in_critical_section; // Boolean
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -82,6 +120,8 @@ protected:
 inline GSP_Mutex::GSP_Mutex()
 {
 	m_in_critical_section = 0;
+
+	GSP_STATS_KIND(m_stats, "GSP_Mutex");
 }
 
 
@@ -90,6 +130,15 @@ inline GSP_Mutex::~GSP_Mutex()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_Mutex::stats()
+{
+	return m_stats;
+}
+#endif
+
+
 
 
 
@@ -102,6 +151,7 @@ inline GSP_Mutex::Op::Op(GSP_Mutex &sync_data)
 {
 	assert(!m_sync.m_in_critical_section);
 	m_sync.m_in_critical_section = 1;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -115,4 +165,72 @@ inline GSP_Mutex::Op::~Op()
 
 
 
+//--------
+// Inline implementation of class GSP_Mutex::TryOp
+//--------
+
+inline GSP_Mutex::TryOp::TryOp(GSP_Mutex &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = !m_sync.m_in_critical_section;
+	if (m_acquired) {
+		m_sync.m_in_critical_section = 1;
+		GSP_STATS_ACQUIRED(m_sync.m_stats);
+	}
+}
+
+
+inline GSP_Mutex::TryOp::~TryOp()
+{
+	if (m_acquired) {
+		assert(m_sync.m_in_critical_section);
+		m_sync.m_in_critical_section = 0;
+	}
+}
+
+
+inline bool
+GSP_Mutex::TryOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::TimedOp
+//--------
+
+inline GSP_Mutex::TimedOp::TimedOp(GSP_Mutex &sync_data, long)
+        : m_sync(sync_data)
+{
+	m_acquired = !m_sync.m_in_critical_section;
+	if (m_acquired) {
+		m_sync.m_in_critical_section = 1;
+		GSP_STATS_ACQUIRED(m_sync.m_stats);
+	}
+}
+
+
+inline GSP_Mutex::TimedOp::~TimedOp()
+{
+	if (m_acquired) {
+		assert(m_sync.m_in_critical_section);
+		m_sync.m_in_critical_section = 0;
+	}
+}
+
+
+inline bool
+GSP_Mutex::TimedOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	dummy_gsp_prodcons.h
 //
-// Policy:	ProdCons[PutOp, GetOp, OtherOp]
+// Policy:	ProdCons[PutOp, GetOp, OtherOp,
+//			 PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			 TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -39,6 +41,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <assert.h>
 
 
@@ -58,6 +61,9 @@ class GSP_ProdCons {
 public:
 	inline GSP_ProdCons();
 	inline ~GSP_ProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class PutOp {
 	public:
@@ -86,13 +92,69 @@ public:
 		GSP_ProdCons	&m_sync;
 	};
 
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_ProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_ProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+	};
+
+	//--------
+	// TryGetOp and TimedGetOp fail, instead of asserting, if there
+	// are no items. The caller must check acquired() before
+	// entering the critical section.
+	//--------
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_ProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_ProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend class	::GSP_ProdCons::PutOp;
 	friend class	::GSP_ProdCons::GetOp;
 	friend class	::GSP_ProdCons::OtherOp;
+	friend class	::GSP_ProdCons::PutBatchOp;
+	friend class	::GSP_ProdCons::GetBatchOp;
+	friend class	::GSP_ProdCons::TryGetOp;
+	friend class	::GSP_ProdCons::TimedGetOp;
+
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	int	m_in_critical_section; // Boolean
 	long	m_item_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -107,6 +169,8 @@ inline GSP_ProdCons::GSP_ProdCons()
 {
 	m_in_critical_section = 0;
 	m_item_count = 0;
+
+	GSP_STATS_KIND(m_stats, "GSP_ProdCons");
 }
 
 
@@ -115,6 +179,43 @@ inline GSP_ProdCons::~GSP_ProdCons()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_ProdCons::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+//--------
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. With no other threads, waiting for a timeout
+// could not change anything, so they never wait. They fail, instead
+// of asserting, if the operation cannot proceed.
+//--------
+
+inline bool
+GSP_ProdCons::acquireGet(long)
+{
+	if (m_in_critical_section || m_item_count == 0) {
+		return false;
+	}
+	m_in_critical_section = 1;
+	m_item_count --;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_ProdCons::releaseGet()
+{
+	assert(m_in_critical_section);
+	m_in_critical_section = 0;
+}
+
+
 
 
 
@@ -129,6 +230,7 @@ inline GSP_ProdCons::PutOp::PutOp(GSP_ProdCons &sync_data)
 	m_sync.m_in_critical_section = 1;
 
 	m_sync.m_item_count ++;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -154,6 +256,7 @@ inline GSP_ProdCons::GetOp::GetOp(GSP_ProdCons &sync_data)
 
 	m_sync.m_item_count --;
 	assert(m_sync.m_item_count >= 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -176,6 +279,7 @@ inline GSP_ProdCons::OtherOp::OtherOp(GSP_ProdCons &sync_data)
 {
 	assert(!m_sync.m_in_critical_section);
 	m_sync.m_in_critical_section = 1;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -189,4 +293,123 @@ inline GSP_ProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_ProdCons::PutBatchOp
+//--------
+
+inline GSP_ProdCons::PutBatchOp::PutBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	assert(n >= 0);
+	assert(!m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 1;
+
+	m_sync.m_item_count += n;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_ProdCons::PutBatchOp::~PutBatchOp()
+{
+	assert(m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 0;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::GetBatchOp
+//--------
+
+inline GSP_ProdCons::GetBatchOp::GetBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	assert(max > 0);
+	assert(!m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 1;
+
+	assert(m_sync.m_item_count > 0);
+	got = (m_sync.m_item_count < max) ? m_sync.m_item_count : max;
+	m_sync.m_item_count -= got;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_ProdCons::GetBatchOp::~GetBatchOp()
+{
+	assert(m_sync.m_in_critical_section);
+	m_sync.m_in_critical_section = 0;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::TryGetOp
+//--------
+
+inline GSP_ProdCons::TryGetOp::TryGetOp(GSP_ProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_ProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::TimedGetOp
+//--------
+
+inline GSP_ProdCons::TimedGetOp::TimedGetOp(
+	GSP_ProdCons &		sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_ProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	dummy_gsp_rw.h
 //
-// Policy:	RW[ReadOp, WriteOp]	// readers-writer lock
+// Policy:	RW[ReadOp, WriteOp, TryReadOp, TryWriteOp,
+//		   TimedReadOp(long timeout_ms), TimedWriteOp(long timeout_ms)]
+//		// readers-writer lock
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -36,6 +38,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <assert.h>
 
 
@@ -55,6 +58,9 @@ class GSP_RW {
 public:
 	inline GSP_RW();
 	inline ~GSP_RW();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class ReadOp {
 	public:
@@ -74,12 +80,74 @@ public:
 		GSP_RW      &m_sync;
 	};
 
+	//--------
+	// The Try and Timed variants do not block, or block for at most
+	// "timeout_ms" milliseconds, respectively. The caller must check
+	// acquired() before entering the critical section.
+	//--------
+	class TryReadOp {
+	public:
+		inline TryReadOp(GSP_RW &);
+		inline ~TryReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedReadOp {
+	public:
+		inline TimedReadOp(GSP_RW &, long timeout_ms);
+		inline ~TimedReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TryWriteOp {
+	public:
+		inline TryWriteOp(GSP_RW &);
+		inline ~TryWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedWriteOp {
+	public:
+		inline TimedWriteOp(GSP_RW &, long timeout_ms);
+		inline ~TimedWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend  class ::GSP_RW::ReadOp;
 	friend  class ::GSP_RW::WriteOp;
+	friend  class ::GSP_RW::TryReadOp;
+	friend  class ::GSP_RW::TimedReadOp;
+	friend  class ::GSP_RW::TryWriteOp;
+	friend  class ::GSP_RW::TimedWriteOp;
+
+	inline bool acquireRead(long timeout_ms);
+	inline void releaseRead();
+	inline bool acquireWrite(long timeout_ms);
+	inline void releaseWrite();
 
 	int	m_reader_count;
 	int	m_writer_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -94,6 +162,8 @@ inline GSP_RW::GSP_RW()
 {
 	m_reader_count = 0;
 	m_writer_count = 0;
+
+	GSP_STATS_KIND(m_stats, "GSP_RW");
 }
 
 
@@ -104,6 +174,67 @@ inline GSP_RW::~GSP_RW()
 
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_RW::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+
+//--------
+// With no other threads, waiting for a timeout could not make the
+// lock available, so the Try and Timed operations never wait. They
+// fail, instead of asserting, if the lock is not available.
+//--------
+
+inline bool
+GSP_RW::acquireRead(long)
+{
+	if (m_writer_count != 0) {
+		return false;
+	}
+	m_reader_count++;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+
+inline void
+GSP_RW::releaseRead()
+{
+	assert(m_writer_count == 0);
+	m_reader_count--;
+}
+
+
+
+inline bool
+GSP_RW::acquireWrite(long)
+{
+	if (m_writer_count != 0 || m_reader_count != 0) {
+		return false;
+	}
+	m_writer_count++;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+
+inline void
+GSP_RW::releaseWrite()
+{
+	assert(m_writer_count == 1);
+	assert(m_reader_count == 0);
+	m_writer_count--;
+}
+
+
+
 
 
 //--------
@@ -115,6 +246,7 @@ inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
 {
 	assert(m_sync.m_writer_count == 0);
 	m_sync.m_reader_count++;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -139,6 +271,7 @@ inline GSP_RW::WriteOp::WriteOp(GSP_RW &sync_data)
 	assert(m_sync.m_writer_count == 0);
 	assert(m_sync.m_reader_count == 0);
 	m_sync.m_writer_count++;
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -154,4 +287,128 @@ inline GSP_RW::WriteOp::~WriteOp()
 
 
 
+//--------
+// Inline implementation of class GSP_RW::TryReadOp
+//--------
+
+inline GSP_RW::TryReadOp::TryReadOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(0);
+}
+
+
+
+inline GSP_RW::TryReadOp::~TryReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TryReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedReadOp
+//--------
+
+inline GSP_RW::TimedReadOp::TimedReadOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedReadOp::~TimedReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TryWriteOp
+//--------
+
+inline GSP_RW::TryWriteOp::TryWriteOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(0);
+}
+
+
+
+inline GSP_RW::TryWriteOp::~TryWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TryWriteOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedWriteOp
+//--------
+
+inline GSP_RW::TimedWriteOp::TimedWriteOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedWriteOp::~TimedWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedWriteOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
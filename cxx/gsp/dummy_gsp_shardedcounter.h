@@ -0,0 +1,111 @@
+//-----------------------------------------------------------------------
+// File:	dummy_gsp_shardedcounter.h
+//
+// Class:	ShardedCounter[add(long delta), increment(), sum()]
+//
+// Description:	With no threads there is nothing to shard, so the
+//		counter is a plain long.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef DUMMY_GSP_SHARDEDCOUNTER_H_
+#define DUMMY_GSP_SHARDEDCOUNTER_H_
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_ShardedCounter;
+
+
+
+
+
+class GSP_ShardedCounter {
+public:
+	inline GSP_ShardedCounter();
+	inline ~GSP_ShardedCounter();
+
+	inline void add(long delta);
+	inline void increment();
+	inline long sum();
+
+protected:
+	long	m_value;
+
+private:
+	//--------
+	// Not implemented
+	//--------
+	GSP_ShardedCounter(const GSP_ShardedCounter &);
+	GSP_ShardedCounter & operator=(const GSP_ShardedCounter &);
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ShardedCounter
+//--------
+
+inline GSP_ShardedCounter::GSP_ShardedCounter()
+{
+	m_value = 0;
+}
+
+
+inline GSP_ShardedCounter::~GSP_ShardedCounter()
+{
+}
+
+
+inline void
+GSP_ShardedCounter::add(long delta)
+{
+	m_value += delta;
+}
+
+
+inline void
+GSP_ShardedCounter::increment()
+{
+	m_value ++;
+}
+
+
+inline long
+GSP_ShardedCounter::sum()
+{
+	return m_value;
+}
+
+
+
+
+
+#endif
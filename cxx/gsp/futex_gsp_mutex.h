@@ -0,0 +1,375 @@
+//-----------------------------------------------------------------------
+// File:	futex_gsp_mutex.h
+//
+// Policy:	GSP_Mutex[Op, TryOp, TimedOp(long timeout_ms)]
+//		// non-recursive mutex
+//
+// Description:	A Linux-specific mutex built directly on the futex()
+//		system call. A thread that finds the mutex locked spins
+//		for a while before it sleeps in the kernel, which is
+//		much cheaper than a context switch when critical
+//		sections are short.
+//
+//		The number of spin iterations adapts to how long the
+//		mutex is typically held, and is bounded by the value
+//		passed to the constructor (default GSP_MUTEX_SPIN_COUNT).
+//		Passing 0 disables spinning.
+//
+// Note:	The locking algorithm is "Mutex, Take 3" from the paper
+//		"Futexes Are Tricky" by Ulrich Drepper. The mutex word
+//		is 0 when unlocked, 1 when locked and 2 when locked with
+//		(possibly) some threads sleeping.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef FUTEX_GSP_MUTEX_H_
+#define FUTEX_GSP_MUTEX_H_
+ 
+ 
+
+
+
+//--------
+// #include's
+//--------
+#if !defined(__linux__)
+#	error "P_USE_LINUX_FUTEX_THREADS is supported only on Linux"
+#endif
+#include "gsp_atomic.h"
+#include "gsp_futex.h"
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
+#include <assert.h>
+
+
+
+
+
+//--------
+// Upper bound on the number of iterations to spin before sleeping.
+//--------
+#if !defined(GSP_MUTEX_SPIN_COUNT)
+#	define GSP_MUTEX_SPIN_COUNT	100
+#endif
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_Mutex;
+ 
+ 
+
+
+
+class GSP_Mutex {
+public:
+	inline GSP_Mutex(int max_spin_count = GSP_MUTEX_SPIN_COUNT);
+	inline ~GSP_Mutex();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
+ 
+	class Op {
+	public:
+		inline Op(GSP_Mutex &);
+		inline ~Op();
+ 
+	protected:
+		GSP_Mutex	&m_sync;
+	};
+
+	//--------
+	// TryOp does not block, and TimedOp blocks for at most
+	// "timeout_ms" milliseconds. The caller must check acquired()
+	// before entering the critical section.
+	//--------
+	class TryOp {
+	public:
+		inline TryOp(GSP_Mutex &);
+		inline ~TryOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedOp {
+	public:
+		inline TimedOp(GSP_Mutex &, long timeout_ms);
+		inline ~TimedOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
+ 
+protected:
+	friend class	Op;
+	friend class	TryOp;
+	friend class	TimedOp;
+
+	inline void lock();
+	inline bool tryLock();
+	inline bool timedLock(long timeout_ms);
+	inline void unlock();
+
+	volatile int	m_state;	// 0, 1 or 2
+	int		m_max_spin_count;
+	volatile int	m_spin_estimate;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex
+//--------
+
+inline GSP_Mutex::GSP_Mutex(int max_spin_count)
+{
+	assert(max_spin_count >= 0);
+	m_state          = 0;
+	m_max_spin_count = max_spin_count;
+	m_spin_estimate  = max_spin_count / 2;
+
+	GSP_STATS_KIND(m_stats, "GSP_Mutex");
+}
+
+
+inline GSP_Mutex::~GSP_Mutex()
+{
+	assert(m_state == 0);
+}
+
+
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_Mutex::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+inline void
+GSP_Mutex::lock()
+{
+	int	c;
+	int	i;
+	int	spin_limit;
+
+	//--------
+	// Fast path: the mutex is not locked.
+	//--------
+	if (gsp_atomic_cas(&m_state, 0, 1)) {
+		GSP_STATS_ACQUIRED(m_stats);
+		return;
+	}
+	GSP_STATS_WAIT_BEGIN(m_stats);
+
+	//--------
+	// Spin for up to twice the recent average number of
+	// iterations that were needed to acquire the mutex. The
+	// estimate is updated while we hold the mutex, so it needs
+	// no extra synchronisation.
+	//--------
+	spin_limit = m_spin_estimate * 2 + 10;
+	if (spin_limit > m_max_spin_count) {
+		spin_limit = m_max_spin_count;
+	}
+	for (i = 0; i < spin_limit; i++) {
+		if (gsp_atomic_load(&m_state) == 0
+		    && gsp_atomic_cas(&m_state, 0, 1))
+		{
+			m_spin_estimate += (i - m_spin_estimate) / 8;
+			GSP_STATS_WAIT_END(m_stats);
+			GSP_STATS_ACQUIRED(m_stats);
+			return;
+		}
+		gsp_cpu_relax();
+	}
+
+	//--------
+	// Slow path: mark the mutex as contended and sleep until it is
+	// released.
+	//--------
+	c = gsp_atomic_exchange(&m_state, 2);
+	while (c != 0) {
+		gsp_futex_wait(&m_state, 2);
+		c = gsp_atomic_exchange(&m_state, 2);
+	}
+	m_spin_estimate += (spin_limit - m_spin_estimate) / 8;
+	GSP_STATS_WAIT_END(m_stats);
+	GSP_STATS_ACQUIRED(m_stats);
+}
+
+
+inline bool
+GSP_Mutex::tryLock()
+{
+	if (!gsp_atomic_cas(&m_state, 0, 1)) {
+		return false;
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline bool
+GSP_Mutex::timedLock(long timeout_ms)
+{
+	int		c;
+	long		remaining;
+	gsp_deadline_t	deadline;
+
+	if (gsp_atomic_cas(&m_state, 0, 1)) {
+		GSP_STATS_ACQUIRED(m_stats);
+		return true;
+	}
+	GSP_STATS_WAIT_BEGIN(m_stats);
+
+	//--------
+	// As in the slow path of lock(), but give up when the deadline
+	// passes. The mutex word is left at 2 if we time out, which
+	// costs the owner no more than an unnecessary wake up.
+	//--------
+	gsp_deadline_init(&deadline, timeout_ms);
+	c = gsp_atomic_exchange(&m_state, 2);
+	while (c != 0) {
+		remaining = gsp_deadline_remaining_ms(&deadline);
+		if (remaining == 0) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+			return false;
+		}
+		gsp_futex_timed_wait(&m_state, 2, remaining);
+		c = gsp_atomic_exchange(&m_state, 2);
+	}
+	GSP_STATS_WAIT_END(m_stats);
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_Mutex::unlock()
+{
+	if (gsp_atomic_exchange(&m_state, 0) == 2) {
+		gsp_futex_wake(&m_state, 1);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::Op
+//--------
+
+inline GSP_Mutex::Op::Op(GSP_Mutex &sync_data)
+        : m_sync(sync_data)
+{
+	m_sync.lock();
+}
+
+
+inline GSP_Mutex::Op::~Op()
+{
+	m_sync.unlock();
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::TryOp
+//--------
+
+inline GSP_Mutex::TryOp::TryOp(GSP_Mutex &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.tryLock();
+}
+
+
+inline GSP_Mutex::TryOp::~TryOp()
+{
+	if (m_acquired) {
+		m_sync.unlock();
+	}
+}
+
+
+inline bool
+GSP_Mutex::TryOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::TimedOp
+//--------
+
+inline GSP_Mutex::TimedOp::TimedOp(GSP_Mutex &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.timedLock(timeout_ms);
+}
+
+
+inline GSP_Mutex::TimedOp::~TimedOp()
+{
+	if (m_acquired) {
+		m_sync.unlock();
+	}
+}
+
+
+inline bool
+GSP_Mutex::TimedOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+#endif
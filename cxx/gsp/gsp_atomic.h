@@ -0,0 +1,326 @@
+//-----------------------------------------------------------------------
+// File:	gsp_atomic.h
+//
+// Description:	A small set of atomic operations and memory barriers
+//		that are used by the lock-free GSP classes. The
+//		operations map onto the "__atomic" builtins of GCC
+//		(and compilers that mimic it), onto the Interlocked*()
+//		functions when compiling with Microsoft Visual C++, or
+//		onto the atomic_*() and membar_*() functions of
+//		<atomic.h> when compiling with Sun C++ on Solaris 10 or
+//		later.
+//
+// Note:	With Visual C++, the operations can be used only on
+//		32-bit integral types, such as int, long and unsigned
+//		long, and gsp_atomic_load()/gsp_atomic_store() rely on
+//		the x86/x64 memory model. With Sun C++, they can be used
+//		on 32-bit and 64-bit integral and pointer types.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef GSP_ATOMIC_H_
+#define GSP_ATOMIC_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#if defined(_MSC_VER)
+#	include <windows.h>
+#	include <intrin.h>
+#elif defined(__sun) && !defined(__GNUC__)
+#	define GSP_USE_SOLARIS_ATOMIC
+#	include <atomic.h>
+#	include <inttypes.h>
+#endif
+
+
+
+
+
+//--------
+// Size of a cache line. Variables that are updated by different
+// threads are padded to this size so they do not share a cache line.
+//--------
+#if !defined(GSP_CACHE_LINE_SIZE)
+#	define GSP_CACHE_LINE_SIZE	64
+#endif
+
+
+
+
+
+#if defined(_MSC_VER)
+//--------
+// Visual C++ implementation
+//--------
+
+template<class T>
+inline T
+gsp_atomic_load(const volatile T * ptr)	// acquire
+{
+	T	val;
+
+	val = *ptr;
+	_ReadWriteBarrier();
+	return val;
+}
+
+
+template<class T>
+inline void
+gsp_atomic_store(volatile T * ptr, T val)	// release
+{
+	_ReadWriteBarrier();
+	*ptr = val;
+}
+
+
+template<class T>
+inline T
+gsp_atomic_fetch_add(volatile T * ptr, T delta)
+{
+	return (T)InterlockedExchangeAdd((volatile LONG *)ptr, (LONG)delta);
+}
+
+
+template<class T>
+inline T
+gsp_atomic_exchange(volatile T * ptr, T val)
+{
+	return (T)InterlockedExchange((volatile LONG *)ptr, (LONG)val);
+}
+
+
+template<class T>
+inline bool
+gsp_atomic_cas(volatile T * ptr, T expected, T desired)
+{
+	return (T)InterlockedCompareExchange((volatile LONG *)ptr,
+				(LONG)desired, (LONG)expected) == expected;
+}
+
+
+inline void
+gsp_memory_barrier()
+{
+	MemoryBarrier();
+}
+
+
+inline void
+gsp_cpu_relax()
+{
+	YieldProcessor();
+}
+
+#elif defined(GSP_USE_SOLARIS_ATOMIC)
+//--------
+// Sun C++ implementation. gsp_atomic_ops<N> provides the <atomic.h>
+// functions for N-byte words, and a union converts between T and a
+// word so that T can be an integral or a pointer type.
+//--------
+
+template<int N> struct gsp_atomic_ops;
+
+template<> struct gsp_atomic_ops<4> {
+	typedef uint32_t	word;
+
+	static word add_nv(volatile word * p, word d)
+		{ return atomic_add_32_nv(p, (int32_t)d); }
+	static word swap(volatile word * p, word v)
+		{ return atomic_swap_32(p, v); }
+	static word cas(volatile word * p, word e, word d)
+		{ return atomic_cas_32(p, e, d); }
+};
+
+template<> struct gsp_atomic_ops<8> {
+	typedef uint64_t	word;
+
+	static word add_nv(volatile word * p, word d)
+		{ return atomic_add_64_nv(p, (int64_t)d); }
+	static word swap(volatile word * p, word v)
+		{ return atomic_swap_64(p, v); }
+	static word cas(volatile word * p, word e, word d)
+		{ return atomic_cas_64(p, e, d); }
+};
+
+template<class T>
+union gsp_atomic_word {
+	T					value;
+	typename gsp_atomic_ops<sizeof(T)>::word	word;
+};
+
+
+template<class T>
+inline T
+gsp_atomic_load(const volatile T * ptr)	// acquire
+{
+	T	val;
+
+	val = *ptr;
+	membar_enter();
+	return val;
+}
+
+
+template<class T>
+inline void
+gsp_atomic_store(volatile T * ptr, T val)	// release
+{
+	membar_exit();
+	*ptr = val;
+}
+
+
+template<class T>
+inline T
+gsp_atomic_fetch_add(volatile T * ptr, T delta)
+{
+	typedef gsp_atomic_ops<sizeof(T)>	ops;
+	gsp_atomic_word<T>			d;
+	gsp_atomic_word<T>			r;
+
+	d.value = delta;
+	r.word = ops::add_nv((volatile typename ops::word *)ptr, d.word)
+		 - d.word;
+	return r.value;
+}
+
+
+template<class T>
+inline T
+gsp_atomic_exchange(volatile T * ptr, T val)
+{
+	typedef gsp_atomic_ops<sizeof(T)>	ops;
+	gsp_atomic_word<T>			v;
+	gsp_atomic_word<T>			r;
+
+	v.value = val;
+	r.word = ops::swap((volatile typename ops::word *)ptr, v.word);
+	return r.value;
+}
+
+
+template<class T>
+inline bool
+gsp_atomic_cas(volatile T * ptr, T expected, T desired)
+{
+	typedef gsp_atomic_ops<sizeof(T)>	ops;
+	gsp_atomic_word<T>			e;
+	gsp_atomic_word<T>			d;
+
+	e.value = expected;
+	d.value = desired;
+	return ops::cas((volatile typename ops::word *)ptr, e.word, d.word)
+		== e.word;
+}
+
+
+inline void
+gsp_memory_barrier()
+{
+	membar_enter();
+	membar_exit();
+}
+
+
+inline void
+gsp_cpu_relax()
+{
+}
+
+#else
+//--------
+// GCC implementation
+//--------
+
+template<class T>
+inline T
+gsp_atomic_load(const volatile T * ptr)	// acquire
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+
+template<class T>
+inline void
+gsp_atomic_store(volatile T * ptr, T val)	// release
+{
+	__atomic_store_n(ptr, val, __ATOMIC_RELEASE);
+}
+
+
+template<class T>
+inline T
+gsp_atomic_fetch_add(volatile T * ptr, T delta)
+{
+	return __atomic_fetch_add(ptr, delta, __ATOMIC_SEQ_CST);
+}
+
+
+template<class T>
+inline T
+gsp_atomic_exchange(volatile T * ptr, T val)
+{
+	return __atomic_exchange_n(ptr, val, __ATOMIC_SEQ_CST);
+}
+
+
+template<class T>
+inline bool
+gsp_atomic_cas(volatile T * ptr, T expected, T desired)
+{
+	return __atomic_compare_exchange_n(ptr, &expected, desired, false,
+				__ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+
+inline void
+gsp_memory_barrier()
+{
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+
+inline void
+gsp_cpu_relax()
+{
+#if defined(__i386__) || defined(__x86_64__)
+	__asm__ __volatile__("pause" ::: "memory");
+#else
+	__asm__ __volatile__("" ::: "memory");
+#endif
+}
+
+#endif /* _MSC_VER, GSP_USE_SOLARIS_ATOMIC */
+
+
+
+
+
+#endif
@@ -0,0 +1,682 @@
+//----------------------------------------------------------------------
+// File:	gsp_bench.cxx
+//
+// Description:	Micro-benchmarks for the GSP classes. For each of
+//		GSP_Mutex, GSP_RW, GSP_ProdCons and GSP_BoundedProdCons
+//		it runs a number of scenarios with 1, 2, 4, ... threads
+//		up to the number of CPUs, and prints one line of CSV per
+//		run:
+//
+//		policy,backend,scenario,threads,ops,secs,ops_per_sec,
+//		p50_ns,p99_ns,p999_ns
+//
+//		"ops" is the total number of operations performed by all
+//		threads. The latencies are those of individual
+//		operations, that is, the time taken to acquire the lock,
+//		execute a tiny critical section and release the lock.
+//		A run with one thread measures the uncontended cost.
+//
+//		Usage: gsp_bench [-n ops-per-thread] [-t max-threads]
+//
+// Copyright 2006 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_mutex.h"
+#include "gsp_rw.h"
+#include "gsp_prodcons.h"
+#include "gsp_boundedprodcons.h"
+#include "gsp_atomic.h"
+#include "p_create_joinable_thread.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if defined(P_USE_WIN32_THREADS)
+#	include <windows.h>
+#else
+#	include <time.h>
+#	include <unistd.h>
+#endif
+
+
+
+
+
+//--------
+// The name of the threading package the GSP classes were compiled for
+//--------
+#if defined(P_USE_WIN32_THREADS)
+#	define BENCH_BACKEND	"win32"
+#elif defined(P_USE_LINUX_FUTEX_THREADS)
+#	define BENCH_BACKEND	"linux_futex"
+#elif defined(P_USE_POSIX_THREADS)
+#	define BENCH_BACKEND	"posix"
+#elif defined(P_USE_DCE_THREADS)
+#	define BENCH_BACKEND	"dce"
+#elif defined(P_USE_SOLARIS_THREADS)
+#	define BENCH_BACKEND	"solaris"
+#elif defined(P_USE_NO_THREADS)
+#	define BENCH_BACKEND	"none"
+#endif
+
+
+
+
+
+//--------
+// Parameters shared by all the threads of one run. Each thread
+// writes its latencies, in nanoseconds, to its own part of "latencies".
+//--------
+struct BenchRun;
+typedef void (*BenchBody)(BenchRun * run, int thread_index);
+
+struct BenchRun {
+	BenchBody		body;
+	int			num_threads;
+	long			ops_per_thread;
+	long			read_percent;	// for GSP_RW
+	volatile int		ready_count;
+	volatile int		go;
+	double *		latencies;
+
+	GSP_Mutex *		mutexes;	// one, or one per thread
+	long *			counters;	// one per mutex
+	int			num_mutexes;
+	GSP_RW *		rw;
+	GSP_ProdCons *		prodcons;
+	GSP_BoundedProdCons *	bounded;
+
+	//--------
+	// The data protected by the lock
+	//--------
+	long			shared_counter;
+	long			item_count;
+};
+
+//--------
+// Distance between the counters of GSP_Mutex, so that each counter
+// is on its own cache line.
+//--------
+#define BENCH_COUNTER_STRIDE	(GSP_CACHE_LINE_SIZE / sizeof(long))
+
+struct BenchThreadArg {
+	BenchRun *		run;
+	int			thread_index;
+};
+
+
+
+
+
+//--------
+// Forward declarations
+//--------
+static double	now_ns();
+static int	num_cpus();
+static void	run_scenario(
+			const char *	policy,
+			const char *	scenario,
+			BenchRun *	run);
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	now_ns()
+//
+// Description:	Returns the value of a monotonic clock, in nanoseconds.
+//----------------------------------------------------------------------
+
+static double
+now_ns()
+{
+#if defined(P_USE_WIN32_THREADS)
+	static LARGE_INTEGER	freq;
+	LARGE_INTEGER		count;
+
+	if (freq.QuadPart == 0) {
+		QueryPerformanceFrequency(&freq);
+	}
+	QueryPerformanceCounter(&count);
+	return (double)count.QuadPart * 1.0e9 / (double)freq.QuadPart;
+#else
+	struct timespec		ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (double)ts.tv_sec * 1.0e9 + (double)ts.tv_nsec;
+#endif
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	num_cpus()
+//----------------------------------------------------------------------
+
+static int
+num_cpus()
+{
+#if defined(P_USE_WIN32_THREADS)
+	SYSTEM_INFO		info;
+
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long			count;
+
+	count = sysconf(_SC_NPROCESSORS_ONLN);
+	if (count < 1) {
+		count = 1;
+	}
+	return (int)count;
+#endif
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	next_random()
+//
+// Description:	A per-thread linear congruential generator. It is
+//		used instead of rand(), which may be serialised by a
+//		lock inside the C library.
+//----------------------------------------------------------------------
+
+static unsigned long
+next_random(unsigned long * seed)
+{
+	*seed = *seed * 1103515245UL + 12345UL;
+	return (*seed >> 16) & 0x7fff;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Bodies of the benchmarks. Each one performs run->ops_per_thread
+// operations and records the latency of each.
+//----------------------------------------------------------------------
+
+static void
+mutex_body(BenchRun * run, int thread_index)
+{
+	GSP_Mutex *	mutex;
+	long *		counter;
+	double *	lat;
+	double		start;
+	long		i;
+
+	mutex = &run->mutexes[thread_index % run->num_mutexes];
+	counter = &run->counters[(thread_index % run->num_mutexes)
+				 * BENCH_COUNTER_STRIDE];
+	lat = run->latencies + thread_index * run->ops_per_thread;
+	for (i = 0; i < run->ops_per_thread; i++) {
+		start = now_ns();
+		{
+			GSP_Mutex::Op	scopedLock(*mutex);
+			(*counter) ++;
+		}
+		lat[i] = now_ns() - start;
+	}
+}
+
+
+static void
+rw_body(BenchRun * run, int thread_index)
+{
+	double *	lat;
+	double		start;
+	long		i;
+	long		sum;
+	unsigned long	seed;
+
+	lat = run->latencies + thread_index * run->ops_per_thread;
+	seed = thread_index + 1;
+	sum = 0;
+	for (i = 0; i < run->ops_per_thread; i++) {
+		if ((long)(next_random(&seed) % 100) < run->read_percent) {
+			start = now_ns();
+			{
+				GSP_RW::ReadOp	scopedLock(*run->rw);
+				sum += run->shared_counter;
+			}
+			lat[i] = now_ns() - start;
+		} else {
+			start = now_ns();
+			{
+				GSP_RW::WriteOp	scopedLock(*run->rw);
+				run->shared_counter ++;
+			}
+			lat[i] = now_ns() - start;
+		}
+	}
+	if (sum == -1) {
+		printf("%ld\n", sum); // stop the reads being optimised away
+	}
+}
+
+
+//--------
+// The producer-consumer benchmarks use half of the threads (rounded
+// down) as producers and the rest as consumers. With one thread, it
+// alternates between putting and getting an item. consumer_ops()
+// spreads the items of all producers across the consumers.
+//--------
+
+static long
+consumer_ops(BenchRun * run, int consumer_index)
+{
+	long		num_producers;
+	long		num_consumers;
+	long		total;
+
+	num_producers = run->num_threads / 2;
+	num_consumers = run->num_threads - num_producers;
+	total = run->ops_per_thread * num_producers;
+	return total / num_consumers
+		+ (consumer_index < total % num_consumers ? 1 : 0);
+}
+
+
+static void
+prodcons_body(BenchRun * run, int thread_index)
+{
+	double *	lat;
+	double		start;
+	long		i;
+	long		n;
+	int		num_producers;
+
+	lat = run->latencies + thread_index * run->ops_per_thread;
+	num_producers = run->num_threads / 2;
+	if (run->num_threads == 1) {
+		for (i = 0; i < run->ops_per_thread; i++) {
+			start = now_ns();
+			if (i % 2 == 0) {
+				GSP_ProdCons::PutOp	scopedLock(*run->prodcons);
+				run->item_count ++;
+			} else {
+				GSP_ProdCons::GetOp	scopedLock(*run->prodcons);
+				run->item_count --;
+			}
+			lat[i] = now_ns() - start;
+		}
+		if (run->ops_per_thread % 2 == 1) {
+			GSP_ProdCons::GetOp	scopedLock(*run->prodcons);
+			run->item_count --;
+		}
+	} else if (thread_index < num_producers) {
+		for (i = 0; i < run->ops_per_thread; i++) {
+			start = now_ns();
+			{
+				GSP_ProdCons::PutOp	scopedLock(*run->prodcons);
+				run->item_count ++;
+			}
+			lat[i] = now_ns() - start;
+		}
+	} else {
+		n = consumer_ops(run, thread_index - num_producers);
+		for (i = 0; i < n; i++) {
+			start = now_ns();
+			{
+				GSP_ProdCons::GetOp	scopedLock(*run->prodcons);
+				run->item_count --;
+			}
+			lat[i] = now_ns() - start;
+		}
+		for (; i < run->ops_per_thread; i++) {
+			lat[i] = -1.0; // unused
+		}
+	}
+}
+
+
+static void
+bounded_body(BenchRun * run, int thread_index)
+{
+	double *	lat;
+	double		start;
+	long		i;
+	long		n;
+	int		num_producers;
+
+	lat = run->latencies + thread_index * run->ops_per_thread;
+	num_producers = run->num_threads / 2;
+	if (run->num_threads == 1) {
+		for (i = 0; i < run->ops_per_thread; i++) {
+			start = now_ns();
+			if (i % 2 == 0) {
+				GSP_BoundedProdCons::PutOp scopedLock(*run->bounded);
+				run->item_count ++;
+			} else {
+				GSP_BoundedProdCons::GetOp scopedLock(*run->bounded);
+				run->item_count --;
+			}
+			lat[i] = now_ns() - start;
+		}
+		if (run->ops_per_thread % 2 == 1) {
+			GSP_BoundedProdCons::GetOp	scopedLock(*run->bounded);
+			run->item_count --;
+		}
+	} else if (thread_index < num_producers) {
+		for (i = 0; i < run->ops_per_thread; i++) {
+			start = now_ns();
+			{
+				GSP_BoundedProdCons::PutOp scopedLock(*run->bounded);
+				run->item_count ++;
+			}
+			lat[i] = now_ns() - start;
+		}
+	} else {
+		n = consumer_ops(run, thread_index - num_producers);
+		for (i = 0; i < n; i++) {
+			start = now_ns();
+			{
+				GSP_BoundedProdCons::GetOp scopedLock(*run->bounded);
+				run->item_count --;
+			}
+			lat[i] = now_ns() - start;
+		}
+		for (; i < run->ops_per_thread; i++) {
+			lat[i] = -1.0; // unused
+		}
+	}
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	bench_thread()
+//
+// Description:	Waits until all the threads of a run have started,
+//		so that thread creation is not measured, and then
+//		executes the body of the benchmark.
+//----------------------------------------------------------------------
+
+static void *
+bench_thread(void * p)
+{
+	BenchThreadArg *	arg;
+	BenchRun *		run;
+
+	arg = (BenchThreadArg *)p;
+	run = arg->run;
+	gsp_atomic_fetch_add(&run->ready_count, 1);
+	while (gsp_atomic_load(&run->go) == 0) {
+		gsp_cpu_relax();
+	}
+	run->body(run, arg->thread_index);
+	return 0;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	compare_doubles()
+//----------------------------------------------------------------------
+
+static int
+compare_doubles(const void * a, const void * b)
+{
+	double		x = *(const double *)a;
+	double		y = *(const double *)b;
+
+	return (x < y) ? -1 : (x > y) ? 1 : 0;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	percentile()
+//
+// Description:	"sorted" must be sorted in ascending order.
+//----------------------------------------------------------------------
+
+static double
+percentile(const double * sorted, long count, double fraction)
+{
+	long		index;
+
+	if (count == 0) {
+		return 0.0;
+	}
+	index = (long)(fraction * (double)(count - 1) + 0.5);
+	return sorted[index];
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	run_scenario()
+//
+// Description:	Runs "run->body" in "run->num_threads" threads and
+//		prints one CSV line with the results.
+//----------------------------------------------------------------------
+
+static void
+run_scenario(const char * policy, const char * scenario, BenchRun * run)
+{
+	P_THREAD_ID_TYPE *	threads;
+	BenchThreadArg *	args;
+	double			start;
+	double			secs;
+	long			total;
+	long			count;
+	long			i;
+	int			t;
+
+	total = run->ops_per_thread * run->num_threads;
+	run->latencies = new double[total];
+	run->ready_count = 0;
+	run->go = 0;
+	run->shared_counter = 0;
+	run->item_count = 0;
+
+	threads = new P_THREAD_ID_TYPE[run->num_threads];
+	args = new BenchThreadArg[run->num_threads];
+	for (t = 0; t < run->num_threads; t++) {
+		args[t].run = run;
+		args[t].thread_index = t;
+		threads[t] = create_joinable_thread(bench_thread, &args[t]);
+	}
+	while (gsp_atomic_load(&run->ready_count) < run->num_threads) {
+		gsp_cpu_relax();
+	}
+	start = now_ns();
+	gsp_atomic_store(&run->go, 1);
+	for (t = 0; t < run->num_threads; t++) {
+		join_with_thread(threads[t]);
+	}
+	secs = (now_ns() - start) / 1.0e9;
+	assert(run->item_count == 0);
+
+	//--------
+	// Discard unused slots (marked with a negative latency) and
+	// compute the percentiles.
+	//--------
+	count = 0;
+	for (i = 0; i < total; i++) {
+		if (run->latencies[i] >= 0.0) {
+			run->latencies[count] = run->latencies[i];
+			count ++;
+		}
+	}
+	qsort(run->latencies, count, sizeof(double), compare_doubles);
+
+	printf("%s,%s,%s,%d,%ld,%.6f,%.0f,%.0f,%.0f,%.0f\n",
+		policy, BENCH_BACKEND, scenario, run->num_threads, count,
+		secs, (secs > 0.0) ? (double)count / secs : 0.0,
+		percentile(run->latencies, count, 0.50),
+		percentile(run->latencies, count, 0.99),
+		percentile(run->latencies, count, 0.999));
+	fflush(stdout);
+
+	delete [] run->latencies;
+	delete [] threads;
+	delete [] args;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	usage()
+//----------------------------------------------------------------------
+
+static void
+usage(const char * prog)
+{
+	fprintf(stderr, "usage: %s [-n ops-per-thread] [-t max-threads]\n",
+		prog);
+	exit(1);
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	main()
+//----------------------------------------------------------------------
+
+int
+main(int argc, char ** argv)
+{
+	static const long	read_percents[] = { 100, 99, 90, 50 };
+	static const int	buffer_sizes[] = { 1, 16, 256 };
+	BenchRun		run;
+	char			scenario[64];
+	long			ops_per_thread;
+	int			max_threads;
+	int			threads;
+	int			i;
+	int			j;
+
+	ops_per_thread = 100000;
+	max_threads = num_cpus();
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-n") == 0 && i + 1 < argc) {
+			ops_per_thread = atol(argv[++i]);
+		} else if (strcmp(argv[i], "-t") == 0 && i + 1 < argc) {
+			max_threads = atoi(argv[++i]);
+		} else {
+			usage(argv[0]);
+		}
+	}
+	if (ops_per_thread < 1 || max_threads < 1) {
+		usage(argv[0]);
+	}
+#if defined(P_USE_NO_THREADS)
+	//--------
+	// Without threads, a blocked operation would wait forever.
+	//--------
+	max_threads = 1;
+#endif
+
+	printf("policy,backend,scenario,threads,ops,secs,ops_per_sec,"
+		"p50_ns,p99_ns,p999_ns\n");
+
+	//--------
+	// Sweep 1, 2, 4, ... threads, finishing with "max_threads"
+	//--------
+	for (threads = 1; ; threads = (threads * 2 > max_threads
+					? max_threads : threads * 2))
+	{
+		memset(&run, 0, sizeof(run));
+		run.num_threads = threads;
+		run.ops_per_thread = ops_per_thread;
+
+		//--------
+		// GSP_Mutex: all threads share one mutex, or each thread
+		// has its own (which measures uncontended scalability).
+		//--------
+		run.body = mutex_body;
+		run.counters = new long[threads * BENCH_COUNTER_STRIDE];
+		run.num_mutexes = 1;
+		run.mutexes = new GSP_Mutex[1];
+		run_scenario("GSP_Mutex", "shared", &run);
+		delete [] run.mutexes;
+		run.num_mutexes = threads;
+		run.mutexes = new GSP_Mutex[threads];
+		run_scenario("GSP_Mutex", "per_thread", &run);
+		delete [] run.mutexes;
+		delete [] run.counters;
+
+		//--------
+		// GSP_RW at several read/write ratios
+		//--------
+		run.body = rw_body;
+		run.rw = new GSP_RW();
+		for (j = 0; j < (int)(sizeof(read_percents) / sizeof(long)); j++)
+		{
+			run.read_percent = read_percents[j];
+			sprintf(scenario, "reads=%ld%%", read_percents[j]);
+			run_scenario("GSP_RW", scenario, &run);
+		}
+		delete run.rw;
+
+		//--------
+		// GSP_ProdCons, and GSP_BoundedProdCons at several sizes
+		//--------
+		run.body = prodcons_body;
+		run.prodcons = new GSP_ProdCons();
+		run_scenario("GSP_ProdCons", "unbounded", &run);
+		delete run.prodcons;
+
+		run.body = bounded_body;
+		for (j = 0; j < (int)(sizeof(buffer_sizes) / sizeof(int)); j++) {
+			run.bounded = new GSP_BoundedProdCons(buffer_sizes[j]);
+			sprintf(scenario, "size=%d", buffer_sizes[j]);
+			run_scenario("GSP_BoundedProdCons", scenario, &run);
+			delete run.bounded;
+		}
+
+		if (threads == max_threads) {
+			break;
+		}
+	}
+
+	return 0;
+}
@@ -2,6 +2,7 @@
 // File:	gsp_boundedprodcons.h
 //
 // Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+//		LockFreeBoundedProdCons(int size)[PutOp, GetOp]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -38,7 +39,7 @@
 
 #if defined(P_USE_WIN32_THREADS)
 #	include "win_gsp_boundedprodcons.h"
-#elif defined(P_USE_POSIX_THREADS)
+#elif defined(P_USE_POSIX_THREADS) || defined(P_USE_LINUX_FUTEX_THREADS)
 #	include "posix_gsp_boundedprodcons.h"
 #elif defined(P_USE_DCE_THREADS)
 #	include "dce_gsp_boundedprodcons.h"
@@ -54,4 +55,16 @@
 
 
 
+//--------
+// The lock-free variant relies on compiler support for atomic
+// operations, so it is made available only on request.
+//--------
+#if defined(P_USE_LOCKFREE_BOUNDEDPRODCONS)
+#	include "lockfree_gsp_boundedprodcons.h"
+#endif
+
+
+
+
+
 #endif
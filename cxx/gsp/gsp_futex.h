@@ -0,0 +1,217 @@
+//-----------------------------------------------------------------------
+// File:	gsp_futex.h
+//
+// Description:	Wait for, and wake up threads waiting for, a change to
+//		the value of an int. This is the slow path used by the
+//		lock-free GSP classes when they have to block.
+//
+//		gsp_futex_wait(addr, expected) blocks the calling
+//		thread only while "*addr == expected". It may return
+//		spuriously, so callers must re-check their condition.
+//		gsp_futex_timed_wait(addr, expected, timeout_ms) is
+//		similar, but gives up after "timeout_ms" milliseconds.
+//		gsp_futex_wake(addr, count) wakes up to "count" threads
+//		blocked on "addr".
+//
+// Note:	On Linux the operations map directly onto the futex()
+//		system call, and on Windows onto WaitOnAddress() (which
+//		requires Windows 8 or later). On other platforms they
+//		are emulated with a POSIX mutex and condition variable.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef GSP_FUTEX_H_
+#define GSP_FUTEX_H_
+
+
+
+
+
+#if defined(__linux__)
+//--------
+// Linux implementation
+//--------
+#include <unistd.h>
+#include <time.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+inline void
+gsp_futex_wait(volatile int * addr, int expected)
+{
+	syscall(SYS_futex, (int *)addr, FUTEX_WAIT_PRIVATE, expected, 0, 0, 0);
+}
+
+
+inline void
+gsp_futex_timed_wait(volatile int * addr, int expected, long timeout_ms)
+{
+	struct timespec		timeout;
+
+	timeout.tv_sec  = timeout_ms / 1000;
+	timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+	syscall(SYS_futex, (int *)addr, FUTEX_WAIT_PRIVATE, expected,
+		&timeout, 0, 0);
+}
+
+
+inline void
+gsp_futex_wake(volatile int * addr, int count)
+{
+	syscall(SYS_futex, (int *)addr, FUTEX_WAKE_PRIVATE, count, 0, 0, 0);
+}
+
+
+
+
+
+#elif defined(P_USE_WIN32_THREADS)
+//--------
+// Windows implementation
+//--------
+#include <windows.h>
+#include <assert.h>
+#pragma comment(lib, "synchronization.lib")
+
+inline void
+gsp_futex_wait(volatile int * addr, int expected)
+{
+	WaitOnAddress((volatile VOID *)addr, &expected, sizeof(int), INFINITE);
+}
+
+
+inline void
+gsp_futex_timed_wait(volatile int * addr, int expected, long timeout_ms)
+{
+	WaitOnAddress((volatile VOID *)addr, &expected, sizeof(int),
+		      (DWORD)timeout_ms);
+}
+
+
+inline void
+gsp_futex_wake(volatile int * addr, int count)
+{
+	if (count == 1) {
+		WakeByAddressSingle((PVOID)addr);
+	} else {
+		WakeByAddressAll((PVOID)addr);
+	}
+}
+
+
+
+
+
+#else
+//--------
+// Emulation with a POSIX mutex and condition variable. All addresses
+// share one mutex and condition variable, so a wake up is broadcast
+// to every waiting thread. This is acceptable because it is used only
+// on the slow path.
+//--------
+#include "gsp_timeout.h"
+#include <pthread.h>
+#include <errno.h>
+#include <assert.h>
+
+inline pthread_mutex_t *
+gsp_futex_emulation_mutex()
+{
+	static pthread_mutex_t	mutex = PTHREAD_MUTEX_INITIALIZER;
+
+	return &mutex;
+}
+
+
+inline pthread_cond_t *
+gsp_futex_emulation_cond()
+{
+	static pthread_cond_t	cond = PTHREAD_COND_INITIALIZER;
+
+	return &cond;
+}
+
+
+inline void
+gsp_futex_wait(volatile int * addr, int expected)
+{
+	int	status;
+
+	status = pthread_mutex_lock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+
+	if (*addr == expected) {
+		status = pthread_cond_wait(gsp_futex_emulation_cond(),
+					   gsp_futex_emulation_mutex());
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+}
+
+
+inline void
+gsp_futex_timed_wait(volatile int * addr, int expected, long timeout_ms)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	gsp_deadline_init(&deadline, timeout_ms);
+	status = pthread_mutex_lock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+
+	if (*addr == expected) {
+		status = pthread_cond_timedwait(gsp_futex_emulation_cond(),
+						gsp_futex_emulation_mutex(),
+						&deadline);
+		assert(status == 0 || status == ETIMEDOUT);
+	}
+
+	status = pthread_mutex_unlock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+}
+
+
+inline void
+gsp_futex_wake(volatile int * addr, int count)
+{
+	int	status;
+
+	status = pthread_mutex_lock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+
+	status = pthread_cond_broadcast(gsp_futex_emulation_cond());
+	assert(status == 0);
+
+	status = pthread_mutex_unlock(gsp_futex_emulation_mutex());
+	assert(status == 0);
+}
+#endif
+
+
+
+
+
+#endif
@@ -37,6 +37,8 @@
 #	include "win_gsp_mutex.h"
 #elif defined(P_USE_POSIX_THREADS)
 #	include "posix_gsp_mutex.h"
+#elif defined(P_USE_LINUX_FUTEX_THREADS)
+#	include "futex_gsp_mutex.h"
 #elif defined(P_USE_DCE_THREADS)
 #	include "dce_gsp_mutex.h"
 #elif defined(P_USE_SOLARIS_THREADS)
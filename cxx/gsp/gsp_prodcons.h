@@ -38,7 +38,7 @@
 
 #if defined(P_USE_WIN32_THREADS)
 #	include "win_gsp_prodcons.h"
-#elif defined(P_USE_POSIX_THREADS)
+#elif defined(P_USE_POSIX_THREADS) || defined(P_USE_LINUX_FUTEX_THREADS)
 #	include "posix_gsp_prodcons.h"
 #elif defined(P_USE_DCE_THREADS)
 #	include "dce_gsp_prodcons.h"
@@ -54,4 +54,17 @@
 
 
 
+//--------
+// The single-producer, single-consumer queue relies on compiler
+// support for atomic operations, so it is made available only on
+// request.
+//--------
+#if defined(P_USE_LOCKFREE_SPSCQUEUE)
+#	include "lockfree_gsp_spscqueue.h"
+#endif
+
+
+
+
+
 #endif
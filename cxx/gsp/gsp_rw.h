@@ -2,6 +2,9 @@
 // File:	gsp_rw.h
 //
 // Policy:	RW[ReadOp, WriteOp]	// readers-writer lock
+//		DistributedRW[ReadOp, WriteOp]
+//		RW_WriterPref[ReadOp, WriteOp]	// POSIX threads only
+//		RW_PhaseFair[ReadOp, WriteOp]	// POSIX threads only
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -35,8 +38,10 @@
 
 #if defined(P_USE_WIN32_THREADS)
 #	include "win_gsp_rw.h"
-#elif defined(P_USE_POSIX_THREADS)
+#elif defined(P_USE_POSIX_THREADS) || defined(P_USE_LINUX_FUTEX_THREADS)
 #	include "posix_gsp_rw.h"
+#	include "posix_gsp_writerpref_rw.h"
+#	include "posix_gsp_phasefair_rw.h"
 #elif defined(P_USE_DCE_THREADS)
 #	include "dce_gsp_rw.h"
 #elif defined(P_USE_SOLARIS_THREADS)
@@ -51,4 +56,16 @@
 
 
 
+//--------
+// The distributed variant relies on compiler support for atomic
+// operations, so it is made available only on request.
+//--------
+#if defined(P_USE_DISTRIBUTED_RW)
+#	include "distributed_gsp_rw.h"
+#endif
+
+
+
+
+
 #endif
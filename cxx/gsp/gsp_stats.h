@@ -0,0 +1,465 @@
+//-----------------------------------------------------------------------
+// File:	gsp_stats.h
+//
+// Description:	Contention statistics for the GSP classes.
+//
+//		If GSP_ENABLE_STATS is #define'd then each GSP_Mutex,
+//		GSP_RW, GSP_ProdCons and GSP_BoundedProdCons object
+//		contains a GSP_Stats object, which is available through
+//		the stats() operation of the policy. It records:
+//
+//		  - the number of acquisitions (that is, the number of
+//		    scoped operations that entered the critical section)
+//		  - the number of those that first had to wait
+//		  - the total and maximum time spent waiting
+//		  - the number of threads currently waiting
+//
+//		Every GSP_Stats object is kept in a global registry, so
+//		GSP_Stats::dumpAll() can print the statistics of every
+//		instance, and GSP_Stats::forEach() can visit them.
+//		GSP_STATS_LABEL(obj, "name") gives a policy object a
+//		label for use in such reports.
+//
+//		If GSP_ENABLE_STATS is not #define'd then GSP_Stats does
+//		not exist, the GSP_STATS_*() macros expand to nothing,
+//		and the GSP classes are exactly as they would be without
+//		this file.
+//
+// Note:	The counters are updated while the policy's own lock is
+//		held, so they need no extra synchronisation. Reading
+//		them while other threads use the policy gives a snapshot
+//		that might be slightly inconsistent.
+//
+//		Statistics are gathered by the Windows, POSIX, Linux
+//		futex and "no threads" implementations. The DCE and
+//		Solaris implementations, GSP_DistributedRW,
+//		GSP_LockFreeBoundedProdCons and GSP_SPSCQueue do not
+//		gather statistics and have no stats() operation;
+//		GSP_STATS_LABEL() compiles to a no-op for them, so code
+//		that labels its policies works with every implementation.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef GSP_STATS_H_
+#define GSP_STATS_H_
+
+
+
+
+
+#if !defined(GSP_ENABLE_STATS)
+//--------
+// Statistics are disabled: the hooks expand to nothing.
+//--------
+#define GSP_STATS_KIND(stats, kind)
+#define GSP_STATS_WAIT_BEGIN(stats)
+#define GSP_STATS_WAIT_END(stats)
+#define GSP_STATS_WAIT_ABANDON(stats)
+#define GSP_STATS_ACQUIRED(stats)
+#define GSP_STATS_LABEL(obj, label)
+
+#else
+//--------
+// #include's
+//--------
+#include "gsp_atomic.h"
+#include "gsp_timeout.h"
+#include <stdio.h>
+#include <assert.h>
+
+
+
+
+
+//--------
+// Hooks used by the implementations of the GSP classes.
+// GSP_STATS_WAIT_BEGIN() must be followed, in the same block, by
+// GSP_STATS_WAIT_END() once the lock is held or, if a Try or Timed
+// operation gives up, by GSP_STATS_WAIT_ABANDON(). Operations that
+// give up are not counted as acquisitions.
+//--------
+#define GSP_STATS_KIND(stats, kind)	(stats).setKind(kind)
+#define GSP_STATS_WAIT_BEGIN(stats)	\
+		double gsp_stats_wait_start = (stats).beginWait()
+#define GSP_STATS_WAIT_END(stats)	(stats).endWait(gsp_stats_wait_start)
+#define GSP_STATS_WAIT_ABANDON(stats)	\
+		((void)gsp_stats_wait_start, (stats).abandonWait())
+#define GSP_STATS_ACQUIRED(stats)	(stats).acquired()
+#define GSP_STATS_LABEL(obj, label)	gsp_stats_label((obj), (label))
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_Stats;
+
+
+
+
+
+class GSP_Stats {
+public:
+	inline GSP_Stats();
+	inline ~GSP_Stats();
+
+	inline void		setLabel(const char * label);
+	inline const char *	label() const;
+	inline void		setKind(const char * kind);
+	inline const char *	kind() const;
+
+	inline unsigned long	acquisitions() const;
+	inline unsigned long	contendedAcquisitions() const;
+	inline double		totalWaitUsecs() const;
+	inline double		maxWaitUsecs() const;
+	inline long		waiters() const;
+	inline void		reset();
+
+	//--------
+	// Operations on the registry of all GSP_Stats objects.
+	// The registry is locked while forEach() calls "func", so
+	// "func" must not create or destroy GSP objects.
+	//--------
+	inline static void	forEach(
+					void (*func)(const GSP_Stats &, void *),
+					void * arg);
+	inline static void	dumpAll(FILE * out);
+	inline static void	resetAll();
+
+	//--------
+	// Used by the implementations of the GSP classes.
+	//--------
+	inline double		beginWait();
+	inline void		endWait(double start_usecs);
+	inline void		abandonWait();
+	inline void		acquired();
+
+protected:
+	inline static double	nowUsecs();
+	inline static void	dumpOne(const GSP_Stats & stats, void * arg);
+	inline static void	resetOne(const GSP_Stats & stats, void * arg);
+	inline static volatile int *	registryLock();
+	inline static GSP_Stats **	registryHead();
+	inline static void	lockRegistry();
+	inline static void	unlockRegistry();
+
+	const char *		m_label;
+	const char *		m_kind;
+	unsigned long		m_acquisitions;
+	unsigned long		m_contended;
+	double			m_total_wait_usecs;
+	double			m_max_wait_usecs;
+	volatile long		m_waiters;
+	GSP_Stats *		m_prev;
+	GSP_Stats *		m_next;
+
+private:
+	//--------
+	// Not implemented: a GSP_Stats object is part of one policy.
+	//--------
+	GSP_Stats(const GSP_Stats &);
+	GSP_Stats & operator=(const GSP_Stats &);
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Stats
+//--------
+
+inline GSP_Stats::GSP_Stats()
+{
+	m_label            = 0;
+	m_kind             = "GSP";
+	m_acquisitions     = 0;
+	m_contended        = 0;
+	m_total_wait_usecs = 0.0;
+	m_max_wait_usecs   = 0.0;
+	m_waiters          = 0;
+
+	lockRegistry();
+	m_prev = 0;
+	m_next = *registryHead();
+	if (m_next != 0) {
+		m_next->m_prev = this;
+	}
+	*registryHead() = this;
+	unlockRegistry();
+}
+
+
+inline GSP_Stats::~GSP_Stats()
+{
+	lockRegistry();
+	if (m_prev != 0) {
+		m_prev->m_next = m_next;
+	} else {
+		assert(*registryHead() == this);
+		*registryHead() = m_next;
+	}
+	if (m_next != 0) {
+		m_next->m_prev = m_prev;
+	}
+	unlockRegistry();
+}
+
+
+inline void
+GSP_Stats::setLabel(const char * label)
+{
+	m_label = label;
+}
+
+
+inline const char *
+GSP_Stats::label() const
+{
+	return m_label;
+}
+
+
+inline void
+GSP_Stats::setKind(const char * kind)
+{
+	m_kind = kind;
+}
+
+
+inline const char *
+GSP_Stats::kind() const
+{
+	return m_kind;
+}
+
+
+inline unsigned long
+GSP_Stats::acquisitions() const
+{
+	return m_acquisitions;
+}
+
+
+inline unsigned long
+GSP_Stats::contendedAcquisitions() const
+{
+	return m_contended;
+}
+
+
+inline double
+GSP_Stats::totalWaitUsecs() const
+{
+	return m_total_wait_usecs;
+}
+
+
+inline double
+GSP_Stats::maxWaitUsecs() const
+{
+	return m_max_wait_usecs;
+}
+
+
+inline long
+GSP_Stats::waiters() const
+{
+	return gsp_atomic_load(&m_waiters);
+}
+
+
+inline void
+GSP_Stats::reset()
+{
+	m_acquisitions     = 0;
+	m_contended        = 0;
+	m_total_wait_usecs = 0.0;
+	m_max_wait_usecs   = 0.0;
+}
+
+
+inline double
+GSP_Stats::beginWait()
+{
+	gsp_atomic_fetch_add(&m_waiters, 1L);
+	return nowUsecs();
+}
+
+
+inline void
+GSP_Stats::endWait(double start_usecs)
+{
+	double	wait;
+
+	gsp_atomic_fetch_add(&m_waiters, -1L);
+	wait = nowUsecs() - start_usecs;
+	m_contended ++;
+	m_total_wait_usecs += wait;
+	if (wait > m_max_wait_usecs) {
+		m_max_wait_usecs = wait;
+	}
+}
+
+
+inline void
+GSP_Stats::abandonWait()
+{
+	gsp_atomic_fetch_add(&m_waiters, -1L);
+}
+
+
+inline void
+GSP_Stats::acquired()
+{
+	m_acquisitions ++;
+}
+
+
+inline double
+GSP_Stats::nowUsecs()
+{
+	return gsp_now_usecs();
+}
+
+
+inline volatile int *
+GSP_Stats::registryLock()
+{
+	static volatile int	lock = 0;
+
+	return &lock;
+}
+
+
+inline GSP_Stats **
+GSP_Stats::registryHead()
+{
+	static GSP_Stats *	head = 0;
+
+	return &head;
+}
+
+
+inline void
+GSP_Stats::lockRegistry()
+{
+	//--------
+	// A spinlock is sufficient because the registry changes only
+	// when GSP objects are created or destroyed.
+	//--------
+	while (gsp_atomic_exchange(registryLock(), 1) != 0) {
+		gsp_cpu_relax();
+	}
+}
+
+
+inline void
+GSP_Stats::unlockRegistry()
+{
+	gsp_atomic_store(registryLock(), 0);
+}
+
+
+inline void
+GSP_Stats::forEach(void (*func)(const GSP_Stats &, void *), void * arg)
+{
+	GSP_Stats *	stats;
+
+	lockRegistry();
+	for (stats = *registryHead(); stats != 0; stats = stats->m_next) {
+		func(*stats, arg);
+	}
+	unlockRegistry();
+}
+
+
+inline void
+GSP_Stats::dumpOne(const GSP_Stats & stats, void * arg)
+{
+	FILE *		out = (FILE *)arg;
+	double		avg_wait;
+
+	avg_wait = 0.0;
+	if (stats.m_contended > 0) {
+		avg_wait = stats.m_total_wait_usecs / stats.m_contended;
+	}
+	if (stats.m_label != 0) {
+		fprintf(out, "%s", stats.m_label);
+	} else {
+		fprintf(out, "%p", (const void *)&stats);
+	}
+	fprintf(out, " (%s): acquisitions=%lu contended=%lu"
+		" total_wait_us=%.0f avg_wait_us=%.1f max_wait_us=%.0f"
+		" waiters=%ld\n",
+		stats.m_kind, stats.m_acquisitions, stats.m_contended,
+		stats.m_total_wait_usecs, avg_wait, stats.m_max_wait_usecs,
+		stats.waiters());
+}
+
+
+inline void
+GSP_Stats::dumpAll(FILE * out)
+{
+	forEach(dumpOne, out);
+}
+
+
+inline void
+GSP_Stats::resetOne(const GSP_Stats & stats, void *)
+{
+	const_cast<GSP_Stats &>(stats).reset();
+}
+
+
+inline void
+GSP_Stats::resetAll()
+{
+	forEach(resetOne, 0);
+}
+
+
+
+
+
+//--------
+// Used by GSP_STATS_LABEL(). A policy that does not gather statistics
+// provides a non-template overload that does nothing.
+//--------
+template<class POLICY>
+inline void
+gsp_stats_label(POLICY & obj, const char * label)
+{
+	obj.stats().setLabel(label);
+}
+
+#endif /* GSP_ENABLE_STATS */
+
+
+
+
+
+#endif
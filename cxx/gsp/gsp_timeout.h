@@ -0,0 +1,161 @@
+//-----------------------------------------------------------------------
+// File:	gsp_timeout.h
+//
+// Description:	Deadlines for the timed operations of the GSP classes.
+//
+//		gsp_deadline_init(&d, timeout_ms) sets "d" to the point
+//		in time that is "timeout_ms" milliseconds from now, and
+//		gsp_deadline_remaining_ms(&d) returns the number of
+//		milliseconds left before "d" (or 0 if it has passed).
+//		gsp_now_usecs() reads a monotonic clock, in
+//		microseconds, for measuring how long a thread waited.
+//
+// Note:	With POSIX threads a gsp_deadline_t is an absolute
+//		"struct timespec" based on CLOCK_REALTIME, so it can be
+//		passed directly to pthread_cond_timedwait() and
+//		pthread_mutex_timedlock(). With Windows threads it is a
+//		GetTickCount() value.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef GSP_TIMEOUT_H_
+#define GSP_TIMEOUT_H_
+
+
+
+
+
+#if defined(P_USE_WIN32_THREADS)
+//--------
+// Windows implementation
+//--------
+#include <windows.h>
+#include <assert.h>
+
+typedef DWORD	gsp_deadline_t;
+
+inline void
+gsp_deadline_init(gsp_deadline_t * deadline, long timeout_ms)
+{
+	assert(timeout_ms >= 0);
+	*deadline = GetTickCount() + (DWORD)timeout_ms;
+}
+
+
+inline long
+gsp_deadline_remaining_ms(const gsp_deadline_t * deadline)
+{
+	long	remaining;
+
+	//--------
+	// The subtraction wraps around correctly when the tick count
+	// overflows, provided the timeout is less than 24 days.
+	//--------
+	remaining = (long)(*deadline - GetTickCount());
+	if (remaining < 0) {
+		remaining = 0;
+	}
+	return remaining;
+}
+
+
+inline double
+gsp_now_usecs()
+{
+	LARGE_INTEGER	count;
+	LARGE_INTEGER	freq;
+
+	QueryPerformanceCounter(&count);
+	QueryPerformanceFrequency(&freq);
+	return (double)count.QuadPart * 1000000.0 / (double)freq.QuadPart;
+}
+
+
+
+
+
+#else
+//--------
+// POSIX implementation
+//--------
+#include <time.h>
+#include <sys/time.h>
+#include <assert.h>
+
+typedef struct timespec	gsp_deadline_t;
+
+inline void
+gsp_deadline_init(gsp_deadline_t * deadline, long timeout_ms)
+{
+	struct timeval	now;
+
+	assert(timeout_ms >= 0);
+	gettimeofday(&now, 0);
+	deadline->tv_sec  = now.tv_sec + timeout_ms / 1000;
+	deadline->tv_nsec = now.tv_usec * 1000 + (timeout_ms % 1000) * 1000000;
+	if (deadline->tv_nsec >= 1000000000) {
+		deadline->tv_sec ++;
+		deadline->tv_nsec -= 1000000000;
+	}
+}
+
+
+inline long
+gsp_deadline_remaining_ms(const gsp_deadline_t * deadline)
+{
+	struct timeval	now;
+	long		remaining;
+
+	gettimeofday(&now, 0);
+	remaining = (long)(deadline->tv_sec - now.tv_sec) * 1000
+		    + (deadline->tv_nsec / 1000 - now.tv_usec) / 1000;
+	if (remaining < 0) {
+		remaining = 0;
+	}
+	return remaining;
+}
+
+
+inline double
+gsp_now_usecs()
+{
+#if defined(CLOCK_MONOTONIC)
+	struct timespec	now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (double)now.tv_sec * 1000000.0 + (double)now.tv_nsec / 1000.0;
+#else
+	struct timeval	now;
+
+	gettimeofday(&now, 0);
+	return (double)now.tv_sec * 1000000.0 + (double)now.tv_usec;
+#endif
+}
+#endif
+
+
+
+
+
+#endif
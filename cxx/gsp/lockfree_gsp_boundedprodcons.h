@@ -0,0 +1,423 @@
+//-----------------------------------------------------------------------
+// File:	lockfree_gsp_boundedprodcons.h
+//
+// Policy:	LockFreeBoundedProdCons(int size)[PutOp, GetOp]
+//
+// Description:	A lock-free version of the bounded producer-consumer
+//		synchronisation policy.
+//
+//		Unlike GSP_BoundedProdCons, this policy does not
+//		serialise producers and consumers. Instead, PutOp and
+//		GetOp each claim one slot of the buffer, and the slot()
+//		operation tells the caller which element of the buffer
+//		it may access. Because of this, "size" must be a power
+//		of two and the buffer must be used as a ring indexed by
+//		slot(). For example:
+//
+//			GSP_LockFreeBoundedProdCons	m_sync(16);
+//			Elem				m_buf[16];
+//			...
+//			GSP_LockFreeBoundedProdCons::PutOp  scopedLock(m_sync);
+//			m_buf[scopedLock.slot()] = elem;
+//
+//		There is no OtherOp, because nothing excludes PutOp and
+//		GetOp. The count() operation returns a snapshot of the
+//		number of items in the buffer.
+//
+//		A thread blocks only when the buffer is full (PutOp) or
+//		empty (GetOp). It spins for GSP_LOCKFREE_SPIN_COUNT
+//		iterations and then sleeps with gsp_futex_wait().
+//
+// Note:	The algorithm is the bounded MPMC queue by Dmitry
+//		Vyukov, in which every slot carries a sequence number.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+
+#ifndef LOCKFREE_GSP_BOUNDEDPRODCONS_H_
+#define LOCKFREE_GSP_BOUNDEDPRODCONS_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_atomic.h"
+#include "gsp_futex.h"
+#include "gsp_stats.h"
+#include <assert.h>
+
+
+
+
+
+//--------
+// Number of times to re-check a full/empty buffer before sleeping.
+//--------
+#if !defined(GSP_LOCKFREE_SPIN_COUNT)
+#	define GSP_LOCKFREE_SPIN_COUNT	100
+#endif
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_LockFreeBoundedProdCons;
+
+
+
+
+
+class GSP_LockFreeBoundedProdCons {
+public:
+	inline GSP_LockFreeBoundedProdCons(int size);
+	inline ~GSP_LockFreeBoundedProdCons();
+
+	inline long count();
+
+	class PutOp {
+	public:
+		inline PutOp(GSP_LockFreeBoundedProdCons &);
+		inline ~PutOp();
+
+		inline long slot() const;
+
+	protected:
+		GSP_LockFreeBoundedProdCons	&m_sync;
+		unsigned long			m_pos;
+	};
+
+	class GetOp {
+	public:
+		inline GetOp(GSP_LockFreeBoundedProdCons &);
+		inline ~GetOp();
+
+		inline long slot() const;
+
+	protected:
+		GSP_LockFreeBoundedProdCons	&m_sync;
+		unsigned long			m_pos;
+	};
+
+protected:
+	friend class	::GSP_LockFreeBoundedProdCons::PutOp;
+	friend class	::GSP_LockFreeBoundedProdCons::GetOp;
+
+	struct Cell {
+		volatile unsigned long	m_seq;
+	};
+
+	inline int  isFull();
+	inline int  isEmpty();
+	inline void waitUntilNotFull();
+	inline void waitUntilNotEmpty();
+	inline void wakeWaiter(volatile int & seq, volatile int & waiters);
+
+	//--------
+	// The enqueue/dequeue positions and the wait counters are each
+	// kept in their own cache line.
+	//--------
+	Cell *			m_cells;
+	unsigned long		m_mask;
+	char			m_pad0[GSP_CACHE_LINE_SIZE];
+	volatile unsigned long	m_enqueue_pos;
+	char			m_pad1[GSP_CACHE_LINE_SIZE];
+	volatile unsigned long	m_dequeue_pos;
+	char			m_pad2[GSP_CACHE_LINE_SIZE];
+	volatile int		m_not_empty_seq;
+	volatile int		m_not_empty_waiters;
+	char			m_pad3[GSP_CACHE_LINE_SIZE];
+	volatile int		m_not_full_seq;
+	volatile int		m_not_full_waiters;
+	char			m_pad4[GSP_CACHE_LINE_SIZE];
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_LockFreeBoundedProdCons
+//--------
+
+inline GSP_LockFreeBoundedProdCons::GSP_LockFreeBoundedProdCons(int size)
+{
+	unsigned long	i;
+
+	assert(size > 0 && (size & (size - 1)) == 0); // power of two
+
+	m_cells = new Cell[size];
+	for (i = 0; i < (unsigned long)size; i++) {
+		m_cells[i].m_seq = i;
+	}
+	m_mask              = size - 1;
+	m_enqueue_pos       = 0;
+	m_dequeue_pos       = 0;
+	m_not_empty_seq     = 0;
+	m_not_empty_waiters = 0;
+	m_not_full_seq      = 0;
+	m_not_full_waiters  = 0;
+}
+
+
+inline GSP_LockFreeBoundedProdCons::~GSP_LockFreeBoundedProdCons()
+{
+	assert(m_not_empty_waiters == 0);
+	assert(m_not_full_waiters == 0);
+	delete [] m_cells;
+}
+
+
+inline long
+GSP_LockFreeBoundedProdCons::count()
+{
+	long		result;
+
+	result = (long)(gsp_atomic_load(&m_enqueue_pos)
+			- gsp_atomic_load(&m_dequeue_pos));
+	if (result < 0) {
+		result = 0;
+	} else if (result > (long)m_mask + 1) {
+		result = (long)m_mask + 1;
+	}
+	return result;
+}
+
+
+inline int
+GSP_LockFreeBoundedProdCons::isFull()
+{
+	unsigned long	pos;
+	unsigned long	seq;
+
+	pos = gsp_atomic_load(&m_enqueue_pos);
+	seq = gsp_atomic_load(&m_cells[pos & m_mask].m_seq);
+	return (long)(seq - pos) < 0;
+}
+
+
+inline int
+GSP_LockFreeBoundedProdCons::isEmpty()
+{
+	unsigned long	pos;
+	unsigned long	seq;
+
+	pos = gsp_atomic_load(&m_dequeue_pos);
+	seq = gsp_atomic_load(&m_cells[pos & m_mask].m_seq);
+	return (long)(seq - (pos + 1)) < 0;
+}
+
+
+inline void
+GSP_LockFreeBoundedProdCons::waitUntilNotFull()
+{
+	int	i;
+	int	seq;
+
+	for (i = 0; i < GSP_LOCKFREE_SPIN_COUNT; i++) {
+		if (!isFull()) {
+			return;
+		}
+		gsp_cpu_relax();
+	}
+
+	//--------
+	// Register as a waiter before re-checking, so a consumer that
+	// frees a slot after our check is guaranteed to see us.
+	//--------
+	gsp_atomic_fetch_add(&m_not_full_waiters, 1);
+	gsp_memory_barrier();
+	for (;;) {
+		seq = gsp_atomic_load(&m_not_full_seq);
+		if (!isFull()) {
+			break;
+		}
+		gsp_futex_wait(&m_not_full_seq, seq);
+	}
+	gsp_atomic_fetch_add(&m_not_full_waiters, -1);
+}
+
+
+inline void
+GSP_LockFreeBoundedProdCons::waitUntilNotEmpty()
+{
+	int	i;
+	int	seq;
+
+	for (i = 0; i < GSP_LOCKFREE_SPIN_COUNT; i++) {
+		if (!isEmpty()) {
+			return;
+		}
+		gsp_cpu_relax();
+	}
+
+	gsp_atomic_fetch_add(&m_not_empty_waiters, 1);
+	gsp_memory_barrier();
+	for (;;) {
+		seq = gsp_atomic_load(&m_not_empty_seq);
+		if (!isEmpty()) {
+			break;
+		}
+		gsp_futex_wait(&m_not_empty_seq, seq);
+	}
+	gsp_atomic_fetch_add(&m_not_empty_waiters, -1);
+}
+
+
+inline void
+GSP_LockFreeBoundedProdCons::wakeWaiter(
+	volatile int &		seq,
+	volatile int &		waiters)
+{
+	//--------
+	// The barrier orders the caller's update of a slot's sequence
+	// number before the read of "waiters". No system call is made
+	// unless a thread has registered as a waiter.
+	//--------
+	gsp_memory_barrier();
+	if (gsp_atomic_load(&waiters) > 0) {
+		gsp_atomic_fetch_add(&seq, 1);
+		gsp_futex_wake(&seq, 1);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_LockFreeBoundedProdCons::PutOp
+//--------
+
+inline GSP_LockFreeBoundedProdCons::PutOp::PutOp(
+	GSP_LockFreeBoundedProdCons &	sync_data)
+	: m_sync(sync_data)
+{
+	unsigned long	pos;
+	unsigned long	seq;
+	long		diff;
+
+	pos = gsp_atomic_load(&m_sync.m_enqueue_pos);
+	for (;;) {
+		seq = gsp_atomic_load(&m_sync.m_cells[pos & m_sync.m_mask].m_seq);
+		diff = (long)(seq - pos);
+		if (diff == 0) {
+			if (gsp_atomic_cas(&m_sync.m_enqueue_pos, pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			m_sync.waitUntilNotFull();
+		}
+		pos = gsp_atomic_load(&m_sync.m_enqueue_pos);
+	}
+	m_pos = pos;
+}
+
+
+inline GSP_LockFreeBoundedProdCons::PutOp::~PutOp()
+{
+	gsp_atomic_store(&m_sync.m_cells[m_pos & m_sync.m_mask].m_seq,
+			 m_pos + 1);
+	m_sync.wakeWaiter(m_sync.m_not_empty_seq, m_sync.m_not_empty_waiters);
+}
+
+
+inline long
+GSP_LockFreeBoundedProdCons::PutOp::slot() const
+{
+	return (long)(m_pos & m_sync.m_mask);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_LockFreeBoundedProdCons::GetOp
+//--------
+
+inline GSP_LockFreeBoundedProdCons::GetOp::GetOp(
+	GSP_LockFreeBoundedProdCons &	sync_data)
+	: m_sync(sync_data)
+{
+	unsigned long	pos;
+	unsigned long	seq;
+	long		diff;
+
+	pos = gsp_atomic_load(&m_sync.m_dequeue_pos);
+	for (;;) {
+		seq = gsp_atomic_load(&m_sync.m_cells[pos & m_sync.m_mask].m_seq);
+		diff = (long)(seq - (pos + 1));
+		if (diff == 0) {
+			if (gsp_atomic_cas(&m_sync.m_dequeue_pos, pos, pos + 1)) {
+				break;
+			}
+		} else if (diff < 0) {
+			m_sync.waitUntilNotEmpty();
+		}
+		pos = gsp_atomic_load(&m_sync.m_dequeue_pos);
+	}
+	m_pos = pos;
+}
+
+
+inline GSP_LockFreeBoundedProdCons::GetOp::~GetOp()
+{
+	gsp_atomic_store(&m_sync.m_cells[m_pos & m_sync.m_mask].m_seq,
+			 m_pos + m_sync.m_mask + 1);
+	m_sync.wakeWaiter(m_sync.m_not_full_seq, m_sync.m_not_full_waiters);
+}
+
+
+inline long
+GSP_LockFreeBoundedProdCons::GetOp::slot() const
+{
+	return (long)(m_pos & m_sync.m_mask);
+}
+
+
+
+
+
+//--------
+// GSP_LockFreeBoundedProdCons does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_LockFreeBoundedProdCons &, const char *)
+{
+}
+#endif
+
+
+
+
+
+#endif
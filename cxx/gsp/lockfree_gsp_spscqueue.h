@@ -0,0 +1,446 @@
+//-----------------------------------------------------------------------
+// File:	lockfree_gsp_spscqueue.h
+//
+// Class:	GSP_SPSCQueue<T, N>
+//
+// Description:	A lock-free, bounded queue of N items of type T, for
+//		use by exactly ONE producer thread and ONE consumer
+//		thread. N must be a power of two, and T must have a
+//		default constructor and an assignment operator.
+//
+//		GSP_ProdCons and GSP_BoundedProdCons serialise every
+//		operation with a mutex. When there is only one producer
+//		and one consumer, neither a mutex nor an atomic
+//		read-modify-write is needed: the producer is the only
+//		writer of the tail index, the consumer is the only
+//		writer of the head index, and each publishes its index
+//		with a release store that the other reads with an
+//		acquire load. The two indices are kept in separate
+//		cache lines, and each side caches the last value it
+//		read of the other side's index, so the cache line of
+//		the other side is touched only when the queue looks
+//		full (producer) or empty (consumer). For example:
+//
+//			GSP_SPSCQueue<Request *, 1024>	queue;
+//			...
+//			queue.push(req);	// in the producer thread
+//			...
+//			queue.pop(req);		// in the consumer thread
+//
+//		tryPush() and tryPop() never wait. push() and pop()
+//		wait while the queue is full or empty. pushBatch() and
+//		popBatch() transfer several items, but publish the new
+//		index (and wake up the other thread) only once.
+//
+//		A waiting thread spins for GSP_LOCKFREE_SPIN_COUNT
+//		iterations. After that, if the queue was constructed
+//		with "blocking" set to true (the default), it sleeps
+//		with gsp_futex_wait(). Otherwise it keeps spinning,
+//		which saves the producer and consumer a memory barrier
+//		per operation, and so suits threads that have a CPU to
+//		themselves.
+//
+// Copyright 2006 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+
+#ifndef LOCKFREE_GSP_SPSCQUEUE_H_
+#define LOCKFREE_GSP_SPSCQUEUE_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_atomic.h"
+#include "gsp_futex.h"
+#include "gsp_stats.h"
+#include <assert.h>
+
+
+
+
+
+//--------
+// Number of times to re-check a full/empty queue before sleeping.
+//--------
+#if !defined(GSP_LOCKFREE_SPIN_COUNT)
+#	define GSP_LOCKFREE_SPIN_COUNT	100
+#endif
+
+
+
+
+
+template<class T, unsigned long N>
+class GSP_SPSCQueue {
+public:
+	inline GSP_SPSCQueue(bool blocking = true);
+	inline ~GSP_SPSCQueue();
+
+	//--------
+	// Operations for the producer thread
+	//--------
+	inline bool		tryPush(const T & item);
+	inline void		push(const T & item);
+	inline unsigned long	tryPushBatch(const T * items,
+					     unsigned long count);
+	inline void		pushBatch(const T * items, unsigned long count);
+
+	//--------
+	// Operations for the consumer thread. popBatch() waits for at
+	// least one item and returns the number of items it got.
+	//--------
+	inline bool		tryPop(T & item);
+	inline void		pop(T & item);
+	inline unsigned long	tryPopBatch(T * items, unsigned long max);
+	inline unsigned long	popBatch(T * items, unsigned long max);
+
+	//--------
+	// A snapshot of the number of items in the queue
+	//--------
+	inline unsigned long	count() const;
+
+protected:
+	inline void	waitUntilNotFull();
+	inline void	waitUntilNotEmpty();
+	inline void	wakeWaiter(volatile int & seq, volatile int & waiter);
+
+	//--------
+	// The producer's and the consumer's data, and the two wait
+	// flags, are each kept in their own cache line.
+	//--------
+	bool			m_blocking;
+	char			m_pad0[GSP_CACHE_LINE_SIZE];
+	volatile unsigned long	m_tail;		// written by the producer
+	unsigned long		m_cached_head;
+	char			m_pad1[GSP_CACHE_LINE_SIZE];
+	volatile unsigned long	m_head;		// written by the consumer
+	unsigned long		m_cached_tail;
+	char			m_pad2[GSP_CACHE_LINE_SIZE];
+	volatile int		m_not_empty_seq;
+	volatile int		m_not_empty_waiter;
+	char			m_pad3[GSP_CACHE_LINE_SIZE];
+	volatile int		m_not_full_seq;
+	volatile int		m_not_full_waiter;
+	char			m_pad4[GSP_CACHE_LINE_SIZE];
+	T			m_buf[N];
+
+private:
+	//--------
+	// Not implemented: the queue is shared by two threads, not copied.
+	//--------
+	GSP_SPSCQueue(const GSP_SPSCQueue &);
+	GSP_SPSCQueue & operator=(const GSP_SPSCQueue &);
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_SPSCQueue
+//--------
+
+template<class T, unsigned long N>
+inline
+GSP_SPSCQueue<T, N>::GSP_SPSCQueue(bool blocking)
+{
+	assert(N > 0 && (N & (N - 1)) == 0); // power of two
+
+	m_blocking         = blocking;
+	m_tail             = 0;
+	m_cached_head      = 0;
+	m_head             = 0;
+	m_cached_tail      = 0;
+	m_not_empty_seq    = 0;
+	m_not_empty_waiter = 0;
+	m_not_full_seq     = 0;
+	m_not_full_waiter  = 0;
+}
+
+
+template<class T, unsigned long N>
+inline
+GSP_SPSCQueue<T, N>::~GSP_SPSCQueue()
+{
+	assert(m_not_empty_waiter == 0);
+	assert(m_not_full_waiter == 0);
+}
+
+
+template<class T, unsigned long N>
+inline bool
+GSP_SPSCQueue<T, N>::tryPush(const T & item)
+{
+	return tryPushBatch(&item, 1) == 1;
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::push(const T & item)
+{
+	while (tryPushBatch(&item, 1) == 0) {
+		waitUntilNotFull();
+	}
+}
+
+
+template<class T, unsigned long N>
+inline unsigned long
+GSP_SPSCQueue<T, N>::tryPushBatch(const T * items, unsigned long count)
+{
+	unsigned long	tail;
+	unsigned long	space;
+	unsigned long	i;
+
+	//--------
+	// Only the producer writes m_tail, so it can read it without
+	// synchronisation. m_head is re-read only when the cached
+	// value says there is not enough space.
+	//--------
+	tail = m_tail;
+	space = N - (tail - m_cached_head);
+	if (space < count) {
+		m_cached_head = gsp_atomic_load(&m_head);
+		space = N - (tail - m_cached_head);
+	}
+	if (count > space) {
+		count = space;
+	}
+	if (count == 0) {
+		return 0;
+	}
+
+	for (i = 0; i < count; i++) {
+		m_buf[(tail + i) & (N - 1)] = items[i];
+	}
+	gsp_atomic_store(&m_tail, tail + count);
+	wakeWaiter(m_not_empty_seq, m_not_empty_waiter);
+	return count;
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::pushBatch(const T * items, unsigned long count)
+{
+	unsigned long	n;
+
+	while (count > 0) {
+		n = tryPushBatch(items, count);
+		if (n == 0) {
+			waitUntilNotFull();
+		}
+		items += n;
+		count -= n;
+	}
+}
+
+
+template<class T, unsigned long N>
+inline bool
+GSP_SPSCQueue<T, N>::tryPop(T & item)
+{
+	return tryPopBatch(&item, 1) == 1;
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::pop(T & item)
+{
+	while (tryPopBatch(&item, 1) == 0) {
+		waitUntilNotEmpty();
+	}
+}
+
+
+template<class T, unsigned long N>
+inline unsigned long
+GSP_SPSCQueue<T, N>::tryPopBatch(T * items, unsigned long max)
+{
+	unsigned long	head;
+	unsigned long	avail;
+	unsigned long	i;
+
+	head = m_head;
+	avail = m_cached_tail - head;
+	if (avail < max) {
+		m_cached_tail = gsp_atomic_load(&m_tail);
+		avail = m_cached_tail - head;
+	}
+	if (max > avail) {
+		max = avail;
+	}
+	if (max == 0) {
+		return 0;
+	}
+
+	for (i = 0; i < max; i++) {
+		items[i] = m_buf[(head + i) & (N - 1)];
+	}
+	gsp_atomic_store(&m_head, head + max);
+	wakeWaiter(m_not_full_seq, m_not_full_waiter);
+	return max;
+}
+
+
+template<class T, unsigned long N>
+inline unsigned long
+GSP_SPSCQueue<T, N>::popBatch(T * items, unsigned long max)
+{
+	unsigned long	n;
+
+	assert(max > 0);
+	while ((n = tryPopBatch(items, max)) == 0) {
+		waitUntilNotEmpty();
+	}
+	return n;
+}
+
+
+template<class T, unsigned long N>
+inline unsigned long
+GSP_SPSCQueue<T, N>::count() const
+{
+	unsigned long	head;
+
+	head = gsp_atomic_load(&m_head);
+	return gsp_atomic_load(&m_tail) - head;
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::waitUntilNotFull()
+{
+	int	i;
+	int	seq;
+
+	for (i = 0; i < GSP_LOCKFREE_SPIN_COUNT; i++) {
+		if (m_tail - gsp_atomic_load(&m_head) < N) {
+			return;
+		}
+		gsp_cpu_relax();
+	}
+	if (!m_blocking) {
+		while (m_tail - gsp_atomic_load(&m_head) >= N) {
+			gsp_cpu_relax();
+		}
+		return;
+	}
+
+	//--------
+	// Register as the waiter before re-checking, so a consumer
+	// that frees a slot after our check is guaranteed to see us.
+	//--------
+	gsp_atomic_store(&m_not_full_waiter, 1);
+	gsp_memory_barrier();
+	for (;;) {
+		seq = gsp_atomic_load(&m_not_full_seq);
+		if (m_tail - gsp_atomic_load(&m_head) < N) {
+			break;
+		}
+		gsp_futex_wait(&m_not_full_seq, seq);
+	}
+	gsp_atomic_store(&m_not_full_waiter, 0);
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::waitUntilNotEmpty()
+{
+	int	i;
+	int	seq;
+
+	for (i = 0; i < GSP_LOCKFREE_SPIN_COUNT; i++) {
+		if (gsp_atomic_load(&m_tail) != m_head) {
+			return;
+		}
+		gsp_cpu_relax();
+	}
+	if (!m_blocking) {
+		while (gsp_atomic_load(&m_tail) == m_head) {
+			gsp_cpu_relax();
+		}
+		return;
+	}
+
+	gsp_atomic_store(&m_not_empty_waiter, 1);
+	gsp_memory_barrier();
+	for (;;) {
+		seq = gsp_atomic_load(&m_not_empty_seq);
+		if (gsp_atomic_load(&m_tail) != m_head) {
+			break;
+		}
+		gsp_futex_wait(&m_not_empty_seq, seq);
+	}
+	gsp_atomic_store(&m_not_empty_waiter, 0);
+}
+
+
+template<class T, unsigned long N>
+inline void
+GSP_SPSCQueue<T, N>::wakeWaiter(volatile int & seq, volatile int & waiter)
+{
+	//--------
+	// The barrier orders the caller's store of its index before
+	// the read of "waiter". No system call is made unless the
+	// other thread has registered as the waiter.
+	//--------
+	if (!m_blocking) {
+		return;
+	}
+	gsp_memory_barrier();
+	if (gsp_atomic_load(&waiter) != 0) {
+		gsp_atomic_fetch_add(&seq, 1);
+		gsp_futex_wake(&seq, 1);
+	}
+}
+
+
+
+
+
+//--------
+// GSP_SPSCQueue does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+template<class T, unsigned long N>
+inline void
+gsp_stats_label(GSP_SPSCQueue<T, N> &, const char *)
+{
+}
+#endif
+
+
+
+
+
+#endif
@@ -1,7 +1,10 @@
 //-----------------------------------------------------------------------
 // File:	posix_gsp_boundedprodcons.h
 //
-// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp,
+//			PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			TryPutOp, TimedPutOp(long timeout_ms),
+//			TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The bounded producer-consumer synchronisation policy.
 //
@@ -39,7 +42,10 @@
 //--------
 // #include's
 //--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
 #include <pthread.h>
+#include <errno.h>
 #include <assert.h>
 
 
@@ -59,6 +65,9 @@ class GSP_BoundedProdCons {
 public:
 	inline GSP_BoundedProdCons(int size);
 	inline ~GSP_BoundedProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class PutOp {
 	public:
@@ -87,16 +96,110 @@ public:
 		GSP_BoundedProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp waits until there are "n" free slots and puts
+	// "n" items with one lock acquisition. GetBatchOp waits until
+	// there is at least one item and then gets up to "max" items;
+	// "got" is set to the number actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_BoundedProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_BoundedProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_got;
+	};
+
+	//--------
+	// The Try operations do not block, and the Timed operations
+	// block for at most "timeout_ms" milliseconds. The caller must
+	// check acquired() before entering the critical section.
+	//--------
+	class TryPutOp {
+	public:
+		inline TryPutOp(GSP_BoundedProdCons &);
+		inline ~TryPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedPutOp {
+	public:
+		inline TimedPutOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_BoundedProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
 protected:
 	friend class	::GSP_BoundedProdCons::PutOp;
 	friend class	::GSP_BoundedProdCons::GetOp;
 	friend class	::GSP_BoundedProdCons::OtherOp;
+	friend class	::GSP_BoundedProdCons::PutBatchOp;
+	friend class	::GSP_BoundedProdCons::GetBatchOp;
+	friend class	::GSP_BoundedProdCons::TryPutOp;
+	friend class	::GSP_BoundedProdCons::TimedPutOp;
+	friend class	::GSP_BoundedProdCons::TryGetOp;
+	friend class	::GSP_BoundedProdCons::TimedGetOp;
+
+	inline static void wakeUp(pthread_cond_t * cond, long waiting, long n);
+	inline bool acquirePut(long timeout_ms);
+	inline void releasePut();
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	pthread_mutex_t	m_mutex;
 	pthread_cond_t	m_notEmpty;
 	pthread_cond_t	m_notFull;
 	long		m_item_count;
 	long		m_buf_size;
+	long		m_get_waiting_count;
+	long		m_put_waiting_count;
+	long		m_batch_put_waiting_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -113,6 +216,9 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 
 	m_item_count = 0;
 	m_buf_size = size;
+	m_get_waiting_count = 0;
+	m_put_waiting_count = 0;
+	m_batch_put_waiting_count = 0;
 
 	status = pthread_mutex_init(&m_mutex, (pthread_mutexattr_t *)0);
 	assert(status == 0);
@@ -122,6 +228,8 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 
 	status = pthread_cond_init(&this->m_notFull, (pthread_condattr_t *)0);
 	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_BoundedProdCons");
 }
 
 
@@ -140,39 +248,198 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_BoundedProdCons::stats()
+{
+	return m_stats;
+}
+#endif
 
 
+inline void
+GSP_BoundedProdCons::wakeUp(pthread_cond_t * cond, long waiting, long n)
+{
+	int	status;
+	long	i;
+
+	if (n >= waiting) {
+		if (waiting > 0) {
+			status = pthread_cond_broadcast(cond);
+			assert(status == 0);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			status = pthread_cond_signal(cond);
+			assert(status == 0);
+		}
+	}
+}
+
 
 //--------
-// Inline implementation of class GSP_BoundedProdCons::PutOp
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. A "timeout_ms" of 0 means do not wait. If the
+// wait times out then the condition is checked one last time, in case
+// a thread signalled the condition variable just as the wait timed out.
 //--------
 
-inline GSP_BoundedProdCons::PutOp::PutOp(GSP_BoundedProdCons &sync_data)
-	: m_sync(sync_data)
+inline bool
+GSP_BoundedProdCons::acquirePut(long timeout_ms)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	if (m_item_count == m_buf_size && timeout_ms > 0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		gsp_deadline_init(&deadline, timeout_ms);
+		m_put_waiting_count ++;
+		while (m_item_count == m_buf_size) {
+			status = pthread_cond_timedwait(&m_notFull, &m_mutex,
+							&deadline);
+			assert(status == 0 || status == ETIMEDOUT);
+			if (status == ETIMEDOUT) {
+				break;
+			}
+		}
+		m_put_waiting_count --;
+#if defined(GSP_ENABLE_STATS)
+		if (m_item_count == m_buf_size) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+		} else {
+			GSP_STATS_WAIT_END(m_stats);
+		}
+#endif
+	}
+
+	if (m_item_count == m_buf_size) {
+		status = pthread_mutex_unlock(&m_mutex);
+		assert(status == 0);
+		return false;
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_BoundedProdCons::releasePut()
 {
 	int	status;
 
-	status = pthread_mutex_lock(&m_sync.m_mutex);
+	m_item_count ++;
+
+	status = pthread_mutex_unlock(&m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_item_count == m_sync.m_buf_size) {
-		status = pthread_cond_wait(&m_sync.m_notFull, &m_sync.m_mutex);
+	status = pthread_cond_signal(&m_notEmpty);
+	assert(status == 0);
+}
+
+
+inline bool
+GSP_BoundedProdCons::acquireGet(long timeout_ms)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	if (m_item_count == 0 && timeout_ms > 0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		gsp_deadline_init(&deadline, timeout_ms);
+		m_get_waiting_count ++;
+		while (m_item_count == 0) {
+			status = pthread_cond_timedwait(&m_notEmpty, &m_mutex,
+							&deadline);
+			assert(status == 0 || status == ETIMEDOUT);
+			if (status == ETIMEDOUT) {
+				break;
+			}
+		}
+		m_get_waiting_count --;
+#if defined(GSP_ENABLE_STATS)
+		if (m_item_count == 0) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+		} else {
+			GSP_STATS_WAIT_END(m_stats);
+		}
+#endif
+	}
+
+	if (m_item_count == 0) {
+		status = pthread_mutex_unlock(&m_mutex);
 		assert(status == 0);
+		return false;
 	}
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
 }
 
 
-inline GSP_BoundedProdCons::PutOp::~PutOp()
+inline void
+GSP_BoundedProdCons::releaseGet()
 {
 	int	status;
+	long	batch_waiting;
 
-	m_sync.m_item_count ++;
+	m_item_count --;
+	batch_waiting = m_batch_put_waiting_count;
 
-	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+
+	//--------
+	// A batch producer might need more than the one slot we have
+	// freed, so a signal might wake it instead of a producer
+	// that could proceed. Wake everyone in that case.
+	//--------
+	if (batch_waiting > 0) {
+		status = pthread_cond_broadcast(&m_notFull);
+	} else {
+		status = pthread_cond_signal(&m_notFull);
+	}
 	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutOp
+//--------
+
+inline GSP_BoundedProdCons::PutOp::PutOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	int	status;
 
-	status = pthread_cond_signal(&m_sync.m_notEmpty);
+	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+
+	if (m_sync.m_item_count == m_sync.m_buf_size) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_put_waiting_count ++;
+		while (m_sync.m_item_count == m_sync.m_buf_size) {
+			status = pthread_cond_wait(&m_sync.m_notFull,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_put_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_BoundedProdCons::PutOp::~PutOp()
+{
+	m_sync.releasePut();
 }
 
 
@@ -191,24 +458,103 @@ inline GSP_BoundedProdCons::GetOp::GetOp(GSP_BoundedProdCons &sync_data)
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_item_count == 0) {
-		status = pthread_cond_wait(&m_sync.m_notEmpty, &m_sync.m_mutex);
-		assert(status == 0);
+	if (m_sync.m_item_count == 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_item_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
 	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
 inline GSP_BoundedProdCons::GetOp::~GetOp()
+{
+	m_sync.releaseGet();
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::OtherOp
+//--------
+
+inline GSP_BoundedProdCons::OtherOp::OtherOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
 {
 	int	status;
 
-	m_sync.m_item_count --;
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_BoundedProdCons::OtherOp::~OtherOp()
+{
+	int	status;
 
 	status = pthread_mutex_unlock(&m_sync.m_mutex);
 	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutBatchOp
+//--------
+
+inline GSP_BoundedProdCons::PutBatchOp::PutBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	int	status;
 
-	status = pthread_cond_signal(&m_sync.m_notFull);
+	assert(n >= 0 && n <= m_sync.m_buf_size);
+	m_n = n;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+
+	if (m_sync.m_buf_size - m_sync.m_item_count < m_n) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_put_waiting_count ++;
+		m_sync.m_batch_put_waiting_count ++;
+		while (m_sync.m_buf_size - m_sync.m_item_count < m_n) {
+			status = pthread_cond_wait(&m_sync.m_notFull,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_batch_put_waiting_count --;
+		m_sync.m_put_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_BoundedProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	waiting;
+
+	m_sync.m_item_count += m_n;
+	waiting = m_sync.m_get_waiting_count;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	wakeUp(&m_sync.m_notEmpty, waiting, m_n);
 }
 
 
@@ -216,25 +562,179 @@ inline GSP_BoundedProdCons::GetOp::~GetOp()
 
 
 //--------
-// Inline implementation of class GSP_BoundedProdCons::OtherOp
+// Inline implementation of class GSP_BoundedProdCons::GetBatchOp
 //--------
 
-inline GSP_BoundedProdCons::OtherOp::OtherOp(GSP_BoundedProdCons &sync_data)
+inline GSP_BoundedProdCons::GetBatchOp::GetBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			max,
+	long &			got)
 	: m_sync(sync_data)
 {
 	int	status;
 
+	assert(max > 0);
+
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+
+	if (m_sync.m_item_count == 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_item_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	m_got = (m_sync.m_item_count < max) ? m_sync.m_item_count : max;
+	got = m_got;
 }
 
 
-inline GSP_BoundedProdCons::OtherOp::~OtherOp()
+inline GSP_BoundedProdCons::GetBatchOp::~GetBatchOp()
 {
 	int	status;
+	long	waiting;
+	long	batch_waiting;
+
+	m_sync.m_item_count -= m_got;
+	waiting = m_sync.m_put_waiting_count;
+	batch_waiting = m_sync.m_batch_put_waiting_count;
 
 	status = pthread_mutex_unlock(&m_sync.m_mutex);
 	assert(status == 0);
+
+	if (batch_waiting > 0) {
+		status = pthread_cond_broadcast(&m_sync.m_notFull);
+		assert(status == 0);
+	} else {
+		wakeUp(&m_sync.m_notFull, waiting, m_got);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryPutOp
+//--------
+
+inline GSP_BoundedProdCons::TryPutOp::TryPutOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(0);
+}
+
+
+inline GSP_BoundedProdCons::TryPutOp::~TryPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedPutOp
+//--------
+
+inline GSP_BoundedProdCons::TimedPutOp::TimedPutOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedPutOp::~TimedPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryGetOp
+//--------
+
+inline GSP_BoundedProdCons::TryGetOp::TryGetOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_BoundedProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedGetOp
+//--------
+
+inline GSP_BoundedProdCons::TimedGetOp::TimedGetOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
 }
 
 
@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	posix_gsp_mutex.h
 //
-// Policy:	GSP_Mutex[Op]	// non-recursive mutex
+// Policy:	GSP_Mutex[Op, TryOp, TimedOp(long timeout_ms)]
+//		// non-recursive mutex
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -36,7 +37,10 @@
 //--------
 // #include's
 //--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
 #include <pthread.h>
+#include <errno.h>
 #include <assert.h>
 
 
@@ -56,6 +60,9 @@ class GSP_Mutex {
 public:
 	inline GSP_Mutex();
 	inline ~GSP_Mutex();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
  
 	class Op {
 	public:
@@ -65,10 +72,43 @@ public:
 	protected:
 		GSP_Mutex	&m_sync;
 	};
+
+	//--------
+	// TryOp does not block, and TimedOp blocks for at most
+	// "timeout_ms" milliseconds. The caller must check acquired()
+	// before entering the critical section.
+	//--------
+	class TryOp {
+	public:
+		inline TryOp(GSP_Mutex &);
+		inline ~TryOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedOp {
+	public:
+		inline TimedOp(GSP_Mutex &, long timeout_ms);
+		inline ~TimedOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex	&m_sync;
+		bool		m_acquired;
+	};
  
 protected:
 	friend class	Op;
+	friend class	TryOp;
+	friend class	TimedOp;
 	pthread_mutex_t m_mutex;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -85,6 +125,8 @@ inline GSP_Mutex::GSP_Mutex()
 
 	status = pthread_mutex_init(&m_mutex, (pthread_mutexattr_t *)0);
 	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_Mutex");
 }
 
 
@@ -97,6 +139,15 @@ inline GSP_Mutex::~GSP_Mutex()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_Mutex::stats()
+{
+	return m_stats;
+}
+#endif
+
+
 
 
 
@@ -109,8 +160,18 @@ inline GSP_Mutex::Op::Op(GSP_Mutex &sync_data)
 {
 	int status;
 
+#if defined(GSP_ENABLE_STATS)
+	if (pthread_mutex_trylock(&m_sync.m_mutex) != 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		status = pthread_mutex_lock(&m_sync.m_mutex);
+		assert(status == 0);
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+#endif
 }
 
 
@@ -126,4 +187,97 @@ inline GSP_Mutex::Op::~Op()
 
 
 
+//--------
+// Inline implementation of class GSP_Mutex::TryOp
+//--------
+
+inline GSP_Mutex::TryOp::TryOp(GSP_Mutex &sync_data)
+        : m_sync(sync_data)
+{
+	int status;
+
+	status = pthread_mutex_trylock(&m_sync.m_mutex);
+	assert(status == 0 || status == EBUSY);
+	m_acquired = (status == 0);
+	if (m_acquired) {
+		GSP_STATS_ACQUIRED(m_sync.m_stats);
+	}
+}
+
+
+inline GSP_Mutex::TryOp::~TryOp()
+{
+	int status;
+
+	if (m_acquired) {
+		status = pthread_mutex_unlock(&m_sync.m_mutex);
+		assert(status == 0);
+	}
+}
+
+
+inline bool
+GSP_Mutex::TryOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::TimedOp
+//--------
+
+inline GSP_Mutex::TimedOp::TimedOp(GSP_Mutex &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	gsp_deadline_init(&deadline, timeout_ms);
+#if defined(GSP_ENABLE_STATS)
+	status = pthread_mutex_trylock(&m_sync.m_mutex);
+	if (status != 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		status = pthread_mutex_timedlock(&m_sync.m_mutex, &deadline);
+		if (status == 0) {
+			GSP_STATS_WAIT_END(m_sync.m_stats);
+		} else {
+			GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+		}
+	}
+#else
+	status = pthread_mutex_timedlock(&m_sync.m_mutex, &deadline);
+#endif
+	assert(status == 0 || status == ETIMEDOUT);
+	m_acquired = (status == 0);
+	if (m_acquired) {
+		GSP_STATS_ACQUIRED(m_sync.m_stats);
+	}
+}
+
+
+inline GSP_Mutex::TimedOp::~TimedOp()
+{
+	int status;
+
+	if (m_acquired) {
+		status = pthread_mutex_unlock(&m_sync.m_mutex);
+		assert(status == 0);
+	}
+}
+
+
+inline bool
+GSP_Mutex::TimedOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
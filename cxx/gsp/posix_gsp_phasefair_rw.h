@@ -0,0 +1,367 @@
+//-----------------------------------------------------------------------
+// File:	posix_gsp_phasefair_rw.h
+//
+// Policy:	RW_PhaseFair[ReadOp, WriteOp]	// readers-writer lock
+//
+// Description:	A phase-fair readers-writer lock: reader phases and
+//		writer phases alternate, so neither readers nor writers
+//		can be starved.
+//
+//		Once a writer is waiting, newly arriving readers wait.
+//		When a writer releases the lock, all the readers that
+//		were waiting are admitted together, as one reader
+//		phase, even if other writers are waiting. The next
+//		writer gets the lock as soon as those readers have
+//		finished. Thus a writer waits for at most one reader
+//		phase and one writer phase (plus the writers queued
+//		ahead of it), and a reader waits for at most one writer
+//		phase.
+//
+//		maxWriterWaitUsecs() returns the longest time, in
+//		microseconds, that a WriteOp has waited for the lock
+//		since the lock was created or resetMaxWriterWait() was
+//		last called.
+//
+// Copyright 2006 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef POSIX_GSP_PHASEFAIR_RW_H_
+#define POSIX_GSP_PHASEFAIR_RW_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
+#include <pthread.h>
+#include <assert.h>
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_RW_PhaseFair;
+
+
+
+
+
+class GSP_RW_PhaseFair {
+public:
+	inline GSP_RW_PhaseFair();
+	inline ~GSP_RW_PhaseFair();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
+
+	inline double maxWriterWaitUsecs();
+	inline void resetMaxWriterWait();
+
+	class ReadOp {
+	public:
+		inline ReadOp(GSP_RW_PhaseFair &);
+		inline ~ReadOp();
+
+	protected:
+		GSP_RW_PhaseFair	&m_sync;
+	};
+
+	class WriteOp {
+	public:
+		inline WriteOp(GSP_RW_PhaseFair &);
+		inline ~WriteOp();
+
+	protected:
+		GSP_RW_PhaseFair	&m_sync;
+	};
+
+protected:
+	friend  class ::GSP_RW_PhaseFair::ReadOp;
+	friend  class ::GSP_RW_PhaseFair::WriteOp;
+
+	pthread_mutex_t	m_mutex;
+	pthread_cond_t	m_read_cond;
+	pthread_cond_t	m_write_cond;
+	int		m_reader_count;
+	int		m_writer_count;		// really a boolean
+	int		m_reader_waiting_count;
+	int		m_writer_waiting_count;
+	unsigned long	m_reader_phase;		// number of admissions
+	double		m_max_writer_wait_usecs;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_PhaseFair
+//--------
+
+inline GSP_RW_PhaseFair::GSP_RW_PhaseFair()
+{
+	int	status;
+
+	m_reader_count          = 0;
+	m_writer_count          = 0;
+	m_reader_waiting_count  = 0;
+	m_writer_waiting_count  = 0;
+	m_reader_phase          = 0;
+	m_max_writer_wait_usecs = 0.0;
+
+	status = pthread_mutex_init(&m_mutex, 0);
+	assert(status == 0);
+
+	status = pthread_cond_init(&m_read_cond, 0);
+	assert(status == 0);
+
+	status = pthread_cond_init(&m_write_cond, 0);
+	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_RW_PhaseFair");
+}
+
+
+
+inline GSP_RW_PhaseFair::~GSP_RW_PhaseFair()
+{
+	int	status;
+
+	//--------
+	// Sanity checks
+	//--------
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+		assert(m_reader_count == 0);
+		assert(m_writer_count == 0);
+		assert(m_reader_waiting_count == 0);
+		assert(m_writer_waiting_count == 0);
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+
+	//--------
+	// Now destroy everything
+	//--------
+	status = pthread_mutex_destroy(&m_mutex);
+	assert(status == 0);
+
+	status = pthread_cond_destroy(&m_read_cond);
+	assert(status == 0);
+
+	status = pthread_cond_destroy(&m_write_cond);
+	assert(status == 0);
+}
+
+
+
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_RW_PhaseFair::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+
+inline double
+GSP_RW_PhaseFair::maxWriterWaitUsecs()
+{
+	int	status;
+	double	result;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+	result = m_max_writer_wait_usecs;
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+	return result;
+}
+
+
+
+inline void
+GSP_RW_PhaseFair::resetMaxWriterWait()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+	m_max_writer_wait_usecs = 0.0;
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_PhaseFair::ReadOp
+//--------
+
+inline GSP_RW_PhaseFair::ReadOp::ReadOp(GSP_RW_PhaseFair &sync_data)
+        : m_sync(sync_data)
+{
+	int		status;
+	unsigned long	phase;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	//--------
+	// If a writer holds or is waiting for the lock then wait to be
+	// admitted by the writer that next releases the lock. It
+	// increments m_reader_count on behalf of the waiting readers.
+	//--------
+	if (m_sync.m_writer_count || m_sync.m_writer_waiting_count > 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		phase = m_sync.m_reader_phase;
+		m_sync.m_reader_waiting_count ++;
+
+		while (m_sync.m_reader_phase == phase) {
+			status = pthread_cond_wait(&m_sync.m_read_cond,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		m_sync.m_reader_count ++;
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_RW_PhaseFair::ReadOp::~ReadOp()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	m_sync.m_reader_count --;
+
+	if (m_sync.m_reader_count == 0 && m_sync.m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_sync.m_write_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_PhaseFair::WriteOp
+//--------
+
+inline GSP_RW_PhaseFair::WriteOp::WriteOp(GSP_RW_PhaseFair &sync_data)
+        : m_sync(sync_data)
+{
+	int	status;
+	double	start;
+	double	wait;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		start = gsp_now_usecs();
+		m_sync.m_writer_waiting_count ++;
+		while (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
+			status = pthread_cond_wait(&m_sync.m_write_cond,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_writer_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+
+		wait = gsp_now_usecs() - start;
+		if (wait > m_sync.m_max_writer_wait_usecs) {
+			m_sync.m_max_writer_wait_usecs = wait;
+		}
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	assert(m_sync.m_writer_count == 0);
+	m_sync.m_writer_count = 1;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_RW_PhaseFair::WriteOp::~WriteOp()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	assert(m_sync.m_writer_count == 1);
+	m_sync.m_writer_count = 0;
+
+	//--------
+	// Admit all the waiting readers as one phase. If there are
+	// none then hand the lock to another writer, if there is one.
+	//--------
+	if (m_sync.m_reader_waiting_count > 0) {
+		m_sync.m_reader_count += m_sync.m_reader_waiting_count;
+		m_sync.m_reader_waiting_count = 0;
+		m_sync.m_reader_phase ++;
+		status = pthread_cond_broadcast(&m_sync.m_read_cond);
+		assert(status == 0);
+	} else if (m_sync.m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_sync.m_write_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+#endif
@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	posix_gsp_prodcons.h
 //
-// Policy:	ProdCons[PutOp, GetOp, OtherOp]
+// Policy:	ProdCons[PutOp, GetOp, OtherOp,
+//			 PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			 TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -42,7 +44,10 @@
 //--------
 // #include's
 //--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
 #include <pthread.h>
+#include <errno.h>
 #include <assert.h>
 
 
@@ -62,6 +67,9 @@ class GSP_ProdCons {
 public:
 	inline GSP_ProdCons();
 	inline ~GSP_ProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class PutOp {
 	public:
@@ -90,14 +98,80 @@ public:
 		GSP_ProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp puts "n" items with one lock acquisition.
+	// GetBatchOp waits until there is at least one item and
+	// then gets up to "max" items; "got" is set to the number
+	// actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_ProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_ProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_got;
+	};
+
+	//--------
+	// TryGetOp does not block, and TimedGetOp blocks for at most
+	// "timeout_ms" milliseconds. The caller must check acquired()
+	// before entering the critical section.
+	//--------
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_ProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_ProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend class	::GSP_ProdCons::PutOp;
 	friend class	::GSP_ProdCons::GetOp;
 	friend class	::GSP_ProdCons::OtherOp;
+	friend class	::GSP_ProdCons::PutBatchOp;
+	friend class	::GSP_ProdCons::GetBatchOp;
+	friend class	::GSP_ProdCons::TryGetOp;
+	friend class	::GSP_ProdCons::TimedGetOp;
+
+	inline static void wakeUp(pthread_cond_t * cond, long waiting, long n);
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	pthread_mutex_t	m_mutex;
 	pthread_cond_t	m_notEmpty;
 	long		m_count;
+	long		m_get_waiting_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -116,9 +190,12 @@ inline GSP_ProdCons::GSP_ProdCons()
 	assert(status == 0);
 
 	m_count = 0;
+	m_get_waiting_count = 0;
 
 	status = pthread_cond_init(&this->m_notEmpty, (pthread_condattr_t *)0);
 	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_ProdCons");
 }
 
 
@@ -134,6 +211,95 @@ inline GSP_ProdCons::~GSP_ProdCons()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_ProdCons::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+inline void
+GSP_ProdCons::wakeUp(pthread_cond_t * cond, long waiting, long n)
+{
+	int	status;
+	long	i;
+
+	if (n >= waiting) {
+		if (waiting > 0) {
+			status = pthread_cond_broadcast(cond);
+			assert(status == 0);
+		}
+	} else {
+		for (i = 0; i < n; i++) {
+			status = pthread_cond_signal(cond);
+			assert(status == 0);
+		}
+	}
+}
+
+
+//--------
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. A "timeout_ms" of 0 means do not wait. If the
+// wait times out then the condition is checked one last time, in case
+// a thread signalled the condition variable just as the wait timed out.
+//--------
+
+inline bool
+GSP_ProdCons::acquireGet(long timeout_ms)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	if (m_count == 0 && timeout_ms > 0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		gsp_deadline_init(&deadline, timeout_ms);
+		m_get_waiting_count ++;
+		while (m_count == 0) {
+			status = pthread_cond_timedwait(&m_notEmpty, &m_mutex,
+							&deadline);
+			assert(status == 0 || status == ETIMEDOUT);
+			if (status == ETIMEDOUT) {
+				break;
+			}
+		}
+		m_get_waiting_count --;
+#if defined(GSP_ENABLE_STATS)
+		if (m_count == 0) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+		} else {
+			GSP_STATS_WAIT_END(m_stats);
+		}
+#endif
+	}
+
+	if (m_count == 0) {
+		status = pthread_mutex_unlock(&m_mutex);
+		assert(status == 0);
+		return false;
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_ProdCons::releaseGet()
+{
+	int	status;
+
+	m_count --;
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+}
+
+
 
 
 
@@ -148,6 +314,7 @@ inline GSP_ProdCons::PutOp::PutOp(GSP_ProdCons &sync_data)
 
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -180,18 +347,48 @@ inline GSP_ProdCons::GetOp::GetOp(GSP_ProdCons &sync_data)
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
 
-	while (m_sync.m_count == 0) {
-		status = pthread_cond_wait(&m_sync.m_notEmpty, &m_sync.m_mutex);
-		assert(status == 0);
+	if (m_sync.m_count == 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
 	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
 inline GSP_ProdCons::GetOp::~GetOp()
+{
+	m_sync.releaseGet();
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::OtherOp
+//--------
+
+inline GSP_ProdCons::OtherOp::OtherOp(GSP_ProdCons &sync_data)
+	: m_sync(sync_data)
 {
 	int	status;
 
-	m_sync.m_count --;
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_ProdCons::OtherOp::~OtherOp()
+{
+	int	status;
 
 	status = pthread_mutex_unlock(&m_sync.m_mutex);
 	assert(status == 0);
@@ -202,23 +399,82 @@ inline GSP_ProdCons::GetOp::~GetOp()
 
 
 //--------
-// Inline implementation of class GSP_ProdCons::OtherOp
+// Inline implementation of class GSP_ProdCons::PutBatchOp
 //--------
 
-inline GSP_ProdCons::OtherOp::OtherOp(GSP_ProdCons &sync_data)
+inline GSP_ProdCons::PutBatchOp::PutBatchOp(GSP_ProdCons &sync_data, long n)
 	: m_sync(sync_data)
 {
 	int	status;
 
+	assert(n >= 0);
+	m_n = n;
+
 	status = pthread_mutex_lock(&m_sync.m_mutex);
 	assert(status == 0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
-inline GSP_ProdCons::OtherOp::~OtherOp()
+inline GSP_ProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	waiting;
+
+	m_sync.m_count += m_n;
+	waiting = m_sync.m_get_waiting_count;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	wakeUp(&m_sync.m_notEmpty, waiting, m_n);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::GetBatchOp
+//--------
+
+inline GSP_ProdCons::GetBatchOp::GetBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(max > 0);
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_count == 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_get_waiting_count ++;
+		while (m_sync.m_count == 0) {
+			status = pthread_cond_wait(&m_sync.m_notEmpty,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_get_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	m_got = (m_sync.m_count < max) ? m_sync.m_count : max;
+	got = m_got;
+}
+
+
+inline GSP_ProdCons::GetBatchOp::~GetBatchOp()
 {
 	int	status;
 
+	m_sync.m_count -= m_got;
+
 	status = pthread_mutex_unlock(&m_sync.m_mutex);
 	assert(status == 0);
 }
@@ -227,4 +483,64 @@ inline GSP_ProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_ProdCons::TryGetOp
+//--------
+
+inline GSP_ProdCons::TryGetOp::TryGetOp(GSP_ProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_ProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::TimedGetOp
+//--------
+
+inline GSP_ProdCons::TimedGetOp::TimedGetOp(
+	GSP_ProdCons &		sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_ProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
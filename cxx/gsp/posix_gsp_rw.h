@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	posix_gsp_rw.h
 //
-// Policy:	RW[ReadOp, WriteOp]	// readers-writer lock
+// Policy:	RW[ReadOp, WriteOp, TryReadOp, TryWriteOp,
+//		   TimedReadOp(long timeout_ms), TimedWriteOp(long timeout_ms)]
+//		// readers-writer lock
 //
 // Note:	The algorithm is taken from "Programming with POSIX
 //		Threads" by David R. Butenhof
@@ -39,7 +41,10 @@
 //--------
 // #include's
 //--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
 #include <pthread.h>
+#include <errno.h>
 #include <assert.h>
 
 
@@ -59,6 +64,9 @@ class GSP_RW {
 public:
 	inline GSP_RW();
 	inline ~GSP_RW();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class ReadOp {
 	public:
@@ -78,9 +86,68 @@ public:
 		GSP_RW      &m_sync;
 	};
 
+	//--------
+	// The Try and Timed variants do not block, or block for at most
+	// "timeout_ms" milliseconds, respectively. The caller must check
+	// acquired() before entering the critical section.
+	//--------
+	class TryReadOp {
+	public:
+		inline TryReadOp(GSP_RW &);
+		inline ~TryReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedReadOp {
+	public:
+		inline TimedReadOp(GSP_RW &, long timeout_ms);
+		inline ~TimedReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TryWriteOp {
+	public:
+		inline TryWriteOp(GSP_RW &);
+		inline ~TryWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedWriteOp {
+	public:
+		inline TimedWriteOp(GSP_RW &, long timeout_ms);
+		inline ~TimedWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend  class ::GSP_RW::ReadOp;
 	friend  class ::GSP_RW::WriteOp;
+	friend  class ::GSP_RW::TryReadOp;
+	friend  class ::GSP_RW::TimedReadOp;
+	friend  class ::GSP_RW::TryWriteOp;
+	friend  class ::GSP_RW::TimedWriteOp;
+
+	inline bool acquireRead(long timeout_ms);
+	inline void releaseRead();
+	inline bool acquireWrite(long timeout_ms);
+	inline void releaseWrite();
+
 	pthread_mutex_t	m_mutex;
 	pthread_cond_t	m_read_cond;
 	pthread_cond_t	m_write_cond;
@@ -88,6 +155,10 @@ protected:
 	int		m_writer_count;		// really a boolean
 	int		m_reader_waiting_count;
 	int		m_writer_waiting_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -115,6 +186,8 @@ inline GSP_RW::GSP_RW()
 
 	status = pthread_cond_init(&m_write_cond, 0);
 	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_RW");
 }
 
 
@@ -150,6 +223,161 @@ inline GSP_RW::~GSP_RW()
 
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_RW::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+
+//--------
+// acquireRead() and acquireWrite() are used by the Try and Timed
+// operations. A "timeout_ms" of 0 means do not wait. If the wait
+// times out then the condition is checked one last time, in case a
+// thread signalled the condition variable just as the wait timed out.
+//--------
+
+inline bool
+GSP_RW::acquireRead(long timeout_ms)
+{
+	int		status;
+	bool		acquired;
+	gsp_deadline_t	deadline;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	if (m_writer_count && timeout_ms > 0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		gsp_deadline_init(&deadline, timeout_ms);
+		m_reader_waiting_count ++;
+
+		while (m_writer_count) {
+			status = pthread_cond_timedwait(&m_read_cond, &m_mutex,
+							&deadline);
+			assert(status == 0 || status == ETIMEDOUT);
+			if (status == ETIMEDOUT) {
+				break;
+			}
+		}
+
+		m_reader_waiting_count --;
+#if defined(GSP_ENABLE_STATS)
+		if (m_writer_count) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+		} else {
+			GSP_STATS_WAIT_END(m_stats);
+		}
+#endif
+	}
+
+	acquired = !m_writer_count;
+	if (acquired) {
+		m_reader_count ++;
+		GSP_STATS_ACQUIRED(m_stats);
+	}
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+	return acquired;
+}
+
+
+
+inline void
+GSP_RW::releaseRead()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	m_reader_count --;
+
+	if (m_reader_count == 0 && m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_write_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline bool
+GSP_RW::acquireWrite(long timeout_ms)
+{
+	int		status;
+	bool		acquired;
+	gsp_deadline_t	deadline;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	if ((m_writer_count || m_reader_count > 0) && timeout_ms > 0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		gsp_deadline_init(&deadline, timeout_ms);
+		m_writer_waiting_count ++;
+		while (m_writer_count || m_reader_count > 0) {
+			status = pthread_cond_timedwait(&m_write_cond,
+							&m_mutex, &deadline);
+			assert(status == 0 || status == ETIMEDOUT);
+			if (status == ETIMEDOUT) {
+				break;
+			}
+		}
+		m_writer_waiting_count --;
+#if defined(GSP_ENABLE_STATS)
+		if (m_writer_count || m_reader_count > 0) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+		} else {
+			GSP_STATS_WAIT_END(m_stats);
+		}
+#endif
+	}
+
+	acquired = (!m_writer_count && m_reader_count == 0);
+	if (acquired) {
+		m_writer_count = 1;
+		GSP_STATS_ACQUIRED(m_stats);
+	}
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+	return acquired;
+}
+
+
+
+inline void
+GSP_RW::releaseWrite()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	assert(m_writer_count == 1);
+	m_writer_count = 0;
+
+	if (m_reader_waiting_count > 0) {
+		status = pthread_cond_broadcast(&m_read_cond);
+		assert(status == 0);
+	} else if (m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_write_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+}
+
+
+
 
 
 //--------
@@ -165,6 +393,7 @@ inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
 	assert(status == 0);
 
 	if (m_sync.m_writer_count) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
 		m_sync.m_reader_waiting_count ++;
 
 		while (m_sync.m_writer_count) {
@@ -174,7 +403,9 @@ inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
 		}
 
 		m_sync.m_reader_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
 	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 
 	m_sync.m_reader_count ++;
 
@@ -186,20 +417,7 @@ inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
 
 inline GSP_RW::ReadOp::~ReadOp()
 {
-	int	status;
-
-	status = pthread_mutex_lock(&m_sync.m_mutex);
-	assert(status == 0);
-
-	m_sync.m_reader_count --;
-
-	if (m_sync.m_reader_count == 0 && m_sync.m_writer_waiting_count > 0) {
-			status = pthread_cond_signal(&m_sync.m_write_cond);
-			assert(status == 0);
-	}
-
-	status = pthread_mutex_unlock(&m_sync.m_mutex);
-	assert(status == 0);
+	m_sync.releaseRead();
 }
 
 
@@ -219,6 +437,7 @@ inline GSP_RW::WriteOp::WriteOp(GSP_RW &sync_data)
 	assert(status == 0);
 
 	if (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
 		m_sync.m_writer_waiting_count ++;
 		while (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
 			status = pthread_cond_wait(&m_sync.m_write_cond,
@@ -226,7 +445,9 @@ inline GSP_RW::WriteOp::WriteOp(GSP_RW &sync_data)
 			assert(status == 0);
 		}
 		m_sync.m_writer_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
 	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 
 	assert(m_sync.m_writer_count == 0);
 	m_sync.m_writer_count = 1;
@@ -239,24 +460,131 @@ inline GSP_RW::WriteOp::WriteOp(GSP_RW &sync_data)
 
 inline GSP_RW::WriteOp::~WriteOp()
 {
-	int	status;
+	m_sync.releaseWrite();
+}
 
-	status = pthread_mutex_lock(&m_sync.m_mutex);
-	assert(status == 0);
 
-	assert(m_sync.m_writer_count == 1);
-	m_sync.m_writer_count = 0;
 
-	if (m_sync.m_reader_waiting_count > 0) {
-		status = pthread_cond_broadcast(&m_sync.m_read_cond);
-		assert(status == 0);
-	} else if (m_sync.m_writer_waiting_count > 0) {
-		status = pthread_cond_signal(&m_sync.m_write_cond);
-		assert(status == 0);
+
+
+//--------
+// Inline implementation of class GSP_RW::TryReadOp
+//--------
+
+inline GSP_RW::TryReadOp::TryReadOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(0);
+}
+
+
+
+inline GSP_RW::TryReadOp::~TryReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
 	}
+}
 
-	status = pthread_mutex_unlock(&m_sync.m_mutex);
-	assert(status == 0);
+
+
+inline bool
+GSP_RW::TryReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedReadOp
+//--------
+
+inline GSP_RW::TimedReadOp::TimedReadOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedReadOp::~TimedReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TryWriteOp
+//--------
+
+inline GSP_RW::TryWriteOp::TryWriteOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(0);
+}
+
+
+
+inline GSP_RW::TryWriteOp::~TryWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TryWriteOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedWriteOp
+//--------
+
+inline GSP_RW::TimedWriteOp::TimedWriteOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedWriteOp::~TimedWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedWriteOp::acquired() const
+{
+	return m_acquired;
 }
 
 
@@ -0,0 +1,281 @@
+//-----------------------------------------------------------------------
+// File:	posix_gsp_shardedcounter.h
+//
+// Class:	ShardedCounter[add(long delta), increment(), sum()]
+//
+// Description:	A counter that many threads can update without
+//		contending with each other, for hit counts, total
+//		latencies and similar statistics.
+//
+//		Protecting a shared counter with a GSP_Mutex serialises
+//		every update, and even an atomic increment makes the
+//		counter's cache line bounce between CPUs. Instead,
+//		GSP_ShardedCounter gives each thread its own shard, in
+//		its own cache line, which it finds through a POSIX
+//		thread-specific data key. add() and increment() update
+//		the calling thread's shard with an ordinary store, so
+//		they need neither a lock nor an atomic read-modify-write.
+//		sum() locks the counter and adds up all the shards; it
+//		is the slow operation.
+//
+//		The first update by a thread allocates its shard. When
+//		the thread terminates, the value of its shard is folded
+//		into the counter and the shard is freed.
+//
+// Note:	Each counter uses one thread-specific data key, and a
+//		process can have at most PTHREAD_KEYS_MAX (at least 128)
+//		keys, so this class suits a modest number of long-lived
+//		counters, ideally ones that live as long as the process.
+//
+//		A counter must outlive every thread that updated it,
+//		except the thread that destroys it. The shard of a
+//		thread is folded into the counter when the thread
+//		terminates, which needs the counter, and the destructor
+//		frees the shards that remain.
+//
+// Copyright 2006 Ciaran McHale.
+// 
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+// 
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.  
+// 
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef POSIX_GSP_SHARDEDCOUNTER_H_
+#define POSIX_GSP_SHARDEDCOUNTER_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_atomic.h"
+#include <pthread.h>
+#include <assert.h>
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_ShardedCounter;
+
+
+
+
+
+class GSP_ShardedCounter {
+public:
+	inline GSP_ShardedCounter();
+	inline ~GSP_ShardedCounter();
+
+	inline void add(long delta);
+	inline void increment();
+	inline long sum();
+
+protected:
+	//--------
+	// The padding keeps each shard's value in a cache line of its
+	// own, whatever the alignment of the memory returned by "new".
+	//--------
+	struct Shard {
+		char			m_pad0[GSP_CACHE_LINE_SIZE];
+		volatile long		m_value;
+		GSP_ShardedCounter *	m_owner;
+		Shard *			m_prev;
+		Shard *			m_next;
+		char			m_pad1[GSP_CACHE_LINE_SIZE];
+	};
+
+	inline Shard * newShard();
+	inline static void threadExit(void * shard);
+
+	pthread_key_t	m_key;
+	pthread_mutex_t	m_mutex;	// protects m_shards and m_retired
+	Shard *		m_shards;
+	long		m_retired;	// total of terminated threads
+
+private:
+	//--------
+	// Not implemented
+	//--------
+	GSP_ShardedCounter(const GSP_ShardedCounter &);
+	GSP_ShardedCounter & operator=(const GSP_ShardedCounter &);
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ShardedCounter
+//--------
+
+inline GSP_ShardedCounter::GSP_ShardedCounter()
+{
+	int	status;
+
+	m_shards  = 0;
+	m_retired = 0;
+
+	status = pthread_mutex_init(&m_mutex, 0);
+	assert(status == 0);
+
+	status = pthread_key_create(&m_key, threadExit);
+	assert(status == 0);
+}
+
+
+inline GSP_ShardedCounter::~GSP_ShardedCounter()
+{
+	int	status;
+	Shard *	shard;
+
+	//--------
+	// Deleting the key stops threadExit() being called for it, so
+	// the remaining shards can be freed here. (Only the calling
+	// thread should have one; see the note at the top of the file.)
+	//--------
+	status = pthread_key_delete(m_key);
+	assert(status == 0);
+
+	while (m_shards != 0) {
+		shard = m_shards;
+		m_shards = shard->m_next;
+		delete shard;
+	}
+
+	status = pthread_mutex_destroy(&m_mutex);
+	assert(status == 0);
+}
+
+
+inline void
+GSP_ShardedCounter::add(long delta)
+{
+	Shard *	shard;
+
+	shard = (Shard *)pthread_getspecific(m_key);
+	if (shard == 0) {
+		shard = newShard();
+	}
+
+	//--------
+	// Only this thread writes the shard. The release store lets
+	// sum() read the value without tearing, but is not a
+	// read-modify-write.
+	//--------
+	gsp_atomic_store(&shard->m_value, shard->m_value + delta);
+}
+
+
+inline void
+GSP_ShardedCounter::increment()
+{
+	add(1);
+}
+
+
+inline long
+GSP_ShardedCounter::sum()
+{
+	int	status;
+	long	total;
+	Shard *	shard;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	total = m_retired;
+	for (shard = m_shards; shard != 0; shard = shard->m_next) {
+		total += gsp_atomic_load(&shard->m_value);
+	}
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+	return total;
+}
+
+
+inline GSP_ShardedCounter::Shard *
+GSP_ShardedCounter::newShard()
+{
+	int	status;
+	Shard *	shard;
+
+	shard = new Shard();
+	shard->m_value = 0;
+	shard->m_owner = this;
+	shard->m_prev  = 0;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+
+	shard->m_next = m_shards;
+	if (m_shards != 0) {
+		m_shards->m_prev = shard;
+	}
+	m_shards = shard;
+
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+
+	status = pthread_setspecific(m_key, shard);
+	assert(status == 0);
+	return shard;
+}
+
+
+inline void
+GSP_ShardedCounter::threadExit(void * p)
+{
+	int			status;
+	Shard *			shard;
+	GSP_ShardedCounter *	owner;
+
+	shard = (Shard *)p;
+	owner = shard->m_owner;
+
+	status = pthread_mutex_lock(&owner->m_mutex);
+	assert(status == 0);
+
+	owner->m_retired += shard->m_value;
+	if (shard->m_prev != 0) {
+		shard->m_prev->m_next = shard->m_next;
+	} else {
+		owner->m_shards = shard->m_next;
+	}
+	if (shard->m_next != 0) {
+		shard->m_next->m_prev = shard->m_prev;
+	}
+
+	status = pthread_mutex_unlock(&owner->m_mutex);
+	assert(status == 0);
+
+	delete shard;
+}
+
+
+
+
+
+#endif
@@ -0,0 +1,357 @@
+//-----------------------------------------------------------------------
+// File:	posix_gsp_writerpref_rw.h
+//
+// Policy:	RW_WriterPref[ReadOp, WriteOp]	// readers-writer lock
+//
+// Description:	A readers-writer lock that prefers writers. GSP_RW
+//		wakes up waiting readers before waiting writers, so a
+//		steady stream of readers can starve a writer. In
+//		GSP_RW_WriterPref, a new reader waits while a writer
+//		holds the lock or is waiting for it, and a writer that
+//		releases the lock hands it to another waiting writer
+//		before it wakes up readers. The price is that a steady
+//		stream of writers can starve readers; GSP_RW_PhaseFair
+//		avoids starvation of either.
+//
+//		maxWriterWaitUsecs() returns the longest time, in
+//		microseconds, that a WriteOp has waited for the lock
+//		since the lock was created or resetMaxWriterWait() was
+//		last called.
+//
+// Copyright 2006 Ciaran McHale.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a
+// copy of this software and associated documentation files (the
+// "Software"), to deal in the Software without restriction, including
+// without limitation the rights to use, copy, modify, merge, publish,
+// distribute, sublicense, and/or sell copies of the Software, and to
+// permit persons to whom the Software is furnished to do so, subject to
+// the following conditions:
+//
+//	The above copyright notice and this permission notice shall be
+//	included in all copies or substantial portions of the Software.
+//
+//	THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+//	EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+//	OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+//	NONINFRINGEMENT.  IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+//	HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+//	WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+//	FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+//	OTHER DEALINGS IN THE SOFTWARE.
+//----------------------------------------------------------------------
+
+#ifndef POSIX_GSP_WRITERPREF_RW_H_
+#define POSIX_GSP_WRITERPREF_RW_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
+#include <pthread.h>
+#include <assert.h>
+
+
+
+
+
+//--------
+// Forward declarations.
+//--------
+class GSP_RW_WriterPref;
+
+
+
+
+
+class GSP_RW_WriterPref {
+public:
+	inline GSP_RW_WriterPref();
+	inline ~GSP_RW_WriterPref();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
+
+	inline double maxWriterWaitUsecs();
+	inline void resetMaxWriterWait();
+
+	class ReadOp {
+	public:
+		inline ReadOp(GSP_RW_WriterPref &);
+		inline ~ReadOp();
+
+	protected:
+		GSP_RW_WriterPref	&m_sync;
+	};
+
+	class WriteOp {
+	public:
+		inline WriteOp(GSP_RW_WriterPref &);
+		inline ~WriteOp();
+
+	protected:
+		GSP_RW_WriterPref	&m_sync;
+	};
+
+protected:
+	friend  class ::GSP_RW_WriterPref::ReadOp;
+	friend  class ::GSP_RW_WriterPref::WriteOp;
+
+	pthread_mutex_t	m_mutex;
+	pthread_cond_t	m_read_cond;
+	pthread_cond_t	m_write_cond;
+	int		m_reader_count;
+	int		m_writer_count;		// really a boolean
+	int		m_reader_waiting_count;
+	int		m_writer_waiting_count;
+	double		m_max_writer_wait_usecs;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
+};
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_WriterPref
+//--------
+
+inline GSP_RW_WriterPref::GSP_RW_WriterPref()
+{
+	int	status;
+
+	m_reader_count          = 0;
+	m_writer_count          = 0;
+	m_reader_waiting_count  = 0;
+	m_writer_waiting_count  = 0;
+	m_max_writer_wait_usecs = 0.0;
+
+	status = pthread_mutex_init(&m_mutex, 0);
+	assert(status == 0);
+
+	status = pthread_cond_init(&m_read_cond, 0);
+	assert(status == 0);
+
+	status = pthread_cond_init(&m_write_cond, 0);
+	assert(status == 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_RW_WriterPref");
+}
+
+
+
+inline GSP_RW_WriterPref::~GSP_RW_WriterPref()
+{
+	int	status;
+
+	//--------
+	// Sanity checks
+	//--------
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+		assert(m_reader_count == 0);
+		assert(m_writer_count == 0);
+		assert(m_reader_waiting_count == 0);
+		assert(m_writer_waiting_count == 0);
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+
+	//--------
+	// Now destroy everything
+	//--------
+	status = pthread_mutex_destroy(&m_mutex);
+	assert(status == 0);
+
+	status = pthread_cond_destroy(&m_read_cond);
+	assert(status == 0);
+
+	status = pthread_cond_destroy(&m_write_cond);
+	assert(status == 0);
+}
+
+
+
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_RW_WriterPref::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+
+inline double
+GSP_RW_WriterPref::maxWriterWaitUsecs()
+{
+	int	status;
+	double	result;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+	result = m_max_writer_wait_usecs;
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+	return result;
+}
+
+
+
+inline void
+GSP_RW_WriterPref::resetMaxWriterWait()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_mutex);
+	assert(status == 0);
+	m_max_writer_wait_usecs = 0.0;
+	status = pthread_mutex_unlock(&m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_WriterPref::ReadOp
+//--------
+
+inline GSP_RW_WriterPref::ReadOp::ReadOp(GSP_RW_WriterPref &sync_data)
+        : m_sync(sync_data)
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	//--------
+	// Unlike GSP_RW, a reader also waits if a writer is waiting
+	//--------
+	if (m_sync.m_writer_count || m_sync.m_writer_waiting_count > 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		m_sync.m_reader_waiting_count ++;
+
+		while (m_sync.m_writer_count
+		       || m_sync.m_writer_waiting_count > 0)
+		{
+			status = pthread_cond_wait(&m_sync.m_read_cond,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+
+		m_sync.m_reader_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	m_sync.m_reader_count ++;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_RW_WriterPref::ReadOp::~ReadOp()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	m_sync.m_reader_count --;
+
+	if (m_sync.m_reader_count == 0 && m_sync.m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_sync.m_write_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW_WriterPref::WriteOp
+//--------
+
+inline GSP_RW_WriterPref::WriteOp::WriteOp(GSP_RW_WriterPref &sync_data)
+        : m_sync(sync_data)
+{
+	int	status;
+	double	start;
+	double	wait;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	if (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		start = gsp_now_usecs();
+		m_sync.m_writer_waiting_count ++;
+		while (m_sync.m_writer_count || m_sync.m_reader_count > 0) {
+			status = pthread_cond_wait(&m_sync.m_write_cond,
+						   &m_sync.m_mutex);
+			assert(status == 0);
+		}
+		m_sync.m_writer_waiting_count --;
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+
+		wait = gsp_now_usecs() - start;
+		if (wait > m_sync.m_max_writer_wait_usecs) {
+			m_sync.m_max_writer_wait_usecs = wait;
+		}
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+
+	assert(m_sync.m_writer_count == 0);
+	m_sync.m_writer_count = 1;
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_RW_WriterPref::WriteOp::~WriteOp()
+{
+	int	status;
+
+	status = pthread_mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	assert(m_sync.m_writer_count == 1);
+	m_sync.m_writer_count = 0;
+
+	//--------
+	// Hand the lock to another writer, if there is one
+	//--------
+	if (m_sync.m_writer_waiting_count > 0) {
+		status = pthread_cond_signal(&m_sync.m_write_cond);
+		assert(status == 0);
+	} else if (m_sync.m_reader_waiting_count > 0) {
+		status = pthread_cond_broadcast(&m_sync.m_read_cond);
+		assert(status == 0);
+	}
+
+	status = pthread_mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+#endif
@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	sol_gsp_boundedprodcons.h
 //
-// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp,
+//			PutBatchOp(long n), GetBatchOp(long max, long & got)]
 //
 // Description:	The bounded producer-consumer synchronisation policy.
 //
@@ -39,6 +40,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <synch.h>
 #include <assert.h>
 
@@ -87,13 +89,43 @@ public:
 		GSP_BoundedProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp waits until there are "n" free slots and puts
+	// "n" items with one lock acquisition. GetBatchOp waits until
+	// there is at least one item and then gets up to "max" items;
+	// "got" is set to the number actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_BoundedProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_BoundedProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_got;
+	};
+
 protected:
 	friend class	::GSP_BoundedProdCons::PutOp;
 	friend class	::GSP_BoundedProdCons::GetOp;
 	friend class	::GSP_BoundedProdCons::OtherOp;
+	friend class	::GSP_BoundedProdCons::PutBatchOp;
+	friend class	::GSP_BoundedProdCons::GetBatchOp;
 	mutex_t		m_mutex;
 	sema_t		m_item_count;	// counts number of items in buffer
 	sema_t		m_free_count;	// counts free slots in buffer
+	mutex_t		m_batch_mutex;	// serialises PutBatchOp's wait
+	long		m_buf_size;	// only for sanity checks
 };
 
 
@@ -116,6 +148,11 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 
 	status = sema_init(&m_free_count, size, USYNC_THREAD, 0);
 	assert(status == 0);
+
+	status = mutex_init(&m_batch_mutex, USYNC_THREAD, 0);
+	assert(status == 0);
+
+	m_buf_size = size;
 }
 
 
@@ -131,6 +168,9 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 
 	status = sema_destroy(&m_free_count);
 	assert(status == 0);
+
+	status = mutex_destroy(&m_batch_mutex);
+	assert(status == 0);
 }
 
 
@@ -230,4 +270,122 @@ inline GSP_BoundedProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutBatchOp
+//--------
+
+inline GSP_BoundedProdCons::PutBatchOp::PutBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	int	status;
+	long	i;
+
+	assert(n >= 0 && n <= m_sync.m_buf_size);
+	m_n = n;
+
+	//--------
+	// Two batch producers that each grabbed some of the free slots
+	// could deadlock waiting for the rest, so only one batch
+	// producer at a time collects its slots.
+	//--------
+	status = mutex_lock(&m_sync.m_batch_mutex);
+	assert(status == 0);
+	for (i = 0; i < m_n; i++) {
+		status = sema_wait(&m_sync.m_free_count);
+		assert(status == 0);
+	}
+	status = mutex_unlock(&m_sync.m_batch_mutex);
+	assert(status == 0);
+
+	status = mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_BoundedProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	i;
+
+	status = mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	for (i = 0; i < m_n; i++) {
+		status = sema_post(&m_sync.m_item_count);
+		assert(status == 0);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::GetBatchOp
+//--------
+
+inline GSP_BoundedProdCons::GetBatchOp::GetBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(max > 0);
+
+	//--------
+	// Block until there is one item, then take as many more as
+	// are available without blocking.
+	//--------
+	status = sema_wait(&m_sync.m_item_count);
+	assert(status == 0);
+	m_got = 1;
+	while (m_got < max && sema_trywait(&m_sync.m_item_count) == 0) {
+		m_got ++;
+	}
+	got = m_got;
+
+	status = mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_BoundedProdCons::GetBatchOp::~GetBatchOp()
+{
+	int	status;
+	long	i;
+
+	status = mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	for (i = 0; i < m_got; i++) {
+		status = sema_post(&m_sync.m_free_count);
+		assert(status == 0);
+	}
+}
+
+
+
+
+
+//--------
+// GSP_BoundedProdCons does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_BoundedProdCons &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
@@ -36,6 +36,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <synch.h>
 #include <thread.h>
 
@@ -124,4 +125,23 @@ inline GSP_Mutex::Op::~Op()
 	assert(status == 0);
 }
 
+
+
+
+
+//--------
+// GSP_Mutex does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_Mutex &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
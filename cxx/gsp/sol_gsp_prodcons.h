@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	sol_gsp_prodcons.h
 //
-// Policy:	ProdCons[PutOp, GetOp, OtherOp]
+// Policy:	ProdCons[PutOp, GetOp, OtherOp,
+//			 PutBatchOp(long n), GetBatchOp(long max, long & got)]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -39,6 +40,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <synch.h>
 #include <assert.h>
 
@@ -87,10 +89,37 @@ public:
 		GSP_ProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp puts "n" items with one lock acquisition.
+	// GetBatchOp waits until there is at least one item and
+	// then gets up to "max" items; "got" is set to the number
+	// actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_ProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_ProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+	};
+
 protected:
 	friend class	::GSP_ProdCons::PutOp;
 	friend class	::GSP_ProdCons::GetOp;
 	friend class	::GSP_ProdCons::OtherOp;
+	friend class	::GSP_ProdCons::PutBatchOp;
+	friend class	::GSP_ProdCons::GetBatchOp;
 	mutex_t		m_mutex;
 	sema_t		m_item_count;
 };
@@ -217,4 +246,98 @@ inline GSP_ProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_ProdCons::PutBatchOp
+//--------
+
+inline GSP_ProdCons::PutBatchOp::PutBatchOp(GSP_ProdCons &sync_data, long n)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(n >= 0);
+	m_n = n;
+
+	status = mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_ProdCons::PutBatchOp::~PutBatchOp()
+{
+	int	status;
+	long	i;
+
+	status = mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+
+	for (i = 0; i < m_n; i++) {
+		status = sema_post(&m_sync.m_item_count);
+		assert(status == 0);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::GetBatchOp
+//--------
+
+inline GSP_ProdCons::GetBatchOp::GetBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	int	status;
+
+	assert(max > 0);
+
+	//--------
+	// Block until there is one item, then take as many more as
+	// are available without blocking.
+	//--------
+	status = sema_wait(&m_sync.m_item_count);
+	assert(status == 0);
+	got = 1;
+	while (got < max && sema_trywait(&m_sync.m_item_count) == 0) {
+		got ++;
+	}
+
+	status = mutex_lock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+inline GSP_ProdCons::GetBatchOp::~GetBatchOp()
+{
+	int	status;
+
+	status = mutex_unlock(&m_sync.m_mutex);
+	assert(status == 0);
+}
+
+
+
+
+
+//--------
+// GSP_ProdCons does not gather statistics, so GSP_STATS_LABEL()
+// does nothing.
+//--------
+#if defined(GSP_ENABLE_STATS)
+inline void
+gsp_stats_label(GSP_ProdCons &, const char *)
+{
+}
+#endif
+
+
+
+
+
 #endif
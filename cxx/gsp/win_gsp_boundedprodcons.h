@@ -1,7 +1,10 @@
 //-----------------------------------------------------------------------
 // File:	win_gsp_boundedprodcons.h
 //
-// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp]
+// Policy:	BoundedProdCons(int size)[PutOp, GetOp, OtherOp,
+//			PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			TryPutOp, TimedPutOp(long timeout_ms),
+//			TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The bounded producer-consumer synchronisation policy.
 //
@@ -39,6 +42,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <windows.h>
 #include <process.h>
 #include <assert.h>
@@ -60,6 +64,9 @@ class GSP_BoundedProdCons {
 public:
 	inline GSP_BoundedProdCons(int size);
 	inline ~GSP_BoundedProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 
 	class PutOp {
@@ -89,14 +96,106 @@ public:
 		GSP_BoundedProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp waits until there are "n" free slots and puts
+	// "n" items with one lock acquisition. GetBatchOp waits until
+	// there is at least one item and then gets up to "max" items;
+	// "got" is set to the number actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_BoundedProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_BoundedProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		long			m_got;
+	};
+
+	//--------
+	// The Try operations do not block, and the Timed operations
+	// block for at most "timeout_ms" milliseconds. The caller must
+	// check acquired() before entering the critical section.
+	//--------
+	class TryPutOp {
+	public:
+		inline TryPutOp(GSP_BoundedProdCons &);
+		inline ~TryPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedPutOp {
+	public:
+		inline TimedPutOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedPutOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_BoundedProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_BoundedProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_BoundedProdCons	&m_sync;
+		bool			m_acquired;
+	};
+
 protected:
 	friend	class ::GSP_BoundedProdCons::PutOp;
 	friend	class ::GSP_BoundedProdCons::GetOp;
 	friend	class ::GSP_BoundedProdCons::OtherOp;
+	friend	class ::GSP_BoundedProdCons::PutBatchOp;
+	friend	class ::GSP_BoundedProdCons::GetBatchOp;
+	friend	class ::GSP_BoundedProdCons::TryPutOp;
+	friend	class ::GSP_BoundedProdCons::TimedPutOp;
+	friend	class ::GSP_BoundedProdCons::TryGetOp;
+	friend	class ::GSP_BoundedProdCons::TimedGetOp;
+
+	inline bool acquirePut(long timeout_ms);
+	inline void releasePut();
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	HANDLE	m_mutex;	// mutex
 	HANDLE	m_item_count;	// semaphore; counts number of items in buffer
 	HANDLE	m_free_count;	// semaphore; counts free slots in buffer
+	HANDLE	m_batch_mutex;	// mutex; serialises PutBatchOp's wait
+	long	m_buf_size;	// only for sanity checks
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -118,6 +217,10 @@ inline GSP_BoundedProdCons::GSP_BoundedProdCons(int size)
 	m_mutex      = CreateMutex(&attr, FALSE, 0);
 	m_item_count = CreateSemaphore(&attr, 0, size, 0);
 	m_free_count = CreateSemaphore(&attr, size, size, 0);
+	m_batch_mutex = CreateMutex(&attr, FALSE, 0);
+	m_buf_size   = size;
+
+	GSP_STATS_KIND(m_stats, "GSP_BoundedProdCons");
 }
 
 
@@ -126,6 +229,107 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 	CloseHandle(m_mutex);
 	CloseHandle(m_item_count);
 	CloseHandle(m_free_count);
+	CloseHandle(m_batch_mutex);
+}
+
+
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_BoundedProdCons::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+//--------
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. A "timeout_ms" of 0 means do not wait.
+//--------
+
+inline bool
+GSP_BoundedProdCons::acquirePut(long timeout_ms)
+{
+#if defined(GSP_ENABLE_STATS)
+	bool	waited;
+	GSP_STATS_WAIT_BEGIN(m_stats);
+
+	waited = WaitForSingleObject(m_free_count, 0) != WAIT_OBJECT_0;
+	if (waited
+	    && (timeout_ms == 0
+		|| WaitForSingleObject(m_free_count, (DWORD)timeout_ms)
+		   != WAIT_OBJECT_0))
+	{
+		GSP_STATS_WAIT_ABANDON(m_stats);
+		return false;
+	}
+	WaitForSingleObject(m_mutex, INFINITE);
+	if (waited) {
+		GSP_STATS_WAIT_END(m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+#else
+	if (WaitForSingleObject(m_free_count, (DWORD)timeout_ms)
+	    != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+	WaitForSingleObject(m_mutex, INFINITE);
+#endif
+	return true;
+}
+
+
+inline void
+GSP_BoundedProdCons::releasePut()
+{
+	ReleaseMutex(m_mutex);
+	ReleaseSemaphore(m_item_count, 1, 0);
+}
+
+
+inline bool
+GSP_BoundedProdCons::acquireGet(long timeout_ms)
+{
+#if defined(GSP_ENABLE_STATS)
+	bool	waited;
+	GSP_STATS_WAIT_BEGIN(m_stats);
+
+	waited = WaitForSingleObject(m_item_count, 0) != WAIT_OBJECT_0;
+	if (waited
+	    && (timeout_ms == 0
+		|| WaitForSingleObject(m_item_count, (DWORD)timeout_ms)
+		   != WAIT_OBJECT_0))
+	{
+		GSP_STATS_WAIT_ABANDON(m_stats);
+		return false;
+	}
+	WaitForSingleObject(m_mutex, INFINITE);
+	if (waited) {
+		GSP_STATS_WAIT_END(m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+#else
+	if (WaitForSingleObject(m_item_count, (DWORD)timeout_ms)
+	    != WAIT_OBJECT_0)
+	{
+		return false;
+	}
+	WaitForSingleObject(m_mutex, INFINITE);
+#endif
+	return true;
+}
+
+
+inline void
+GSP_BoundedProdCons::releaseGet()
+{
+	ReleaseMutex(m_mutex);
+	ReleaseSemaphore(m_free_count, 1, 0);
 }
 
 
@@ -139,8 +343,25 @@ inline GSP_BoundedProdCons::~GSP_BoundedProdCons()
 inline GSP_BoundedProdCons::PutOp::PutOp(GSP_BoundedProdCons &sync_data)
 	: m_sync(sync_data)
 {
+#if defined(GSP_ENABLE_STATS)
+	bool	waited;
+	GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+
+	waited = WaitForSingleObject(m_sync.m_free_count, 0) != WAIT_OBJECT_0;
+	if (waited) {
+		WaitForSingleObject(m_sync.m_free_count, INFINITE);
+	}
+	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	if (waited) {
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
 	WaitForSingleObject(m_sync.m_free_count, INFINITE);
 	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+#endif
 }
 
 
@@ -161,8 +382,25 @@ inline GSP_BoundedProdCons::PutOp::~PutOp()
 inline GSP_BoundedProdCons::GetOp::GetOp(GSP_BoundedProdCons &sync_data)
 	: m_sync(sync_data)
 {
+#if defined(GSP_ENABLE_STATS)
+	bool	waited;
+	GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+
+	waited = WaitForSingleObject(m_sync.m_item_count, 0) != WAIT_OBJECT_0;
+	if (waited) {
+		WaitForSingleObject(m_sync.m_item_count, INFINITE);
+	}
+	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	if (waited) {
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
 	WaitForSingleObject(m_sync.m_item_count, INFINITE);
 	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+#endif
 }
 
 
@@ -184,6 +422,7 @@ inline GSP_BoundedProdCons::OtherOp::OtherOp(GSP_BoundedProdCons &sync_data)
 	: m_sync(sync_data)
 {
 	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -196,4 +435,246 @@ inline GSP_BoundedProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_BoundedProdCons::PutBatchOp
+//--------
+
+inline GSP_BoundedProdCons::PutBatchOp::PutBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			n)
+	: m_sync(sync_data)
+{
+	long	i;
+
+	assert(n >= 0 && n <= m_sync.m_buf_size);
+	m_n = n;
+
+	//--------
+	// Two batch producers that each grabbed some of the free slots
+	// could deadlock waiting for the rest, so only one batch
+	// producer at a time collects its slots.
+	//--------
+#if defined(GSP_ENABLE_STATS)
+	bool	waited = false;
+	GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+
+	WaitForSingleObject(m_sync.m_batch_mutex, INFINITE);
+	for (i = 0; i < m_n; i++) {
+		if (WaitForSingleObject(m_sync.m_free_count, 0)
+		    != WAIT_OBJECT_0)
+		{
+			waited = true;
+			WaitForSingleObject(m_sync.m_free_count, INFINITE);
+		}
+	}
+	ReleaseMutex(m_sync.m_batch_mutex);
+
+	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	if (waited) {
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
+	WaitForSingleObject(m_sync.m_batch_mutex, INFINITE);
+	for (i = 0; i < m_n; i++) {
+		WaitForSingleObject(m_sync.m_free_count, INFINITE);
+	}
+	ReleaseMutex(m_sync.m_batch_mutex);
+
+	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+#endif
+}
+
+
+inline GSP_BoundedProdCons::PutBatchOp::~PutBatchOp()
+{
+	ReleaseMutex(m_sync.m_mutex);
+	if (m_n > 0) {
+		ReleaseSemaphore(m_sync.m_item_count, m_n, 0);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::GetBatchOp
+//--------
+
+inline GSP_BoundedProdCons::GetBatchOp::GetBatchOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	assert(max > 0);
+
+	//--------
+	// Block until there is one item, then take as many more as
+	// are available without blocking.
+	//--------
+#if defined(GSP_ENABLE_STATS)
+	bool	waited;
+	GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+
+	waited = WaitForSingleObject(m_sync.m_item_count, 0) != WAIT_OBJECT_0;
+	if (waited) {
+		WaitForSingleObject(m_sync.m_item_count, INFINITE);
+	}
+#else
+	WaitForSingleObject(m_sync.m_item_count, INFINITE);
+#endif
+	m_got = 1;
+	while (m_got < max
+	       && WaitForSingleObject(m_sync.m_item_count, 0) == WAIT_OBJECT_0)
+	{
+		m_got ++;
+	}
+	got = m_got;
+
+	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+#if defined(GSP_ENABLE_STATS)
+	if (waited) {
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#endif
+}
+
+
+inline GSP_BoundedProdCons::GetBatchOp::~GetBatchOp()
+{
+	ReleaseMutex(m_sync.m_mutex);
+	ReleaseSemaphore(m_sync.m_free_count, m_got, 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryPutOp
+//--------
+
+inline GSP_BoundedProdCons::TryPutOp::TryPutOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(0);
+}
+
+
+inline GSP_BoundedProdCons::TryPutOp::~TryPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedPutOp
+//--------
+
+inline GSP_BoundedProdCons::TimedPutOp::TimedPutOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquirePut(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedPutOp::~TimedPutOp()
+{
+	if (m_acquired) {
+		m_sync.releasePut();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedPutOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TryGetOp
+//--------
+
+inline GSP_BoundedProdCons::TryGetOp::TryGetOp(GSP_BoundedProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_BoundedProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_BoundedProdCons::TimedGetOp
+//--------
+
+inline GSP_BoundedProdCons::TimedGetOp::TimedGetOp(
+	GSP_BoundedProdCons &	sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_BoundedProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_BoundedProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
@@ -1,7 +1,8 @@
 //-----------------------------------------------------------------------
 // File:	win_gsp_mutex.h
 //
-// Policy:	Mutex[Op]	// non-recurisve mutex
+// Policy:	Mutex[Op, TryOp, TimedOp(long timeout_ms)]
+//		// non-recurisve mutex
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -36,6 +37,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <windows.h>
 #include <process.h>
 #include <assert.h>
@@ -57,6 +59,9 @@ class GSP_Mutex {
 public:
 	inline GSP_Mutex();
 	inline ~GSP_Mutex();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class Op {
 	public:
@@ -67,10 +72,46 @@ public:
 		GSP_Mutex      &m_sync;
 	};
 
+	//--------
+	// TryOp does not block, and TimedOp blocks for at most
+	// "timeout_ms" milliseconds. The caller must check acquired()
+	// before entering the critical section.
+	//--------
+	class TryOp {
+	public:
+		inline TryOp(GSP_Mutex &);
+		inline ~TryOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedOp {
+	public:
+		inline TimedOp(GSP_Mutex &, long timeout_ms);
+		inline ~TimedOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_Mutex      &m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend  class ::GSP_Mutex::Op;
+	friend  class ::GSP_Mutex::TryOp;
+	friend  class ::GSP_Mutex::TimedOp;
+
+	inline bool acquire(DWORD timeout_ms);
+
 	HANDLE	m_mutex;
 	int	m_deadlockIfReacquired;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -91,6 +132,8 @@ inline GSP_Mutex::GSP_Mutex()
 
 	m_mutex = CreateMutex(&attr, FALSE, 0);
 	m_deadlockIfReacquired = 0;
+
+	GSP_STATS_KIND(m_stats, "GSP_Mutex");
 }
 
 
@@ -102,6 +145,52 @@ inline GSP_Mutex::~GSP_Mutex()
 
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_Mutex::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+
+inline bool
+GSP_Mutex::acquire(DWORD timeout_ms)
+{
+#if defined(GSP_ENABLE_STATS)
+	if (WaitForSingleObject(m_mutex, 0) != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		if (timeout_ms == 0
+		    || WaitForSingleObject(m_mutex, timeout_ms) != WAIT_OBJECT_0)
+		{
+			GSP_STATS_WAIT_ABANDON(m_stats);
+			return false;
+		}
+		GSP_STATS_WAIT_END(m_stats);
+	}
+#else
+	if (WaitForSingleObject(m_mutex, timeout_ms) != WAIT_OBJECT_0) {
+		return false;
+	}
+#endif
+
+	//--------
+	// A Win32 mutex is recursive. If the calling thread already
+	// held it then a non-recursive mutex would not have been
+	// acquired, so undo the recursive acquisition.
+	//--------
+	if (m_deadlockIfReacquired) {
+		ReleaseMutex(m_mutex);
+		return false;
+	}
+	m_deadlockIfReacquired = 1;
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+
 
 
 //--------
@@ -111,7 +200,16 @@ inline GSP_Mutex::~GSP_Mutex()
 inline GSP_Mutex::Op::Op(GSP_Mutex &sync_data)
         : m_sync(sync_data)
 {
+#if defined(GSP_ENABLE_STATS)
+	if (WaitForSingleObject(m_sync.m_mutex, 0) != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		WaitForSingleObject(m_sync.m_mutex, INFINITE);
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
 	WaitForSingleObject(m_sync.m_mutex, INFINITE);
+#endif
 	assert(m_sync.m_deadlockIfReacquired == 0);
 	m_sync.m_deadlockIfReacquired = 1;
 }
@@ -129,4 +227,70 @@ inline GSP_Mutex::Op::~Op()
 
 
 
+//--------
+// Inline implementation of class GSP_Mutex::TryOp
+//--------
+
+inline GSP_Mutex::TryOp::TryOp(GSP_Mutex &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquire(0);
+}
+
+
+
+inline GSP_Mutex::TryOp::~TryOp()
+{
+	if (m_acquired) {
+		assert(m_sync.m_deadlockIfReacquired);
+		m_sync.m_deadlockIfReacquired = 0;
+		ReleaseMutex(m_sync.m_mutex);
+	}
+}
+
+
+
+inline bool
+GSP_Mutex::TryOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_Mutex::TimedOp
+//--------
+
+inline GSP_Mutex::TimedOp::TimedOp(GSP_Mutex &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquire((DWORD)timeout_ms);
+}
+
+
+
+inline GSP_Mutex::TimedOp::~TimedOp()
+{
+	if (m_acquired) {
+		assert(m_sync.m_deadlockIfReacquired);
+		m_sync.m_deadlockIfReacquired = 0;
+		ReleaseMutex(m_sync.m_mutex);
+	}
+}
+
+
+
+inline bool
+GSP_Mutex::TimedOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
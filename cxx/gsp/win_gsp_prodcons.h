@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	win_gsp_prodcons.h
 //
-// Policy:	ProdCons[PutOp, GetOp, OtherOp]
+// Policy:	ProdCons[PutOp, GetOp, OtherOp,
+//			 PutBatchOp(long n), GetBatchOp(long max, long & got),
+//			 TryGetOp, TimedGetOp(long timeout_ms)]
 //
 // Description:	The producer-consumer synchronisation policy.
 //
@@ -39,6 +41,7 @@
 //--------
 // #include's
 //--------
+#include "gsp_stats.h"
 #include <windows.h>
 #include <process.h>
 #include <limits.h>
@@ -61,6 +64,9 @@ class GSP_ProdCons {
 public:
 	inline GSP_ProdCons();
 	inline ~GSP_ProdCons();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 
 	class PutOp {
@@ -90,13 +96,76 @@ public:
 		GSP_ProdCons	&m_sync;
 	};
 
+	//--------
+	// PutBatchOp puts "n" items with one lock acquisition.
+	// GetBatchOp waits until there is at least one item and
+	// then gets up to "max" items; "got" is set to the number
+	// actually obtained.
+	//--------
+	class PutBatchOp {
+	public:
+		inline PutBatchOp(GSP_ProdCons &, long n);
+		inline ~PutBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		long		m_n;
+	};
+
+	class GetBatchOp {
+	public:
+		inline GetBatchOp(GSP_ProdCons &, long max, long & got);
+		inline ~GetBatchOp();
+
+	protected:
+		GSP_ProdCons	&m_sync;
+	};
+
+	//--------
+	// TryGetOp does not block, and TimedGetOp blocks for at most
+	// "timeout_ms" milliseconds. The caller must check acquired()
+	// before entering the critical section.
+	//--------
+	class TryGetOp {
+	public:
+		inline TryGetOp(GSP_ProdCons &);
+		inline ~TryGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedGetOp {
+	public:
+		inline TimedGetOp(GSP_ProdCons &, long timeout_ms);
+		inline ~TimedGetOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_ProdCons	&m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend	class ::GSP_ProdCons::PutOp;
 	friend	class ::GSP_ProdCons::GetOp;
 	friend	class ::GSP_ProdCons::OtherOp;
+	friend	class ::GSP_ProdCons::PutBatchOp;
+	friend	class ::GSP_ProdCons::GetBatchOp;
+	friend	class ::GSP_ProdCons::TryGetOp;
+	friend	class ::GSP_ProdCons::TimedGetOp;
+
+	inline bool acquireGet(long timeout_ms);
+	inline void releaseGet();
 
 	HANDLE	m_mutex;	// mutex
 	HANDLE	m_item_count;	// semaphore; counts number of items in buffer
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -120,6 +189,8 @@ inline GSP_ProdCons::GSP_ProdCons()
 
 	m_item_count = CreateSemaphore(&attr, 0, LONG_MAX, 0);
 	assert (m_item_count != 0);
+
+	GSP_STATS_KIND(m_stats, "GSP_ProdCons");
 }
 
 
@@ -135,6 +206,67 @@ inline GSP_ProdCons::~GSP_ProdCons()
 }
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_ProdCons::stats()
+{
+	return m_stats;
+}
+#endif
+
+
+//--------
+// The acquire*() and release*() operations are used by the Try and
+// Timed operations. A "timeout_ms" of 0 means do not wait.
+//--------
+
+inline bool
+GSP_ProdCons::acquireGet(long timeout_ms)
+{
+	DWORD	status;
+
+#if defined(GSP_ENABLE_STATS)
+	status = WaitForSingleObject(m_item_count, 0);
+	if (status != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		if (timeout_ms != 0) {
+			status = WaitForSingleObject(m_item_count,
+						     (DWORD)timeout_ms);
+		}
+		if (status != WAIT_OBJECT_0) {
+			GSP_STATS_WAIT_ABANDON(m_stats);
+			return false;
+		}
+		status = WaitForSingleObject(m_mutex, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+		GSP_STATS_WAIT_END(m_stats);
+		GSP_STATS_ACQUIRED(m_stats);
+		return true;
+	}
+#else
+	status = WaitForSingleObject(m_item_count, (DWORD)timeout_ms);
+	if (status != WAIT_OBJECT_0) {
+		return false;
+	}
+#endif
+
+	status = WaitForSingleObject(m_mutex, INFINITE);
+	assert(status == WAIT_OBJECT_0);
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+}
+
+
+inline void
+GSP_ProdCons::releaseGet()
+{
+	BOOL	status;
+
+	status = ReleaseMutex(m_mutex);
+	assert(status == TRUE);
+}
+
+
 
 
 
@@ -149,6 +281,7 @@ inline GSP_ProdCons::PutOp::PutOp(GSP_ProdCons &sync_data)
 
 	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
 	assert(status == WAIT_OBJECT_0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -176,11 +309,25 @@ inline GSP_ProdCons::GetOp::GetOp(GSP_ProdCons &sync_data)
 {
 	DWORD	status;
 
+#if defined(GSP_ENABLE_STATS)
+	if (WaitForSingleObject(m_sync.m_item_count, 0) != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		status = WaitForSingleObject(m_sync.m_item_count, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+		status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+		GSP_STATS_ACQUIRED(m_sync.m_stats);
+		return;
+	}
+#else
 	status = WaitForSingleObject(m_sync.m_item_count, INFINITE);
 	assert(status == WAIT_OBJECT_0);
+#endif
 
 	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
 	assert(status == WAIT_OBJECT_0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -207,6 +354,7 @@ inline GSP_ProdCons::OtherOp::OtherOp(GSP_ProdCons &sync_data)
 
 	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
 	assert(status == WAIT_OBJECT_0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 }
 
 
@@ -222,4 +370,162 @@ inline GSP_ProdCons::OtherOp::~OtherOp()
 
 
 
+//--------
+// Inline implementation of class GSP_ProdCons::PutBatchOp
+//--------
+
+inline GSP_ProdCons::PutBatchOp::PutBatchOp(GSP_ProdCons &sync_data, long n)
+	: m_sync(sync_data)
+{
+	DWORD	status;
+
+	assert(n >= 0);
+	m_n = n;
+
+	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	assert(status == WAIT_OBJECT_0);
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_ProdCons::PutBatchOp::~PutBatchOp()
+{
+	BOOL	status;
+
+	status = ReleaseMutex(m_sync.m_mutex);
+	assert(status == TRUE);
+
+	if (m_n > 0) {
+		status = ReleaseSemaphore(m_sync.m_item_count, m_n, 0);
+		assert(status == TRUE);
+	}
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::GetBatchOp
+//--------
+
+inline GSP_ProdCons::GetBatchOp::GetBatchOp(
+	GSP_ProdCons &		sync_data,
+	long			max,
+	long &			got)
+	: m_sync(sync_data)
+{
+	DWORD	status;
+
+	assert(max > 0);
+
+	//--------
+	// Block until there is one item, then take as many more as
+	// are available without blocking.
+	//--------
+#if defined(GSP_ENABLE_STATS)
+	bool	waited = false;
+	GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+
+	if (WaitForSingleObject(m_sync.m_item_count, 0) != WAIT_OBJECT_0) {
+		waited = true;
+		status = WaitForSingleObject(m_sync.m_item_count, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+	}
+#else
+	status = WaitForSingleObject(m_sync.m_item_count, INFINITE);
+	assert(status == WAIT_OBJECT_0);
+#endif
+	got = 1;
+	while (got < max
+	       && WaitForSingleObject(m_sync.m_item_count, 0) == WAIT_OBJECT_0)
+	{
+		got ++;
+	}
+
+	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	assert(status == WAIT_OBJECT_0);
+#if defined(GSP_ENABLE_STATS)
+	if (waited) {
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	} else {
+		GSP_STATS_WAIT_ABANDON(m_sync.m_stats);
+	}
+#endif
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+}
+
+
+inline GSP_ProdCons::GetBatchOp::~GetBatchOp()
+{
+	BOOL	status;
+
+	status = ReleaseMutex(m_sync.m_mutex);
+	assert(status == TRUE);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::TryGetOp
+//--------
+
+inline GSP_ProdCons::TryGetOp::TryGetOp(GSP_ProdCons &sync_data)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(0);
+}
+
+
+inline GSP_ProdCons::TryGetOp::~TryGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TryGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_ProdCons::TimedGetOp
+//--------
+
+inline GSP_ProdCons::TimedGetOp::TimedGetOp(
+	GSP_ProdCons &		sync_data,
+	long			timeout_ms)
+	: m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireGet(timeout_ms);
+}
+
+
+inline GSP_ProdCons::TimedGetOp::~TimedGetOp()
+{
+	if (m_acquired) {
+		m_sync.releaseGet();
+	}
+}
+
+
+inline bool
+GSP_ProdCons::TimedGetOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
 #endif
@@ -1,7 +1,9 @@
 //-----------------------------------------------------------------------
 // File:	win_gsp_rw.h
 //
-// Policy:	RW[ReadOp, WriteOp]	// readers-writer lock
+// Policy:	RW[ReadOp, WriteOp, TryReadOp, TryWriteOp,
+//		   TimedReadOp(long timeout_ms), TimedWriteOp(long timeout_ms)]
+//		// readers-writer lock
 //
 // Copyright 2006 Ciaran McHale.
 // 
@@ -39,6 +41,8 @@
 #include <windows.h>
 #include <process.h>
 #include <assert.h>
+#include "gsp_timeout.h"
+#include "gsp_stats.h"
 
 
 
@@ -57,6 +61,9 @@ class GSP_RW {
 public:
 	inline GSP_RW();
 	inline ~GSP_RW();
+#if defined(GSP_ENABLE_STATS)
+	inline GSP_Stats & stats();
+#endif
 
 	class ReadOp {
 	public:
@@ -76,12 +83,75 @@ public:
 		GSP_RW      &m_sync;
 	};
 
+	//--------
+	// The Try and Timed variants do not block, or block for at most
+	// "timeout_ms" milliseconds, respectively. The caller must check
+	// acquired() before entering the critical section.
+	//--------
+	class TryReadOp {
+	public:
+		inline TryReadOp(GSP_RW &);
+		inline ~TryReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedReadOp {
+	public:
+		inline TimedReadOp(GSP_RW &, long timeout_ms);
+		inline ~TimedReadOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TryWriteOp {
+	public:
+		inline TryWriteOp(GSP_RW &);
+		inline ~TryWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
+	class TimedWriteOp {
+	public:
+		inline TimedWriteOp(GSP_RW &, long timeout_ms);
+		inline ~TimedWriteOp();
+		inline bool acquired() const;
+
+	protected:
+		GSP_RW      &m_sync;
+		bool		m_acquired;
+	};
+
 protected:
 	friend  class ::GSP_RW::ReadOp;
 	friend  class ::GSP_RW::WriteOp;
+	friend  class ::GSP_RW::TryReadOp;
+	friend  class ::GSP_RW::TimedReadOp;
+	friend  class ::GSP_RW::TryWriteOp;
+	friend  class ::GSP_RW::TimedWriteOp;
+
+	inline bool acquireRead(long timeout_ms);
+	inline void releaseRead();
+	inline bool acquireWrite(long timeout_ms);
+	inline void releaseWrite();
+
 	HANDLE	m_mutex;	// mutex
 	HANDLE	m_sem;		// semaphore
 	int	m_reader_count;
+
+#if defined(GSP_ENABLE_STATS)
+	GSP_Stats	m_stats;
+#endif
 };
 
 
@@ -107,6 +177,8 @@ inline GSP_RW::GSP_RW()
 	assert(m_sem != 0);
 
 	m_reader_count = 0;
+
+	GSP_STATS_KIND(m_stats, "GSP_RW");
 }
 
 
@@ -124,48 +196,162 @@ inline GSP_RW::~GSP_RW()
 
 
 
+#if defined(GSP_ENABLE_STATS)
+inline GSP_Stats &
+GSP_RW::stats()
+{
+	return m_stats;
+}
+#endif
+
 
 
 //--------
-// Inline implementation of class GSP_RW::ReadOp
+// acquireRead() and acquireWrite() are used by the Try and Timed
+// operations. A "timeout_ms" of 0 means do not wait.
 //--------
 
-inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
-        : m_sync(sync_data)
+inline bool
+GSP_RW::acquireRead(long timeout_ms)
+{
+	int		status;
+	gsp_deadline_t	deadline;
+
+	gsp_deadline_init(&deadline, timeout_ms);
+	status = WaitForSingleObject(m_mutex, (DWORD)timeout_ms);
+	if (status != WAIT_OBJECT_0) {
+		return false;
+	}
+
+	if (m_reader_count == 0) {
+#if defined(GSP_ENABLE_STATS)
+		status = WaitForSingleObject(m_sem, 0);
+		if (status != WAIT_OBJECT_0) {
+			GSP_STATS_WAIT_BEGIN(m_stats);
+			status = WaitForSingleObject(m_sem,
+				(DWORD)gsp_deadline_remaining_ms(&deadline));
+			if (status == WAIT_OBJECT_0) {
+				GSP_STATS_WAIT_END(m_stats);
+			} else {
+				GSP_STATS_WAIT_ABANDON(m_stats);
+			}
+		}
+#else
+		status = WaitForSingleObject(m_sem,
+				(DWORD)gsp_deadline_remaining_ms(&deadline));
+#endif
+		if (status != WAIT_OBJECT_0) {
+			status = ReleaseMutex(m_mutex);
+			assert(status == TRUE);
+			return false;
+		}
+	}
+
+	m_reader_count ++;
+	GSP_STATS_ACQUIRED(m_stats);
+
+	status = ReleaseMutex(m_mutex);
+	assert(status == TRUE);
+	return true;
+}
+
+
+
+inline void
+GSP_RW::releaseRead()
 {
 	int	status;
+	LONG	sem_prev_val;
 
-	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
+	status = WaitForSingleObject(m_mutex, INFINITE);
 	assert(status == WAIT_OBJECT_0);
 
-	m_sync.m_reader_count ++;
+	m_reader_count --;
 
-	if (m_sync.m_reader_count == 1) {
-		status = WaitForSingleObject(m_sync.m_sem, INFINITE);
-		assert(status == WAIT_OBJECT_0);
+	if (m_reader_count == 0) {
+		status = ReleaseSemaphore(m_sem, 1, &sem_prev_val);
+		assert(status == TRUE);
+		assert(sem_prev_val == 0);
 	}
 
-	status = ReleaseMutex(m_sync.m_mutex);
+	status = ReleaseMutex(m_mutex);
 	assert(status == TRUE);
 }
 
 
 
-inline GSP_RW::ReadOp::~ReadOp()
+inline bool
+GSP_RW::acquireWrite(long timeout_ms)
+{
+#if defined(GSP_ENABLE_STATS)
+	if (WaitForSingleObject(m_sem, 0) != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_stats);
+		if (timeout_ms == 0
+		    || WaitForSingleObject(m_sem, (DWORD)timeout_ms)
+		       != WAIT_OBJECT_0)
+		{
+			GSP_STATS_WAIT_ABANDON(m_stats);
+			return false;
+		}
+		GSP_STATS_WAIT_END(m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_stats);
+	return true;
+#else
+	return WaitForSingleObject(m_sem, (DWORD)timeout_ms) == WAIT_OBJECT_0;
+#endif
+}
+
+
+
+inline void
+GSP_RW::releaseWrite()
 {
 	int	status;
 	LONG	sem_prev_val;
 
+	status = ReleaseSemaphore(m_sem, 1, &sem_prev_val);
+	assert(status == TRUE);
+	assert(sem_prev_val == 0);
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::ReadOp
+//--------
+
+inline GSP_RW::ReadOp::ReadOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	int	status;
+
 	status = WaitForSingleObject(m_sync.m_mutex, INFINITE);
 	assert(status == WAIT_OBJECT_0);
 
-	m_sync.m_reader_count --;
+	m_sync.m_reader_count ++;
 
-	if (m_sync.m_reader_count == 0) {
-		status = ReleaseSemaphore(m_sync.m_sem, 1, &sem_prev_val);
-		assert(status == TRUE);
-		assert(sem_prev_val == 0);
+	//--------
+	// Only the first reader waits for a writer to finish; the
+	// other readers wait for it on m_mutex, which is not counted
+	// as contention.
+	//--------
+	if (m_sync.m_reader_count == 1) {
+#if defined(GSP_ENABLE_STATS)
+		if (WaitForSingleObject(m_sync.m_sem, 0) != WAIT_OBJECT_0) {
+			GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+			status = WaitForSingleObject(m_sync.m_sem, INFINITE);
+			assert(status == WAIT_OBJECT_0);
+			GSP_STATS_WAIT_END(m_sync.m_stats);
+		}
+#else
+		status = WaitForSingleObject(m_sync.m_sem, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+#endif
 	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
 
 	status = ReleaseMutex(m_sync.m_mutex);
 	assert(status == TRUE);
@@ -173,6 +359,13 @@ inline GSP_RW::ReadOp::~ReadOp()
 
 
 
+inline GSP_RW::ReadOp::~ReadOp()
+{
+	m_sync.releaseRead();
+}
+
+
+
 
 
 //--------
@@ -184,20 +377,149 @@ inline GSP_RW::WriteOp::WriteOp(GSP_RW &sync_data)
 {
 	int	status;
 
+#if defined(GSP_ENABLE_STATS)
+	if (WaitForSingleObject(m_sync.m_sem, 0) != WAIT_OBJECT_0) {
+		GSP_STATS_WAIT_BEGIN(m_sync.m_stats);
+		status = WaitForSingleObject(m_sync.m_sem, INFINITE);
+		assert(status == WAIT_OBJECT_0);
+		GSP_STATS_WAIT_END(m_sync.m_stats);
+	}
+	GSP_STATS_ACQUIRED(m_sync.m_stats);
+#else
 	status = WaitForSingleObject(m_sync.m_sem, INFINITE);
 	assert(status == WAIT_OBJECT_0);
+#endif
 }
 
 
 
 inline GSP_RW::WriteOp::~WriteOp()
 {
-	int	status;
-	LONG	sem_prev_val;
+	m_sync.releaseWrite();
+}
 
-	status = ReleaseSemaphore(m_sync.m_sem, 1, &sem_prev_val);
-	assert(status == TRUE);
-	assert(sem_prev_val == 0);
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TryReadOp
+//--------
+
+inline GSP_RW::TryReadOp::TryReadOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(0);
+}
+
+
+
+inline GSP_RW::TryReadOp::~TryReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TryReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedReadOp
+//--------
+
+inline GSP_RW::TimedReadOp::TimedReadOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireRead(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedReadOp::~TimedReadOp()
+{
+	if (m_acquired) {
+		m_sync.releaseRead();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedReadOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TryWriteOp
+//--------
+
+inline GSP_RW::TryWriteOp::TryWriteOp(GSP_RW &sync_data)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(0);
+}
+
+
+
+inline GSP_RW::TryWriteOp::~TryWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TryWriteOp::acquired() const
+{
+	return m_acquired;
+}
+
+
+
+
+
+//--------
+// Inline implementation of class GSP_RW::TimedWriteOp
+//--------
+
+inline GSP_RW::TimedWriteOp::TimedWriteOp(GSP_RW &sync_data, long timeout_ms)
+        : m_sync(sync_data)
+{
+	m_acquired = m_sync.acquireWrite(timeout_ms);
+}
+
+
+
+inline GSP_RW::TimedWriteOp::~TimedWriteOp()
+{
+	if (m_acquired) {
+		m_sync.releaseWrite();
+	}
+}
+
+
+
+inline bool
+GSP_RW::TimedWriteOp::acquired() const
+{
+	return m_acquired;
 }
 
 
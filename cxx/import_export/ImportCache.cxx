@@ -0,0 +1,420 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ImportCache.cxx
+//
+// Description: An opt-in cache of the object references returned by
+//		corbautil::importObjRef()
+//----------------------------------------------------------------------
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "ImportCache.h"
+#include "gsp_timeout.h"
+#include <string.h>
+#include <assert.h>
+using std::string;
+
+
+
+
+
+namespace corbautil
+{
+
+//----------------------------------------------------------------------
+// Function:	Constructor
+//
+// Description:
+//----------------------------------------------------------------------
+
+ImportCache::ImportCache(
+	CORBA::ORB_ptr			orb,
+	long				ttl_ms,
+	CORBA::ULong			max_entries)
+{
+	int				i;
+
+	m_orb         = CORBA::ORB::_duplicate(orb);
+	m_ttl_usecs   = ttl_ms * 1000.0;
+	m_max_entries = (max_entries == 0) ? 1 : max_entries;
+	m_size        = 0;
+	m_hits        = 0;
+	m_misses      = 0;
+	m_lru_head    = 0;
+	m_lru_tail    = 0;
+	for (i = 0; i < numBuckets; i++) {
+		m_buckets[i] = 0;
+	}
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	Destructor
+//
+// Description:	No thread may be using the cache.
+//----------------------------------------------------------------------
+
+ImportCache::~ImportCache()
+{
+	invalidateAll();
+	assert(m_size == 0);
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	importObjRef()
+//
+// Description:	The first thread to miss on "instructions" inserts an
+//		entry that is marked as loading, and imports the
+//		reference without holding m_mutex. Threads that find
+//		the entry while it is loading wait on its "loaded"
+//		GSP_ProdCons, which is used as a counting semaphore:
+//		the loading thread puts one item into it for each of
+//		them.
+//----------------------------------------------------------------------
+
+CORBA::Object_ptr
+ImportCache::importObjRef(const char * instructions)
+	throw(ImportExportException)
+{
+	CORBA::Object_var		obj;
+	CORBA::String_var		error;
+	unsigned long			index;
+	Entry *				e;
+	double				now;
+	CORBA::Boolean			isLoader;
+
+	index = hash(instructions) % numBuckets;
+	now = gsp_now_usecs();
+	{
+		GSP_Mutex::Op		scopedLock(m_mutex);
+
+		e = find(instructions, index);
+		if (e != 0 && !e->loading
+		    && (m_ttl_usecs <= 0 || now < e->expiry))
+		{
+			m_hits ++;
+			touch(e);
+			return CORBA::Object::_duplicate(e->obj.in());
+		}
+		if (e != 0 && e->loading) {
+			m_hits ++;
+			e->refs ++;
+			e->waiters ++;
+			isLoader = 0;
+		} else {
+			m_misses ++;
+			if (e == 0) {
+				e = new Entry();
+				e->key      = CORBA::string_dup(instructions);
+				e->expiry   = 0;
+				e->linked   = 1;
+				e->refs     = 0;
+				e->waiters  = 0;
+				e->next     = m_buckets[index];
+				e->lru_prev = 0;
+				e->lru_next = 0;
+				m_buckets[index] = e;
+				m_size ++;
+				touch(e);
+			}
+			e->loading = 1;
+			evict();
+			e->refs ++;
+			isLoader = 1;
+		}
+	}
+
+	if (!isLoader) {
+		//--------
+		// Wait for the thread that is importing the reference
+		//--------
+		{ GSP_ProdCons::GetOp	getOp(e->loaded); }
+
+		GSP_Mutex::Op		scopedLock(m_mutex);
+
+		obj = CORBA::Object::_duplicate(e->obj.in());
+		if (e->error.in() != 0) {
+			error = CORBA::string_dup(e->error.in());
+		}
+		release(e);
+	} else {
+		//--------
+		// We are the thread that imports the reference
+		//--------
+		try {
+			obj = corbautil::importObjRef(m_orb.in(), instructions);
+		} catch(const ImportExportException & ex) {
+			error = CORBA::string_dup(ex.msg.in());
+		}
+
+		GSP_Mutex::Op		scopedLock(m_mutex);
+
+		e->loading = 0;
+		if (error.in() == 0) {
+			e->obj    = CORBA::Object::_duplicate(obj.in());
+			e->error  = (char *)0;
+			e->expiry = gsp_now_usecs() + m_ttl_usecs;
+		} else {
+			e->obj    = CORBA::Object::_nil();
+			e->error  = CORBA::string_dup(error.in());
+			if (e->linked) {
+				unlink(e); // failures are not cached
+			}
+		}
+		if (e->waiters > 0) {
+			GSP_ProdCons::PutBatchOp	putOp(e->loaded,
+							      e->waiters);
+			e->waiters = 0;
+		}
+		release(e);
+	}
+
+	if (error.in() != 0) {
+		throw ImportExportException(string(error.in()));
+	}
+	return obj._retn();
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	invalidate()
+//
+// Description:	If the reference is being imported then the result is
+//		given to the threads waiting for it but is not cached.
+//----------------------------------------------------------------------
+
+void
+ImportCache::invalidate(const char * instructions)
+{
+	GSP_Mutex::Op			scopedLock(m_mutex);
+	Entry *				e;
+
+	e = find(instructions, hash(instructions) % numBuckets);
+	if (e != 0) {
+		unlink(e);
+	}
+}
+
+
+
+
+
+void
+ImportCache::invalidateAll()
+{
+	GSP_Mutex::Op			scopedLock(m_mutex);
+
+	while (m_lru_head != 0) {
+		unlink(m_lru_head);
+	}
+}
+
+
+
+
+
+unsigned long
+ImportCache::hits()
+{
+	GSP_Mutex::Op			scopedLock(m_mutex);
+
+	return m_hits;
+}
+
+
+
+
+
+unsigned long
+ImportCache::misses()
+{
+	GSP_Mutex::Op			scopedLock(m_mutex);
+
+	return m_misses;
+}
+
+
+
+
+
+CORBA::ULong
+ImportCache::size()
+{
+	GSP_Mutex::Op			scopedLock(m_mutex);
+
+	return m_size;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// The following helper operations must be called with m_mutex locked
+//----------------------------------------------------------------------
+
+unsigned long
+ImportCache::hash(const char * str)
+{
+	unsigned long			h;
+
+	h = 5381;
+	for (; *str != '\0'; str++) {
+		h = h * 33 + (unsigned char)*str;
+	}
+	return h;
+}
+
+
+
+
+
+ImportCache::Entry *
+ImportCache::find(const char * key, unsigned long index)
+{
+	Entry *				e;
+
+	for (e = m_buckets[index]; e != 0; e = e->next) {
+		if (strcmp(e->key.in(), key) == 0) {
+			return e;
+		}
+	}
+	return 0;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	unlink()
+//
+// Description:	Removes "e" from the hash table and the LRU list. It is
+//		deleted now if no thread is using it, or else by the
+//		last thread to release() it.
+//----------------------------------------------------------------------
+
+void
+ImportCache::unlink(Entry * e)
+{
+	Entry **			ptr;
+
+	assert(e->linked);
+	ptr = &m_buckets[hash(e->key.in()) % numBuckets];
+	while (*ptr != e) {
+		ptr = &(*ptr)->next;
+	}
+	*ptr = e->next;
+
+	if (e->lru_prev != 0) {
+		e->lru_prev->lru_next = e->lru_next;
+	} else {
+		m_lru_head = e->lru_next;
+	}
+	if (e->lru_next != 0) {
+		e->lru_next->lru_prev = e->lru_prev;
+	} else {
+		m_lru_tail = e->lru_prev;
+	}
+
+	e->linked = 0;
+	m_size --;
+	if (e->refs == 0) {
+		delete e;
+	}
+}
+
+
+
+
+
+void
+ImportCache::release(Entry * e)
+{
+	e->refs --;
+	if (e->refs == 0 && !e->linked) {
+		delete e;
+	}
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	touch()
+//
+// Description:	Moves "e" to the head of the LRU list. "e" might not
+//		be in the list yet.
+//----------------------------------------------------------------------
+
+void
+ImportCache::touch(Entry * e)
+{
+	if (m_lru_head == e) {
+		return;
+	}
+	if (e->lru_prev != 0) {
+		e->lru_prev->lru_next = e->lru_next;
+		if (e->lru_next != 0) {
+			e->lru_next->lru_prev = e->lru_prev;
+		} else {
+			m_lru_tail = e->lru_prev;
+		}
+	}
+	e->lru_prev = 0;
+	e->lru_next = m_lru_head;
+	if (m_lru_head != 0) {
+		m_lru_head->lru_prev = e;
+	} else {
+		m_lru_tail = e;
+	}
+	m_lru_head = e;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	evict()
+//
+// Description:	Removes least recently used entries until there are no
+//		more than m_max_entries. Entries that are being imported
+//		are not removed.
+//----------------------------------------------------------------------
+
+void
+ImportCache::evict()
+{
+	Entry *				e;
+	Entry *				prev;
+
+	for (e = m_lru_tail; e != 0 && m_size > m_max_entries; e = prev) {
+		prev = e->lru_prev;
+		if (!e->loading) {
+			unlink(e);
+		}
+	}
+}
+
+
+
+}; // namespace corbautil
@@ -0,0 +1,129 @@
+//----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	ImportCache.h
+//
+// Description: An opt-in cache of the object references returned by
+//		corbautil::importObjRef(), keyed by the import
+//		instructions. A cached reference is returned until it is
+//		"ttl_ms" milliseconds old, so a client that imports the
+//		same reference many times contacts the Naming Service
+//		(or reads the file, or runs the command) only once per
+//		TTL. If several threads miss on the same instructions
+//		at the same time then only one of them imports the
+//		reference and the others wait for its result.
+//
+//		The cache holds at most "max_entries" references; the
+//		least recently used one is removed to make room for a
+//		new one. Failed imports are not cached. A client that
+//		gets an exception such as TRANSIENT or OBJECT_NOT_EXIST
+//		when using a cached reference should call invalidate()
+//		before importing it again.
+//
+// Example of usage:
+//
+//	corbautil::ImportCache	cache(orb, 30000, 100); // 30 secs, 100 refs
+//	CORBA::Object_var	obj;
+//
+//	obj = cache.importObjRef("name_service#foo/bar");
+//----------------------------------------------------------------------
+
+#ifndef IMPORT_CACHE_H_
+#define IMPORT_CACHE_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include "import_export.h"
+#include "gsp_mutex.h"
+#include "gsp_prodcons.h"
+
+
+
+namespace corbautil
+{
+	class ImportCache
+	{
+	public:
+		//--------
+		// A "ttl_ms" of 0 means that references do not expire.
+		//--------
+		ImportCache(
+			CORBA::ORB_ptr		orb,
+			long			ttl_ms,
+			CORBA::ULong		max_entries);
+		~ImportCache();
+
+		//--------
+		// Like corbautil::importObjRef(orb, instructions)
+		//--------
+		CORBA::Object_ptr	importObjRef(const char * instructions)
+						throw(ImportExportException);
+
+		//--------
+		// Remove the reference for "instructions", or all
+		// references, so that they are imported again.
+		//--------
+		void			invalidate(const char * instructions);
+		void			invalidateAll();
+
+		//--------
+		// Statistics. A call that waits for a concurrent
+		// import of the same reference counts as a hit.
+		//--------
+		unsigned long		hits();
+		unsigned long		misses();
+		CORBA::ULong		size();
+
+	private:
+		enum { numBuckets = 256 };
+
+		struct Entry {
+			CORBA::String_var	key;
+			CORBA::Object_var	obj;
+			CORBA::String_var	error;	// if the import failed
+			double			expiry;	// gsp_now_usecs()
+			CORBA::Boolean		loading;
+			CORBA::Boolean		linked;	// in m_buckets
+			long			refs;	// threads using it
+			long			waiters;
+			GSP_ProdCons		loaded;
+			Entry *			next;	// in bucket
+			Entry *			lru_prev;
+			Entry *			lru_next;
+		};
+
+		static unsigned long	hash(const char * str);
+		Entry *			find(const char * key, unsigned long index);
+		void			unlink(Entry * e);
+		void			release(Entry * e);
+		void			touch(Entry * e);
+		void			evict();
+
+		CORBA::ORB_var		m_orb;
+		double			m_ttl_usecs;
+		CORBA::ULong		m_max_entries;
+		CORBA::ULong		m_size;
+		unsigned long		m_hits;
+		unsigned long		m_misses;
+		Entry *			m_buckets[numBuckets];
+		Entry *			m_lru_head;	// most recently used
+		Entry *			m_lru_tail;
+		GSP_Mutex		m_mutex;
+
+		//--------
+		// Not implemented
+		//--------
+		ImportCache(const ImportCache &);
+		ImportCache & operator=(const ImportCache &);
+	};
+
+}; // namespace corbautil
+
+
+#endif /* IMPORT_CACHE_H_ */
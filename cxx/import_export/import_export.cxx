@@ -84,11 +84,20 @@
 
 #include "p_CosNaming_stub.h"
 #include "p_fstream.h"
+#include "gsp_mutex.h"
+#include "ThreadPool.h"
+#include "gsp_prodcons.h"
+#include "p_create_detached_thread.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <assert.h>
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
 using std::string;
 
 
@@ -110,8 +119,32 @@ static const char *			corbaloc_srv_prefix= "corbaloc_server#";
 static const char *			file_prefix        = "file#";
 static const char *			exec_prefix        = "exec#";
 static const char *			java_class_prefix  = "java_class#";
+static const char *			first_of_prefix    = "first_of#";
+static const char *			failover_prefix    = "failover#";
 static const char *			ior_placeholder    = "IOR";
-#define	MAX_STR_IOR_LEN			10240
+static const long			initialLineSize    = 4096;
+static const long			maxLineSizeHint    = 1024 * 1024;
+
+
+
+
+
+//--------
+// Cache of the naming contexts returned by contactNs(), keyed by ORB
+// and Naming Service address ("" for the initial reference). The
+// entries are deliberately never freed at process exit, because an
+// ORB may not allow references to be released after it is destroyed.
+// Use forgetNamingContexts() to release them before that.
+//--------
+struct NsCacheEntry {
+	CORBA::ORB_var			orb;
+	CORBA::String_var		ns_addr;
+	CosNaming::NamingContext_var	ns_obj;
+	NsCacheEntry *			next;
+};
+
+static GSP_Mutex			nsCacheMutex;
+static NsCacheEntry *			nsCacheHead = 0;
 
 
 
@@ -158,9 +191,23 @@ importObjRefWithExec(
 	CORBA::ORB_ptr		orb,
 	const char *		instructions) throw(ImportExportException);
 
+static CORBA::Object_ptr
+importObjRefWithAlternatives(
+	CORBA::ORB_ptr		orb,
+	const char *		instructions) throw(ImportExportException);
+
 static CosNaming::NamingContext_ptr contactNs(
 	CORBA::ORB_ptr		orb,
-	const char *		ns_addr) throw(ImportExportException);
+	const char *		ns_addr,
+	CORBA::Boolean &	cached) throw(ImportExportException);
+
+static void forgetNs(
+	CORBA::ORB_ptr			orb,
+	const char *			ns_addr,
+	CosNaming::NamingContext_ptr	ns_obj);
+
+static CORBA::Boolean
+isNsUnreachable(const CORBA::Exception & ex);
 
 static void
 exportObjRefWithCorbalocServer(
@@ -177,6 +224,12 @@ splitIntoComponents(const char * str, char delimiter);
 static char *
 removeEscChars(const char * str);
 
+static char *
+removeEscDelimiter(const char * str, char delimiter);
+
+static char *
+trimWhitespace(const char * str);
+
 static CORBA::Boolean
 hasUrlPrefix(const char * instructions);
 
@@ -184,6 +237,14 @@ static char * getPathInNsFromInstructions(const char * instructions);
 
 static char * getNsAddressFromInstructions(const char * instructions);
 
+static char * readLine(FILE * file, long size_hint);
+
+static CORBA::Object_ptr
+stringToObject(
+	CORBA::ORB_ptr		orb,
+	const char *		instructions,
+	const char *		str_ior) throw(ImportExportException);
+
 
 inline int
 strStartsWith(const char * str, const char * prefix)
@@ -250,6 +311,10 @@ importObjRef(
 		result = importObjRefWithFile(orb, instructions);
 	} else if (strncmp(instructions, exec_prefix, strlen(exec_prefix)) == 0) {
 		result = importObjRefWithExec(orb, instructions);
+	} else if (strStartsWith(instructions, first_of_prefix)
+		   || strStartsWith(instructions, failover_prefix))
+	{
+		result = importObjRefWithAlternatives(orb, instructions);
 	} else if (hasUrlPrefix(instructions)) {
 		result = importObjRefWithUrl(orb, instructions);
 	} else if (strncmp(instructions, java_class_prefix,
@@ -277,6 +342,723 @@ importObjRef(
 
 
 
+//----------------------------------------------------------------------
+// Implementation of exportObjRefs() and importObjRefs().
+//
+// The items are copied into BulkEntry objects. "name_service#..."
+// entries are linked into a BulkGroup per Naming Service address and
+// parent context; one BulkGroupTask per group resolves the parent
+// context and then submits a BulkEntryTask per entry, which binds or
+// resolves just the last name component. Other entries get a
+// BulkEntryTask of their own that calls exportObjRef() or
+// importObjRef(). All the tasks run in a ThreadPool.
+//----------------------------------------------------------------------
+
+struct BulkEntry {
+	const char *			instructions;
+	CORBA::Object_ptr		obj;	// to export
+	CORBA::Object_var		result;	// of the import
+	CORBA::String_var		error;
+	CosNaming::Name_var		last;	// last name component
+	BulkEntry *			next;	// in the BulkGroup
+};
+
+struct BulkGroup {
+	string				key;
+	CORBA::String_var		ns_addr;
+	CosNaming::Name_var		parent;	// path of parent context
+	BulkEntry *			head;
+	BulkGroup *			next;
+};
+
+struct BulkJob {
+	CORBA::ORB_ptr			orb;
+	CORBA::Boolean			isExport;
+	ThreadPool *			pool;
+};
+
+
+
+
+
+static void
+setBulkError(
+	BulkJob &			job,
+	BulkEntry *			e,
+	const char *			msg)
+{
+	strstream			out;
+
+	out	<< (job.isExport ? "export" : "import")
+		<< " failed for instructions '"
+		<< e->instructions
+		<< "': "
+		<< msg
+		<< ends;
+	e->error = CORBA::string_dup(out.str());
+	out.rdbuf()->freeze(0);
+}
+
+
+
+
+
+static void
+runSingle(BulkJob & job, BulkEntry * e)
+{
+	try {
+		if (job.isExport) {
+			exportObjRef(job.orb, e->obj, e->instructions);
+		} else {
+			e->result = importObjRef(job.orb, e->instructions);
+		}
+	} catch (const ImportExportException & ex) {
+		e->error = CORBA::string_dup(ex.msg.in());
+	}
+}
+
+
+
+
+
+class BulkEntryTask : public ThreadPoolTask {
+public:
+	BulkEntryTask(
+		BulkJob &			job,
+		BulkEntry *			e,
+		CosNaming::NamingContext_ptr	ctx)
+		: m_job(job), m_entry(e)
+	{
+		m_ctx = CosNaming::NamingContext::_duplicate(ctx);
+	}
+
+	virtual void run()
+	{
+		if (CORBA::is_nil(m_ctx)) {
+			runSingle(m_job, m_entry);
+			return;
+		}
+		try {
+			if (m_job.isExport) {
+				m_ctx->rebind(m_entry->last.in(), m_entry->obj);
+			} else {
+				m_entry->result = m_ctx->resolve(
+							m_entry->last.in());
+				if (CORBA::is_nil(m_entry->result)) {
+					setBulkError(m_job, m_entry,
+					    "it produced a nil object reference");
+				}
+			}
+		}
+		catch (const CORBA::Exception & ex) {
+			if (isNsUnreachable(ex)) {
+				//--------
+				// Let exportObjRef() or importObjRef()
+				// contact the Naming Service again.
+				//--------
+				runSingle(m_job, m_entry);
+				return;
+			}
+			strstream	out;
+			out	<< (m_job.isExport ? "rebind" : "resolve")
+				<< "() failed: "
+				<< ex
+				<< ends;
+			setBulkError(m_job, m_entry, out.str());
+			out.rdbuf()->freeze(0);
+		}
+	}
+
+private:
+	BulkJob &			m_job;
+	BulkEntry *			m_entry;
+	CosNaming::NamingContext_var	m_ctx;
+};
+
+
+
+
+
+class BulkGroupTask : public ThreadPoolTask {
+public:
+	BulkGroupTask(BulkJob & job, BulkGroup * g)
+		: m_job(job), m_group(g) { }
+
+	virtual void run()
+	{
+		CosNaming::NamingContext_var	ctx;
+		BulkEntry *			e;
+
+		try {
+			ctx = parentContext();
+		} catch (const ImportExportException & ex) {
+			for (e = m_group->head; e != 0; e = e->next) {
+				setBulkError(m_job, e, ex.msg.in());
+			}
+			return;
+		}
+		for (e = m_group->head; e != 0; e = e->next) {
+			m_job.pool->submit(
+				new BulkEntryTask(m_job, e, ctx.in()));
+		}
+	}
+
+private:
+	CosNaming::NamingContext_ptr parentContext()
+		throw(ImportExportException)
+	{
+		CosNaming::NamingContext_var	ns_obj;
+		CosNaming::NamingContext_var	ctx;
+		CORBA::Object_var		obj;
+		CORBA::Boolean			cached;
+		int				attempt;
+
+		for (attempt = 0; ; attempt++) {
+			try {
+				ns_obj = contactNs(m_job.orb,
+						m_group->ns_addr.in(), cached);
+			} catch (const ImportExportException & ex) {
+				string msg = string("failed to contact the ")
+					+ "Naming Service: " + ex.msg.in();
+				throw ImportExportException(msg);
+			}
+			if (m_group->parent->length() == 0) {
+				return ns_obj._retn();
+			}
+			try {
+				obj = ns_obj->resolve(m_group->parent.in());
+				ctx = CosNaming::NamingContext::_narrow(obj);
+				break;
+			}
+			catch (const CORBA::Exception & ex) {
+				if (isNsUnreachable(ex)) {
+					forgetNs(m_job.orb,
+						m_group->ns_addr.in(),
+						ns_obj.in());
+					if (cached && attempt == 0) {
+						continue;
+					}
+				}
+				strstream	out;
+				out	<< "resolve() of the parent context "
+					<< "failed: "
+					<< ex
+					<< ends;
+				throw ImportExportException(out);
+			}
+		}
+		if (CORBA::is_nil(ctx)) {
+			string msg = "the parent context is not a "
+				     "CosNaming::NamingContext";
+			throw ImportExportException(msg);
+		}
+		return ctx._retn();
+	}
+
+	BulkJob &			m_job;
+	BulkGroup *			m_group;
+};
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	runBulk()
+//
+// Description:	Groups "entries", runs the tasks and waits for them.
+//		Returns the number of entries that failed.
+//----------------------------------------------------------------------
+
+static CORBA::ULong
+runBulk(
+	BulkJob &			job,
+	BulkEntry *			entries,
+	CORBA::ULong			num_entries,
+	CORBA::ULong			max_threads)
+{
+	ThreadPool *			pool;
+	BulkGroup *			groups;
+	BulkGroup *			g;
+	BulkEntry *			e;
+	CosNaming::Name_var		name;
+	CORBA::String_var		path_in_ns;
+	CORBA::String_var		ns_addr;
+	CORBA::ULong			len;
+	CORBA::ULong			i;
+	CORBA::ULong			j;
+	CORBA::ULong			failed;
+	string				key;
+
+	if (num_entries == 0) {
+		return 0;
+	}
+	if (max_threads > num_entries) {
+		max_threads = num_entries;
+	}
+	if (max_threads == 0) {
+		max_threads = 1;
+	}
+	pool = new ThreadPool((int)max_threads);
+	job.pool = pool;
+	groups = 0;
+	for (i = 0; i < num_entries; i++) {
+		e = &entries[i];
+		e->next = 0;
+		if (!strStartsWith(e->instructions, ns_prefix)) {
+			pool->submit(new BulkEntryTask(job, e,
+					CosNaming::NamingContext::_nil()));
+			continue;
+		}
+		if (job.isExport && CORBA::is_nil(e->obj)) {
+			runSingle(job, e); // reports the nil reference
+			continue;
+		}
+
+		//--------
+		// Split "name_service#path_in_ns [@ns_addr]", and the
+		// name into its parent path and last component. Tasks
+		// are already running, so a malformed entry must not
+		// throw out of this function.
+		//--------
+		try {
+			path_in_ns = getPathInNsFromInstructions(
+							e->instructions);
+			ns_addr    = getNsAddressFromInstructions(
+							e->instructions);
+			name = NsStringToName(path_in_ns);
+		} catch (const ImportExportException & ex) {
+			e->error = CORBA::string_dup(ex.msg.in());
+			continue;
+		}
+		len = name->length();
+		if (len == 0) {
+			string msg = string("Invalid name in ")
+				+ (job.isExport ? "export" : "import")
+				+ " instructions '" + e->instructions + "'";
+			e->error = CORBA::string_dup(msg.c_str());
+			continue;
+		}
+		e->last = new CosNaming::Name(1);
+		e->last->length(1);
+		e->last[(CORBA::ULong)0] = name[len - 1];
+
+		key.assign(ns_addr.in(), strlen(ns_addr.in()) + 1);
+		for (j = 0; j < len - 1; j++) {
+			key.append(name[j].id.in(),
+				   strlen(name[j].id.in()) + 1);
+			key.append(name[j].kind.in(),
+				   strlen(name[j].kind.in()) + 1);
+		}
+		for (g = groups; g != 0 && g->key != key; g = g->next) {
+		}
+		if (g == 0) {
+			g = new BulkGroup();
+			g->key     = key;
+			g->ns_addr = ns_addr._retn();
+			g->parent  = new CosNaming::Name(len - 1);
+			g->parent->length(len - 1);
+			for (j = 0; j < len - 1; j++) {
+				g->parent[j] = name[j];
+			}
+			g->head    = 0;
+			g->next    = groups;
+			groups = g;
+		}
+		e->next = g->head;
+		g->head = e;
+	}
+
+	for (g = groups; g != 0; g = g->next) {
+		pool->submit(new BulkGroupTask(job, g));
+	}
+	pool->wait_all();
+	delete pool;
+
+	while (groups != 0) {
+		g = groups;
+		groups = g->next;
+		delete g;
+	}
+	failed = 0;
+	for (i = 0; i < num_entries; i++) {
+		if (entries[i].error.in() != 0) {
+			failed ++;
+		}
+	}
+	return failed;
+}
+
+
+
+
+
+CORBA::ULong
+exportObjRefs(
+	CORBA::ORB_ptr			orb,
+	ExportItem *			items,
+	CORBA::ULong			num_items,
+	CORBA::ULong			max_threads)
+{
+	BulkJob				job;
+	BulkEntry *			entries;
+	CORBA::ULong			failed;
+	CORBA::ULong			i;
+
+	entries = new BulkEntry[num_items];
+	for (i = 0; i < num_items; i++) {
+		entries[i].instructions = items[i].instructions;
+		entries[i].obj          = items[i].obj;
+	}
+	job.orb      = orb;
+	job.isExport = 1;
+	failed = runBulk(job, entries, num_items, max_threads);
+	for (i = 0; i < num_items; i++) {
+		items[i].error = entries[i].error._retn();
+	}
+	delete [] entries;
+	return failed;
+}
+
+
+
+
+
+CORBA::ULong
+importObjRefs(
+	CORBA::ORB_ptr			orb,
+	ImportItem *			items,
+	CORBA::ULong			num_items,
+	CORBA::ULong			max_threads)
+{
+	BulkJob				job;
+	BulkEntry *			entries;
+	CORBA::ULong			failed;
+	CORBA::ULong			i;
+
+	entries = new BulkEntry[num_items];
+	for (i = 0; i < num_items; i++) {
+		entries[i].instructions = items[i].instructions;
+		entries[i].obj          = CORBA::Object::_nil();
+	}
+	job.orb      = orb;
+	job.isExport = 0;
+	failed = runBulk(job, entries, num_items, max_threads);
+	for (i = 0; i < num_items; i++) {
+		items[i].obj   = entries[i].result._retn();
+		items[i].error = entries[i].error._retn();
+	}
+	delete [] entries;
+	return failed;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Implementation of "first_of#..." and "failover#<ms>#..." import
+// instructions.
+//
+// Each alternative is imported by a detached thread, so that a slow
+// alternative does not delay the others. A thread that finishes, and
+// a timer thread whose attempt has reached its deadline, put an item
+// into AltImport::events; the calling thread waits on it, as on a
+// counting semaphore, and then examines the state of the attempts.
+// Imports cannot be cancelled, so an attempt that is still running
+// when the result is known finishes in the background and its result
+// is discarded. AltImport is deleted by the last thread to use it.
+//----------------------------------------------------------------------
+
+struct AltImport {
+	GSP_Mutex			mutex;
+	GSP_ProdCons			events;
+	long				refs;
+	CORBA::ORB_var			orb;
+	CORBA::StringSeq_var		alternatives;
+	CORBA::Object_var		result;	// first non-nil one
+	string				errors;
+	CORBA::ULong			numFinished;
+	CORBA::Boolean *		failed;	// per alternative
+	CORBA::Boolean *		expired; // per alternative
+};
+
+struct AltThreadArg {
+	AltImport *			alt;
+	CORBA::ULong			index;
+	long				timeout_ms;
+};
+
+
+
+
+
+static void
+sleepMs(long ms)
+{
+#if defined(WIN32)
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	releaseAltImport()
+//
+// Description:	Drops a reference to "alt", which must not be locked.
+//----------------------------------------------------------------------
+
+static void
+releaseAltImport(AltImport * alt)
+{
+	CORBA::Boolean			last;
+
+	{
+		GSP_Mutex::Op		scopedLock(alt->mutex);
+
+		alt->refs --;
+		last = (alt->refs == 0);
+	}
+	if (last) {
+		delete [] alt->failed;
+		delete [] alt->expired;
+		delete alt;
+	}
+}
+
+
+
+
+
+static void *
+altImportThread(void * arg)
+{
+	AltThreadArg *			ta = (AltThreadArg *)arg;
+	AltImport *			alt = ta->alt;
+	const char *			instructions;
+	CORBA::Object_var		obj;
+	CORBA::String_var		error;
+
+	instructions = alt->alternatives[ta->index].in();
+	try {
+		obj = importObjRef(alt->orb.in(), instructions);
+	} catch (const ImportExportException & ex) {
+		error = CORBA::string_dup(ex.msg.in());
+	}
+
+	{
+		GSP_Mutex::Op		scopedLock(alt->mutex);
+
+		if (error.in() == 0) {
+			if (CORBA::is_nil(alt->result)) {
+				alt->result = obj._retn();
+			}
+		} else {
+			alt->failed[ta->index] = 1;
+			alt->errors = alt->errors + "\n\t'" + instructions
+				    + "': " + error.in();
+		}
+		alt->numFinished ++;
+	}
+	{ GSP_ProdCons::PutOp	putOp(alt->events); }
+
+	releaseAltImport(alt);
+	delete ta;
+	return 0;
+}
+
+
+
+
+
+static void *
+altTimerThread(void * arg)
+{
+	AltThreadArg *			ta = (AltThreadArg *)arg;
+	AltImport *			alt = ta->alt;
+
+	sleepMs(ta->timeout_ms);
+	{
+		GSP_Mutex::Op		scopedLock(alt->mutex);
+
+		alt->expired[ta->index] = 1;
+	}
+	{ GSP_ProdCons::PutOp	putOp(alt->events); }
+
+	releaseAltImport(alt);
+	delete ta;
+	return 0;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	launchAlternative()
+//
+// Description:	Starts importing alternative "index", and a timer for
+//		it if "timeout_ms" is positive. "alt" must be locked.
+//----------------------------------------------------------------------
+
+static void
+launchAlternative(AltImport * alt, CORBA::ULong index, long timeout_ms)
+{
+	AltThreadArg *			ta;
+
+	ta = new AltThreadArg();
+	ta->alt        = alt;
+	ta->index      = index;
+	ta->timeout_ms = timeout_ms;
+	alt->refs ++;
+	create_detached_thread(altImportThread, ta);
+
+	if (timeout_ms > 0) {
+		ta = new AltThreadArg();
+		ta->alt        = alt;
+		ta->index      = index;
+		ta->timeout_ms = timeout_ms;
+		alt->refs ++;
+		create_detached_thread(altTimerThread, ta);
+	}
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	importObjRefWithAlternatives()
+//
+// Description:	"first_of#<instr>|<instr>|..." imports all the
+//		alternatives concurrently and returns the first non-nil
+//		reference. "failover#<ms>#<instr>|<instr>|..." imports
+//		them one at a time, going on to the next one when the
+//		current one fails or has not succeeded within <ms>
+//		milliseconds (0 means no deadline); an earlier attempt
+//		that succeeds late is still accepted. A "|" within an
+//		alternative is written as "\|". Whitespace around an
+//		alternative is ignored.
+//----------------------------------------------------------------------
+
+static CORBA::Object_ptr
+importObjRefWithAlternatives(
+	CORBA::ORB_ptr			orb,
+	const char *			instructions) throw(ImportExportException)
+{
+	AltImport *			alt;
+	CORBA::StringSeq_var		alternatives;
+	CORBA::String_var		unescaped;
+	CORBA::Object_var		result;
+	const char *			str;
+	char *				end;
+	long				timeout_ms;
+	CORBA::Boolean			race;
+	CORBA::ULong			num;
+	CORBA::ULong			launched;
+	CORBA::ULong			i;
+	string				errors;
+
+	//--------
+	// Parse the instructions
+	//--------
+	timeout_ms = 0;
+	race = strStartsWith(instructions, first_of_prefix);
+	if (race) {
+		str = instructions + strlen(first_of_prefix);
+	} else {
+		str = instructions + strlen(failover_prefix);
+		timeout_ms = strtol(str, &end, 10);
+		if (end == str || *end != '#' || timeout_ms < 0) {
+			string msg = string("Invalid timeout in import ")
+				+ "instructions '" + instructions + "'";
+			throw ImportExportException(msg);
+		}
+		str = end + 1;
+	}
+	alternatives = splitIntoComponents(str, '|');
+	num = alternatives->length();
+	for (i = 0; i < num; i++) {
+		unescaped = removeEscDelimiter(alternatives[i].in(), '|');
+		alternatives[i] = trimWhitespace(unescaped.in());
+		if (alternatives[i].in()[0] == '\0') {
+			num = 0;
+			break;
+		}
+	}
+	if (num == 0) {
+		string msg = string("Invalid list of alternatives in ")
+			+ "import instructions '" + instructions + "'";
+		throw ImportExportException(msg);
+	}
+
+	alt = new AltImport();
+	alt->refs         = 1;
+	alt->orb          = CORBA::ORB::_duplicate(orb);
+	alt->alternatives = alternatives._retn();
+	alt->numFinished  = 0;
+	alt->failed       = new CORBA::Boolean[num];
+	alt->expired      = new CORBA::Boolean[num];
+	for (i = 0; i < num; i++) {
+		alt->failed[i]  = 0;
+		alt->expired[i] = 0;
+	}
+
+	//--------
+	// Launch the attempts, and wait for the outcome
+	//--------
+	{
+		GSP_Mutex::Op		scopedLock(alt->mutex);
+
+		if (race) {
+			for (launched = 0; launched < num; launched++) {
+				launchAlternative(alt, launched, 0);
+			}
+		} else {
+			launchAlternative(alt, 0, timeout_ms);
+			launched = 1;
+		}
+	}
+	for (;;) {
+		{ GSP_ProdCons::GetOp	getOp(alt->events); }
+
+		GSP_Mutex::Op		scopedLock(alt->mutex);
+
+		if (!CORBA::is_nil(alt->result)) {
+			result = CORBA::Object::_duplicate(alt->result.in());
+			break;
+		}
+		if (alt->numFinished == num) {
+			errors = alt->errors;
+			break;
+		}
+		if (launched < num && (alt->failed[launched - 1]
+				       || alt->expired[launched - 1]))
+		{
+			launchAlternative(alt, launched, timeout_ms);
+			launched ++;
+		}
+	}
+	releaseAltImport(alt);
+
+	if (CORBA::is_nil(result)) {
+		string msg = string("none of the alternatives in import ")
+			+ "instructions '" + instructions + "' succeeded:"
+			+ errors;
+		throw ImportExportException(msg);
+	}
+	return result._retn();
+}
+
+
+
+
+
 static void
 exportObjRefWithNs(
 	CORBA::ORB_ptr			orb,
@@ -287,6 +1069,8 @@ exportObjRefWithNs(
 	CosNaming::Name_var		name;
 	CORBA::String_var		path_in_ns;
 	CORBA::String_var		ns_addr;
+	CORBA::Boolean			cached;
+	int				attempt;
 
 	//--------
 	// Split "name_service#path_in_ns [@ns_addr]"
@@ -295,22 +1079,6 @@ exportObjRefWithNs(
 	path_in_ns = getPathInNsFromInstructions(instructions);
 	ns_addr    = getNsAddressFromInstructions(instructions);
 
-	//--------
-	// Contact the Naming Service
-	//--------
-	try {
-		ns_obj = contactNs(orb, ns_addr.in());
-	} catch (const ImportExportException & ex) {
-		strstream	out;
-		out	<< "failed to contact the Naming Service in "
-			<< "export instructions '"
-			<< instructions
-			<< "': "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
-	}
-
 	//--------
 	// Convert "NameService#path-in-ns" into CosNaming::Name format
 	//--------
@@ -318,23 +1086,51 @@ exportObjRefWithNs(
 	if (name->length() == 0) {
 		string msg = string("Invalid name in export ")
 			+ "instructions '" + instructions + "'";
-		throw ImportExportException(msg);
-	}
-
-	//--------
-	// (re)bind the object into the Naming Service
-	//--------
-	try {
-		ns_obj->rebind(name.in(), obj);
+		throw ImportExportException(msg);
 	}
-	catch (const CORBA::Exception & ex) {
-		strstream	out;
-		out	<< "export failed for instructions '"
-			<< instructions
-			<< "': rebind() failed: "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
+
+	for (attempt = 0; ; attempt++) {
+		//--------
+		// Contact the Naming Service
+		//--------
+		try {
+			ns_obj = contactNs(orb, ns_addr.in(), cached);
+		} catch (const ImportExportException & ex) {
+			strstream	out;
+			out	<< "failed to contact the Naming Service in "
+				<< "export instructions '"
+				<< instructions
+				<< "': "
+				<< ex
+				<< ends;
+			throw ImportExportException(out);
+		}
+
+		//--------
+		// (re)bind the object into the Naming Service.
+		// If a cached naming context cannot be reached then the
+		// Naming Service might have been restarted, so contact it
+		// again and retry once.
+		//--------
+		try {
+			ns_obj->rebind(name.in(), obj);
+			break;
+		}
+		catch (const CORBA::Exception & ex) {
+			if (isNsUnreachable(ex)) {
+				forgetNs(orb, ns_addr.in(), ns_obj.in());
+				if (cached && attempt == 0) {
+					continue;
+				}
+			}
+			strstream	out;
+			out	<< "export failed for instructions '"
+				<< instructions
+				<< "': rebind() failed: "
+				<< ex
+				<< ends;
+			throw ImportExportException(out);
+		}
 	}
 }
 
@@ -352,6 +1148,8 @@ importObjRefWithNs(
 	CORBA::Object_ptr		result;
 	CORBA::String_var		path_in_ns;
 	CORBA::String_var		ns_addr;
+	CORBA::Boolean			cached;
+	int				attempt;
 
 	//--------
 	// Split "name_service#path_in_ns [@ns_addr]"
@@ -360,22 +1158,6 @@ importObjRefWithNs(
 	path_in_ns = getPathInNsFromInstructions(instructions);
 	ns_addr    = getNsAddressFromInstructions(instructions);
 
-	//--------
-	// Contact the Naming Service
-	//--------
-	try {
-		ns_obj = contactNs(orb, ns_addr.in());
-	} catch (const ImportExportException & ex) {
-		strstream	out;
-		out	<< "failed to contact the Naming Service in "
-			<< "import instructions '"
-			<< instructions
-			<< "': "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
-	}
-
 	//--------
 	// Convert "NameService#path-in-ns" into CosNaming::Name format
 	//--------
@@ -386,20 +1168,48 @@ importObjRefWithNs(
 		throw ImportExportException(msg);
 	}
 
-	//--------
-	// resolve() the object from the Naming Service
-	//--------
-	try {
-		result = ns_obj->resolve(name.in());
-	}
-	catch (const CORBA::Exception & ex) {
-		strstream	out;
-		out	<< "import failed for instructions '"
-			<< instructions
-			<< "': resolve() failed: "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
+	for (attempt = 0; ; attempt++) {
+		//--------
+		// Contact the Naming Service
+		//--------
+		try {
+			ns_obj = contactNs(orb, ns_addr.in(), cached);
+		} catch (const ImportExportException & ex) {
+			strstream	out;
+			out	<< "failed to contact the Naming Service in "
+				<< "import instructions '"
+				<< instructions
+				<< "': "
+				<< ex
+				<< ends;
+			throw ImportExportException(out);
+		}
+
+		//--------
+		// resolve() the object from the Naming Service.
+		// If a cached naming context cannot be reached then the
+		// Naming Service might have been restarted, so contact it
+		// again and retry once.
+		//--------
+		try {
+			result = ns_obj->resolve(name.in());
+			break;
+		}
+		catch (const CORBA::Exception & ex) {
+			if (isNsUnreachable(ex)) {
+				forgetNs(orb, ns_addr.in(), ns_obj.in());
+				if (cached && attempt == 0) {
+					continue;
+				}
+			}
+			strstream	out;
+			out	<< "import failed for instructions '"
+				<< instructions
+				<< "': resolve() failed: "
+				<< ex
+				<< ends;
+			throw ImportExportException(out);
+		}
 	}
 
 	return result;
@@ -458,13 +1268,9 @@ importObjRefWithFile(
 	CORBA::ORB_ptr		orb,
 	const char *		instructions) throw(ImportExportException)
 {
-	CORBA::Object_ptr	obj;
-	char			str_ior[MAX_STR_IOR_LEN+1];
+	CORBA::String_var	str_ior;
 	FILE *			in_file;
-	char *			fgets_result;
-	int			len;
-
-	obj = CORBA::Object::_nil();
+	long			size;
 
 	//--------
 	// Open the file
@@ -477,49 +1283,27 @@ importObjRefWithFile(
 	}
 
 	//--------
-	// Read the stringified object reference from the file
+	// Read the stringified object reference from the file. The size
+	// of the file, if it can be found, is used to read it in one go.
 	//--------
-	str_ior[0] = '\0';
-	fgets_result = fgets(str_ior, MAX_STR_IOR_LEN+1, in_file);
+	size = 0;
+	if (fseek(in_file, 0, SEEK_END) == 0) {
+		size = ftell(in_file);
+		if (fseek(in_file, 0, SEEK_SET) != 0) {
+			size = -1;
+		}
+	}
+	if (size >= 0) {
+		str_ior = readLine(in_file, size);
+	}
 	fclose(in_file);
-	if (fgets_result != str_ior) {
+	if (str_ior.in() == 0) {
 		string msg = string("Error reading file in import ")
 			+ "instructions '" + instructions + "'";
 		throw ImportExportException(msg);
 	}
-	len = strlen(str_ior);
-	if (len == MAX_STR_IOR_LEN) {
-		string msg = string("Error reading file in import ")
-			+ "instructions '" + instructions + "': first line "
-			+ "in the file is too long";
-		throw ImportExportException(msg);
-	}
-
-	//--------
-	// Remove any trailing crap, for example, whitespace
-	//--------
-	while (len > 0 && !isalnum(str_ior[len-1])) {
-		str_ior[len-1] = '\0';
-		len --;
-	}
-
-	//--------
-	// Unstringify the object reference
-	//--------
-	try {
-		obj = orb->string_to_object(str_ior);
-	}
-	catch (CORBA::Exception & ex) {
-		strstream	out;
-		out	<< "import failed for instructions '"
-			<< instructions
-			<< "': string_to_object() failed: "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
-	}
 
-	return obj;
+	return stringToObject(orb, instructions, str_ior.in());
 }
 
 
@@ -624,11 +1408,7 @@ importObjRefWithExec(
 	const char *		instructions) throw(ImportExportException)
 {
 	FILE *			file;
-	char			str_ior[MAX_STR_IOR_LEN+1];
-	int			len;
-	CORBA::Object_ptr	obj;
-
-	obj = CORBA::Object::_nil();
+	CORBA::String_var	str_ior;
 
 	//--------
 	// Open a pipe to the the command line
@@ -648,30 +1428,102 @@ importObjRefWithExec(
 	// Read the stringified object reference from the standard output
 	// of the comand.
 	//--------
-	if (fgets(str_ior, MAX_STR_IOR_LEN, file) != str_ior) {
+	str_ior = readLine(file, 0);
+#ifdef WIN32
+	_pclose(file);
+#else
+	pclose(file);
+#endif
+	if (str_ior.in() == 0) {
 		string msg = string("Error executing command in ")
 			+ "import instructions '" + instructions + "'";
 		throw ImportExportException(msg);
 	}
-	len = strlen(str_ior);
-	if (len == MAX_STR_IOR_LEN) {
-		string msg = string("Error reading standard output ")
-			+ "from import instructions '" + instructions
-			+ "': first line in output is too long";
-		throw ImportExportException(msg);
+
+	return stringToObject(orb, instructions, str_ior.in());
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	readLine()
+//
+// Description:	Reads the first line of "file", of any length, into a
+//		string allocated with CORBA::string_alloc(), and removes
+//		any trailing crap, for example, whitespace. fgets()
+//		reads straight into the string, which starts with room
+//		for "size_hint" characters (if it is positive and not
+//		too big) and doubles in size when it is full. Returns 0
+//		if nothing can be read.
+//----------------------------------------------------------------------
+
+static char *
+readLine(FILE * file, long size_hint)
+{
+	char *				buf;
+	char *				tmp;
+	long				size;
+	long				len;
+
+	size = initialLineSize;
+	if (size_hint > 0 && size_hint <= maxLineSizeHint) {
+		size = size_hint;
 	}
+	buf = CORBA::string_alloc(size);
+	buf[0] = '\0';
+	len = 0;
+	for (;;) {
+		if (fgets(buf + len, (int)(size - len + 1), file) == 0) {
+			break;
+		}
+		len += strlen(buf + len);
 
-	//--------
-	// Remove any trailing crap, for example, whitespace
-	//--------
-	while (len > 0 && !isalnum(str_ior[len-1])) {
-		str_ior[len-1] = '\0';
+		//--------
+		// "len" is still 0 if the line starts with a '\0'
+		//--------
+		if (len > 0 && buf[len-1] == '\n') {
+			break;
+		}
+		if (len == size) {
+			tmp = CORBA::string_alloc(size * 2);
+			memcpy(tmp, buf, len + 1);
+			CORBA::string_free(buf);
+			buf = tmp;
+			size *= 2;
+		}
+	}
+	if (len == 0 || ferror(file)) {
+		CORBA::string_free(buf);
+		return 0;
+	}
+	while (len > 0 && !isalnum(buf[len-1])) {
+		buf[len-1] = '\0';
 		len --;
 	}
+	return buf;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	stringToObject()
+//
+// Description:	Unstringifies the object reference read for
+//		"instructions"
+//----------------------------------------------------------------------
+
+static CORBA::Object_ptr
+stringToObject(
+	CORBA::ORB_ptr			orb,
+	const char *			instructions,
+	const char *			str_ior) throw(ImportExportException)
+{
+	CORBA::Object_ptr		obj;
 
-	//--------
-	// Unstringify the object reference
-	//--------
 	try {
 		obj = orb->string_to_object(str_ior);
 	}
@@ -716,14 +1568,45 @@ hasUrlPrefix(const char * instructions)
 
 
 
+//----------------------------------------------------------------------
+// Function:	contactNs()
+//
+// Description:	Returns the naming context at "ns_addr", or the initial
+//		reference if "ns_addr" is "". The narrowed context is
+//		cached, so it is obtained only once per ORB and address.
+//		"cached" is set to true if the context came from the
+//		cache rather than from the ORB.
+//----------------------------------------------------------------------
+
 static CosNaming::NamingContext_ptr
 contactNs(
 	CORBA::ORB_ptr			orb,
-	const char *			ns_addr) throw(ImportExportException)
+	const char *			ns_addr,
+	CORBA::Boolean &		cached) throw(ImportExportException)
 {
 	CosNaming::NamingContext_var	ns_obj;
 	CORBA::Object_var		obj;
+	NsCacheEntry *			e;
+
+	{
+		GSP_Mutex::Op		scopedLock(nsCacheMutex);
+
+		for (e = nsCacheHead; e != 0; e = e->next) {
+			if (e->orb.in() == orb
+			    && strcmp(e->ns_addr.in(), ns_addr) == 0)
+			{
+				cached = 1;
+				return CosNaming::NamingContext::_duplicate(
+							e->ns_obj.in());
+			}
+		}
+	}
+	cached = 0;
 
+	//--------
+	// Not cached. The lock is not held while contacting the Naming
+	// Service because importObjRef() might call contactNs() again.
+	//--------
 	if (strcmp(ns_addr, "") == 0) {
 		try {
 			obj = orb->resolve_initial_references("NameService");
@@ -759,6 +1642,30 @@ contactNs(
 		throw ImportExportException(out);
 	}
 
+	//--------
+	// Cache it, unless another thread has done so in the meantime
+	//--------
+	{
+		GSP_Mutex::Op		scopedLock(nsCacheMutex);
+
+		for (e = nsCacheHead; e != 0; e = e->next) {
+			if (e->orb.in() == orb
+			    && strcmp(e->ns_addr.in(), ns_addr) == 0)
+			{
+				break;
+			}
+		}
+		if (e == 0) {
+			e = new NsCacheEntry();
+			e->orb     = CORBA::ORB::_duplicate(orb);
+			e->ns_addr = CORBA::string_dup(ns_addr);
+			e->ns_obj  = CosNaming::NamingContext::_duplicate(
+							ns_obj.in());
+			e->next    = nsCacheHead;
+			nsCacheHead = e;
+		}
+	}
+
 	return ns_obj._retn();
 }
 
@@ -766,6 +1673,80 @@ contactNs(
 
 
 
+//----------------------------------------------------------------------
+// Function:	forgetNs()
+//
+// Description:	Removes "ns_obj" from the cache of naming contexts, if
+//		it is still cached for "orb" and "ns_addr".
+//----------------------------------------------------------------------
+
+static void
+forgetNs(
+	CORBA::ORB_ptr			orb,
+	const char *			ns_addr,
+	CosNaming::NamingContext_ptr	ns_obj)
+{
+	GSP_Mutex::Op			scopedLock(nsCacheMutex);
+	NsCacheEntry **			ptr;
+	NsCacheEntry *			e;
+
+	for (ptr = &nsCacheHead; *ptr != 0; ptr = &(*ptr)->next) {
+		e = *ptr;
+		if (e->orb.in() == orb && e->ns_obj.in() == ns_obj
+		    && strcmp(e->ns_addr.in(), ns_addr) == 0)
+		{
+			*ptr = e->next;
+			delete e;
+			return;
+		}
+	}
+}
+
+
+
+
+
+void
+forgetNamingContexts(CORBA::ORB_ptr orb)
+{
+	GSP_Mutex::Op			scopedLock(nsCacheMutex);
+	NsCacheEntry **			ptr;
+	NsCacheEntry *			e;
+
+	ptr = &nsCacheHead;
+	while (*ptr != 0) {
+		e = *ptr;
+		if (e->orb.in() == orb) {
+			*ptr = e->next;
+			delete e;
+		} else {
+			ptr = &e->next;
+		}
+	}
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	isNsUnreachable()
+//
+// Description:	True for the exceptions that mean a cached naming
+//		context should be discarded.
+//----------------------------------------------------------------------
+
+static CORBA::Boolean
+isNsUnreachable(const CORBA::Exception & ex)
+{
+	return CORBA::COMM_FAILURE::_downcast(&ex) != 0
+		|| CORBA::TRANSIENT::_downcast(&ex) != 0;
+}
+
+
+
+
+
 //----------------------------------------------------------------------
 // Function:	NsStringToName()
 //
@@ -935,6 +1916,68 @@ removeEscChars(const char * str)
 
 
 
+//----------------------------------------------------------------------
+// Function:	removeEscDelimiter()
+//
+// Description:	Like removeEscChars(), but removes only the escape
+//		characters in front of "delimiter", leaving other escape
+//		sequences for the code that parses the component.
+//----------------------------------------------------------------------
+
+static char *
+removeEscDelimiter(const char * str, char delimiter)
+{
+	int				i;
+	int				len;
+	string				buf;
+
+	len = strlen(str);
+	for (i = 0; i < len; i++) {
+		if (str[i] == '\\' && i + 1 < len) {
+			if (str[i+1] != delimiter) {
+				buf += str[i];
+			}
+			i++;
+		}
+		buf += str[i];
+	}
+	return CORBA::string_dup(buf.c_str());
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	trimWhitespace()
+//
+// Description:	Returns a copy of "str" without leading whitespace and
+//		without trailing whitespace that is not escaped.
+//----------------------------------------------------------------------
+
+static char *
+trimWhitespace(const char * str)
+{
+	const char *			start;
+	const char *			end;
+
+	start = str;
+	while (*start != '\0' && isspace(*start)) {
+		start++;
+	}
+	end = start + strlen(start);
+	while (end > start && isspace(*(end-1))
+	       && !(end - 1 > start && *(end-2) == '\\'))
+	{
+		end--;
+	}
+	return CORBA::string_dup(string(start, end - start).c_str());
+}
+
+
+
+
+
 static char *
 getPathInNsFromInstructions(const char * instructions)
 {
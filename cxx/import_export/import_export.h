@@ -21,6 +21,20 @@
 //	"name_service#<path>"              Example: "name_service#foo/bar"
 //	"file#<path/to/file>"              Example: "file#foo.ior"
 //	"exec#<cmd>"                       Example: "exec#cat foo.ior"
+//	"first_of#<instr>|<instr>|..."     Example: see below
+//	"failover#<ms>#<instr>|<instr>|..."
+//
+// "first_of#..." imports all the alternative instructions concurrently
+// and returns the first reference that is imported successfully.
+// "failover#<ms>#..." tries them in order, going on to the next one
+// when the current one fails or has not succeeded within <ms>
+// milliseconds (0 means wait for it to fail). For example:
+//
+//	"first_of#name_service#foo/bar @ corbaloc:iiop:ns1:9000/NameService|
+//	 name_service#foo/bar @ corbaloc:iiop:ns2:9000/NameService"
+//
+// (on one line). Whitespace around a "|" is ignored. Write a "|" that
+// is part of an alternative as "\|".
 //
 // Also, any of the "URL" formats supported by the ORB product are
 // allowed for import (but NOT export) instructions. For example:
@@ -114,6 +128,52 @@ namespace corbautil
 		const char *		instructions)
 			throw(ImportExportException);
 
+	//--------
+	// Bulk variants of exportObjRef() and importObjRef(). Each item
+	// is exported or imported as if by those functions, but the
+	// "name_service#..." items that share a Naming Service address
+	// and parent context are grouped: the parent context is
+	// resolved once per group, and the rebind() or resolve() calls
+	// are made in parallel by up to "max_threads" threads.
+	//
+	// They do not throw. The "error" field of an item is nil if it
+	// succeeded, and otherwise holds the message that the
+	// ImportExportException would have had. The return value is
+	// the number of items that failed.
+	//--------
+	struct ExportItem {
+		const char *		instructions;	// in
+		CORBA::Object_ptr	obj;		// in
+		CORBA::String_var	error;		// out
+	};
+
+	struct ImportItem {
+		const char *		instructions;	// in
+		CORBA::Object_var	obj;		// out
+		CORBA::String_var	error;		// out
+	};
+
+	CORBA::ULong
+	exportObjRefs(
+		CORBA::ORB_ptr		orb,
+		ExportItem *		items,
+		CORBA::ULong		num_items,
+		CORBA::ULong		max_threads = 8);
+
+	CORBA::ULong
+	importObjRefs(
+		CORBA::ORB_ptr		orb,
+		ImportItem *		items,
+		CORBA::ULong		num_items,
+		CORBA::ULong		max_threads = 8);
+
+	//--------
+	// Naming contexts used by "name_service#..." instructions are
+	// cached per ORB. Call this before destroying "orb".
+	//--------
+	void
+	forgetNamingContexts(CORBA::ORB_ptr orb);
+
 }; // namespace corbautil
 
 inline ostream& operator << (
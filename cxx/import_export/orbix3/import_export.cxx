@@ -96,7 +96,8 @@ static const char *			file_prefix       = "file#";
 static const char *			exec_prefix       = "exec#";
 static const char *			java_class_prefix = "java_class#";
 static const char *			ior_placeholder   = "IOR";
-#define	MAX_STR_IOR_LEN			10240
+static const long			initialLineSize   = 4096;
+static const long			maxLineSizeHint   = 1024 * 1024;
 
 
 
@@ -164,6 +165,14 @@ static char * getPathInNsFromInstructions(const char * instructions);
 
 static char * getNsAddressFromInstructions(const char * instructions);
 
+static char * readLine(FILE * file, long size_hint);
+
+static CORBA::Object_ptr
+stringToObject(
+	CORBA::ORB_ptr		orb,
+	const char *		instructions,
+	const char *		str_ior) throw(ImportExportException);
+
 
 
 
@@ -431,13 +440,9 @@ importObjRefWithFile(
 	CORBA::ORB_ptr		orb,
 	const char *		instructions) throw(ImportExportException)
 {
-	CORBA::Object_ptr	obj;
-	char			str_ior[MAX_STR_IOR_LEN+1];
+	CORBA::String_var	str_ior;
 	FILE *			in_file;
-	char *			fgets_result;
-	int			len;
-
-	obj = CORBA::Object::_nil();
+	long			size;
 
 	//--------
 	// Open the file
@@ -450,49 +455,27 @@ importObjRefWithFile(
 	}
 
 	//--------
-	// Read the stringified object reference from the file
+	// Read the stringified object reference from the file. The size
+	// of the file, if it can be found, is used to read it in one go.
 	//--------
-	str_ior[0] = '\0';
-	fgets_result = fgets(str_ior, MAX_STR_IOR_LEN+1, in_file);
+	size = 0;
+	if (fseek(in_file, 0, SEEK_END) == 0) {
+		size = ftell(in_file);
+		if (fseek(in_file, 0, SEEK_SET) != 0) {
+			size = -1;
+		}
+	}
+	if (size >= 0) {
+		str_ior = readLine(in_file, size);
+	}
 	fclose(in_file);
-	if (fgets_result != str_ior) {
+	if (str_ior.in() == 0) {
 		string msg = string("Error reading file in import ")
 			+ "instructions '" + instructions + "'";
 		throw ImportExportException(msg);
 	}
-	len = strlen(str_ior);
-	if (len == MAX_STR_IOR_LEN) {
-		string msg = string("Error reading file in import ")
-			+ "instructions '" + instructions + "': first line "
-			+ "in the file is too long";
-		throw ImportExportException(msg);
-	}
-
-	//--------
-	// Remove any trailing crap, for example, whitespace
-	//--------
-	while (len > 0 && !isalnum(str_ior[len-1])) {
-		str_ior[len-1] = '\0';
-		len --;
-	}
 
-	//--------
-	// Unstringify the object reference
-	//--------
-	try {
-		obj = orb->string_to_object(str_ior);
-	}
-	catch (CORBA::Exception & ex) {
-		strstream	out;
-		out	<< "import failed for instructions '"
-			<< instructions
-			<< "': string_to_object() failed: "
-			<< ex
-			<< ends;
-		throw ImportExportException(out);
-	}
-
-	return obj;
+	return stringToObject(orb, instructions, str_ior.in());
 }
 
 
@@ -597,11 +580,7 @@ importObjRefWithExec(
 	const char *		instructions) throw(ImportExportException)
 {
 	FILE *			file;
-	char			str_ior[MAX_STR_IOR_LEN+1];
-	int			len;
-	CORBA::Object_ptr	obj;
-
-	obj = CORBA::Object::_nil();
+	CORBA::String_var	str_ior;
 
 	//--------
 	// Open a pipe to the the command line
@@ -621,30 +600,102 @@ importObjRefWithExec(
 	// Read the stringified object reference from the standard output
 	// of the comand.
 	//--------
-	if (fgets(str_ior, MAX_STR_IOR_LEN, file) != str_ior) {
+	str_ior = readLine(file, 0);
+#ifdef WIN32
+	_pclose(file);
+#else
+	pclose(file);
+#endif
+	if (str_ior.in() == 0) {
 		string msg = string("Error executing command in ")
 			+ "import instructions '" + instructions + "'";
 		throw ImportExportException(msg);
 	}
-	len = strlen(str_ior);
-	if (len == MAX_STR_IOR_LEN) {
-		string msg = string("Error reading standard output ")
-			+ "from import instructions '" + instructions
-			+ "': first line in output is too long";
-		throw ImportExportException(msg);
+
+	return stringToObject(orb, instructions, str_ior.in());
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	readLine()
+//
+// Description:	Reads the first line of "file", of any length, into a
+//		string allocated with CORBA::string_alloc(), and removes
+//		any trailing crap, for example, whitespace. fgets()
+//		reads straight into the string, which starts with room
+//		for "size_hint" characters (if it is positive and not
+//		too big) and doubles in size when it is full. Returns 0
+//		if nothing can be read.
+//----------------------------------------------------------------------
+
+static char *
+readLine(FILE * file, long size_hint)
+{
+	char *				buf;
+	char *				tmp;
+	long				size;
+	long				len;
+
+	size = initialLineSize;
+	if (size_hint > 0 && size_hint <= maxLineSizeHint) {
+		size = size_hint;
 	}
+	buf = CORBA::string_alloc(size);
+	buf[0] = '\0';
+	len = 0;
+	for (;;) {
+		if (fgets(buf + len, (int)(size - len + 1), file) == 0) {
+			break;
+		}
+		len += strlen(buf + len);
 
-	//--------
-	// Remove any trailing crap, for example, whitespace
-	//--------
-	while (len > 0 && !isalnum(str_ior[len-1])) {
-		str_ior[len-1] = '\0';
+		//--------
+		// "len" is still 0 if the line starts with a '\0'
+		//--------
+		if (len > 0 && buf[len-1] == '\n') {
+			break;
+		}
+		if (len == size) {
+			tmp = CORBA::string_alloc(size * 2);
+			memcpy(tmp, buf, len + 1);
+			CORBA::string_free(buf);
+			buf = tmp;
+			size *= 2;
+		}
+	}
+	if (len == 0 || ferror(file)) {
+		CORBA::string_free(buf);
+		return 0;
+	}
+	while (len > 0 && !isalnum(buf[len-1])) {
+		buf[len-1] = '\0';
 		len --;
 	}
+	return buf;
+}
+
+
+
+
+
+//----------------------------------------------------------------------
+// Function:	stringToObject()
+//
+// Description:	Unstringifies the object reference read for
+//		"instructions"
+//----------------------------------------------------------------------
+
+static CORBA::Object_ptr
+stringToObject(
+	CORBA::ORB_ptr			orb,
+	const char *			instructions,
+	const char *			str_ior) throw(ImportExportException)
+{
+	CORBA::Object_ptr		obj;
 
-	//--------
-	// Unstringify the object reference
-	//--------
 	try {
 		obj = orb->string_to_object(str_ior);
 	}
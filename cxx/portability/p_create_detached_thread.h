@@ -4,7 +4,8 @@
 //
 // File:	p_create_detached_thread.h
 //
-// Description:	Utility function to start a detached thread.
+// Description:	Utility function to start a detached thread, optionally
+//		with the attributes described in "p_thread_attr.h".
 //----------------------------------------------------------------------
 
 
@@ -15,6 +16,15 @@
 
 
 
+//--------
+// #include's
+//--------
+#include "p_thread_attr.h"
+
+
+
+
+
 #if defined(WIN32)
 //----------------------------------------------------------------------
 // Windows version
@@ -24,11 +34,54 @@
 
 typedef void *(*util_func_ptr)(void *);
 
+struct _help_create_detached_thread_data {
+	util_func_ptr		f;
+	void *			arg;
+};
+
+static unsigned __stdcall _help_create_detached_thread(void *p)
+{
+	_help_create_detached_thread_data	data;
+
+	data = *(_help_create_detached_thread_data *)p;
+	delete (_help_create_detached_thread_data *)p;
+	data.f(data.arg);
+	return 0;
+}
+
 inline void
-create_detached_thread(util_func_ptr f, void * arg)
+create_detached_thread(
+	util_func_ptr				f,
+	void *					arg,
+	const p_thread_attr *			attr = 0)
 {
-	int	tid;
-	tid = (int)_beginthread((void(*)(void *))f, 0, (void *)arg);
+	int					tid;
+	HANDLE					thread_handle;
+	unsigned				dummy;
+	_help_create_detached_thread_data *	data;
+
+	if (attr == 0) {
+		tid = (int)_beginthread((void(*)(void *))f, 0, (void *)arg);
+		return;
+	}
+
+	//--------
+	// The thread is created suspended so that its attributes are
+	// set before it runs.
+	//--------
+	data = new _help_create_detached_thread_data;
+	data->f   = f;
+	data->arg = arg;
+	thread_handle = (HANDLE)_beginthreadex(0,
+					(unsigned)attr->stack_size,
+					_help_create_detached_thread,
+					data,
+					CREATE_SUSPENDED,
+					&dummy);
+	assert(thread_handle != 0);
+	_p_thread_attr_apply(thread_handle, attr);
+	ResumeThread(thread_handle);
+	CloseHandle(thread_handle);
 }
 #else /* assume a POSIX system */
 //----------------------------------------------------------------------
@@ -40,7 +93,10 @@ create_detached_thread(util_func_ptr f, void * arg)
 typedef void *(*util_func_ptr)(void *);
 
 inline void
-create_detached_thread(util_func_ptr f, void * arg)
+create_detached_thread(
+	util_func_ptr		f,
+	void *			arg,
+	const p_thread_attr *	p_attr = 0)
 {
 	int			status;
 	pthread_t		tid;
@@ -49,9 +105,16 @@ create_detached_thread(util_func_ptr f, void * arg)
 	pthread_attr_init(&attr);
 	status = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 	assert(status == 0);
+	if (p_attr != 0) {
+		_p_thread_attr_apply_before(&attr, p_attr);
+	}
 
-	status = pthread_create(&tid, &attr, f, arg);
+	status = _p_thread_attr_create(&tid, &attr, p_attr, f, arg);
 	assert(status == 0);
+	pthread_attr_destroy(&attr);
+	if (p_attr != 0) {
+		_p_thread_attr_apply_after(tid, p_attr);
+	}
 }
 #endif
 
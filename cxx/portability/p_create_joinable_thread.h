@@ -5,9 +5,20 @@
 // Public API:	
 //	#define P_THREAD_ID_TYPE	...
 //	typedef void *(*util_func_ptr)(void *);
-//	P_THREAD_ID_TYPE create_joinable_thread(util_func_ptr f, void * arg);
+//	P_THREAD_ID_TYPE create_joinable_thread(util_func_ptr f, void * arg,
+//				const p_thread_attr * attr = 0);
+//	void create_joinable_threads(int n, util_func_ptr f, void * args[],
+//				P_THREAD_ID_TYPE thread_ids[],
+//				const p_thread_attr * attr = 0);
 //	void * join_with_thread(P_THREAD_ID_TYPE thread_id);
 //
+// Description:	create_joinable_threads() starts "n" threads that run
+//		"f". The i'th thread is passed "args[i]" (or 0 if "args"
+//		is null) and its id is stored in "thread_ids[i]". On
+//		Windows, create_joinable_thread() waits for each new
+//		thread to start, but create_joinable_threads() starts all
+//		the threads and then waits just once, for all of them.
+//
 // Portability:
 //	You must "#define WIN32" for Windows version.
 //	Otherwise you get the POSIX version.
@@ -24,6 +35,7 @@
 // #include's
 //--------
 #include "gsp_prodcons.h"
+#include "p_thread_attr.h"
 
 
 
@@ -65,7 +77,10 @@ static unsigned __stdcall _help_create_joinable_thread(void *p)
 }
 
 inline P_THREAD_ID_TYPE
-create_joinable_thread(util_func_ptr f, void * arg)
+create_joinable_thread(
+	util_func_ptr				f,
+	void *					arg,
+	const p_thread_attr *			attr = 0)
 {
 	_help_create_joinable_thread_data		data;
 	HANDLE						thread_handle;
@@ -75,19 +90,91 @@ create_joinable_thread(util_func_ptr f, void * arg)
 	data.arg = arg;
 	thread_handle = (HANDLE)_beginthreadex(
 					0, // default security
-					0, // default stack size
+					attr ? (unsigned)attr->stack_size : 0,
 					_help_create_joinable_thread, // func
 					&data, // arg
-					0, // statup state flag
+					attr ? CREATE_SUSPENDED : 0,
 					&dummy);
+	assert(thread_handle != 0);
+	if (attr != 0) {
+		_p_thread_attr_apply(thread_handle, attr);
+		ResumeThread(thread_handle);
+	}
 	{
 		GSP_ProdCons::GetOp		scopedLock(data.sync);
 	}
-	assert(thread_handle != 0);
 	return thread_handle;
 }
 
 
+struct _help_create_joinable_threads_data {
+	util_func_ptr		f;
+	void *			arg;
+	GSP_ProdCons *		latch;
+};
+
+static unsigned __stdcall _help_create_joinable_threads(void *p)
+{
+	util_func_ptr				f;
+	void *					arg;
+	void *					thread_result;
+	_help_create_joinable_threads_data *	data;
+
+	data = (_help_create_joinable_threads_data *)p;
+	f   = data->f;
+	arg = data->arg;
+	{
+		GSP_ProdCons::PutOp		scopedLock(*data->latch);
+	}
+
+	thread_result = f(arg);
+	return (unsigned) thread_result;
+}
+
+inline void
+create_joinable_threads(
+	int					n,
+	util_func_ptr				f,
+	void *					args[],
+	P_THREAD_ID_TYPE			thread_ids[],
+	const p_thread_attr *			attr = 0)
+{
+	_help_create_joinable_threads_data *	data;
+	GSP_ProdCons				latch;
+	unsigned				dummy;
+	long					remaining;
+	long					got;
+	int					i;
+
+	data = new _help_create_joinable_threads_data[n];
+	for (i = 0; i < n; i++) {
+		data[i].f     = f;
+		data[i].arg   = args ? args[i] : 0;
+		data[i].latch = &latch;
+		thread_ids[i] = (HANDLE)_beginthreadex(
+					0, // default security
+					attr ? (unsigned)attr->stack_size : 0,
+					_help_create_joinable_threads, // func
+					&data[i], // arg
+					attr ? CREATE_SUSPENDED : 0,
+					&dummy);
+		assert(thread_ids[i] != 0);
+		if (attr != 0) {
+			_p_thread_attr_apply(thread_ids[i], attr);
+			ResumeThread(thread_ids[i]);
+		}
+	}
+
+	//--------
+	// Wait until every thread has copied its data
+	//--------
+	for (remaining = n; remaining > 0; remaining -= got) {
+		GSP_ProdCons::GetBatchOp	scopedLock(latch, remaining, got);
+	}
+	delete [] data;
+}
+
+
 inline void *
 join_with_thread(P_THREAD_ID_TYPE thread_handle)
 {
@@ -112,16 +199,62 @@ join_with_thread(P_THREAD_ID_TYPE thread_handle)
 typedef void *(*util_func_ptr)(void *);
 
 inline P_THREAD_ID_TYPE
-create_joinable_thread(util_func_ptr f, void * arg)
+create_joinable_thread(
+	util_func_ptr		f,
+	void *			arg,
+	const p_thread_attr *	attr = 0)
 {
 	int			status;
 	pthread_t		thread_id;
+	pthread_attr_t		pattr;
+
+	if (attr == 0) {
+		status = pthread_create(&thread_id, 0, f, arg);
+		assert(status == 0);
+		return thread_id;
+	}
 
-	status = pthread_create(&thread_id, 0, f, arg);
+	pthread_attr_init(&pattr);
+	_p_thread_attr_apply_before(&pattr, attr);
+	status = _p_thread_attr_create(&thread_id, &pattr, attr, f, arg);
 	assert(status == 0);
+	pthread_attr_destroy(&pattr);
+	_p_thread_attr_apply_after(thread_id, attr);
 	return thread_id;
 }
 
+inline void
+create_joinable_threads(
+	int			n,
+	util_func_ptr		f,
+	void *			args[],
+	P_THREAD_ID_TYPE	thread_ids[],
+	const p_thread_attr *	attr = 0)
+{
+	int			status;
+	int			i;
+	pthread_attr_t		pattr;
+
+	//--------
+	// Initialise the attributes just once for all the threads. If
+	// the first thread cannot be created with them then
+	// _p_thread_attr_create() replaces them for the others too.
+	//--------
+	pthread_attr_init(&pattr);
+	if (attr != 0) {
+		_p_thread_attr_apply_before(&pattr, attr);
+	}
+	for (i = 0; i < n; i++) {
+		status = _p_thread_attr_create(&thread_ids[i], &pattr, attr,
+					f, args ? args[i] : 0);
+		assert(status == 0);
+		if (attr != 0) {
+			_p_thread_attr_apply_after(thread_ids[i], attr);
+		}
+	}
+	pthread_attr_destroy(&pattr);
+}
+
 inline void *
 join_with_thread(P_THREAD_ID_TYPE thread_id)
 {
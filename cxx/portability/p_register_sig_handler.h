@@ -23,6 +23,20 @@
 //		...
 //	}
 //
+//	On UNIX, p_register_signal_handler() calls the handler from
+//	within the signal handler, where very few functions can be
+//	called safely. p_register_signal_handler_deferred() takes
+//	the same argument, but the signal handler just writes the
+//	signal number to a pipe, and a dedicated watcher thread reads
+//	it and then calls the handler, which can do anything, such as
+//	calling orb->shutdown(). p_register_signal_callback(sig, f)
+//	uses the same watcher thread to call "f" every time "sig"
+//	occurs; for example, to dump statistics when SIGUSR1 occurs.
+//	On Windows, and with Orbix, the handler is always called by a
+//	separate thread, so p_register_signal_handler_deferred() is
+//	the same as p_register_signal_handler(), and
+//	p_register_signal_callback() is not available on Windows.
+//
 //
 // Note:	Ensure that one of the following macros is defined
 //		before including this file:
@@ -63,6 +77,11 @@ static void p_register_signal_handler(p_sig_handler_func_type f)
 	p_it_term_handler = new IT_TerminationHandler(p_orbix_sig_handler);
 }
 
+static void p_register_signal_handler_deferred(p_sig_handler_func_type f)
+{
+	p_register_signal_handler(f);
+}
+
 
 
 
@@ -88,6 +107,11 @@ static void p_register_signal_handler(p_sig_handler_func_type f)
 	if (!rc) { abort(); }
 }
 
+static void p_register_signal_handler_deferred(p_sig_handler_func_type f)
+{
+	p_register_signal_handler(f);
+}
+
 
 
 
@@ -134,4 +158,124 @@ static void p_register_signal_handler(p_sig_handler_func_type f)
 #endif /* P_USE_ORBIX/WIN32/else */
 
 
+
+
+
+#if !defined(WIN32)
+//--------
+// UNIX-specific deferred signal handling. The signal handler writes
+// the signal number to a self-pipe; this is async-signal-safe. A
+// watcher thread reads the pipe and calls the registered function.
+// A pipe is used rather than an eventfd because an eventfd would not
+// say which signal occurred.
+//--------
+#include "p_create_detached_thread.h"
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+
+#define P_SIG_MAX	64
+
+static int			p_sig_pipe[2] = { -1, -1 };
+static p_sig_handler_func_type	p_sig_callbacks[P_SIG_MAX];
+static int			p_sig_is_termination[P_SIG_MAX];
+
+static void p_unix_deferred_sig_handler(int sig)
+{
+	int				saved_errno;
+	unsigned char			byte;
+
+	saved_errno = errno;
+	byte = (unsigned char)sig;
+	if (write(p_sig_pipe[1], &byte, 1) < 0) {
+		// if the pipe is full then drop it
+	}
+	errno = saved_errno;
+}
+
+static void * p_sig_watcher(void *)
+{
+	unsigned char			byte;
+	ssize_t				n;
+	bool				terminating;
+
+	terminating = false;
+	for (;;) {
+		n = read(p_sig_pipe[0], &byte, 1);
+		if (n == -1 && errno == EINTR) {
+			continue;
+		}
+		if (n != 1) {
+			abort();
+		}
+		if (byte >= P_SIG_MAX || p_sig_callbacks[byte] == 0) {
+			continue;
+		}
+
+		//--------
+		// Call the termination handler only once, as
+		// p_register_signal_handler() does.
+		//--------
+		if (p_sig_is_termination[byte]) {
+			if (terminating) {
+				continue;
+			}
+			terminating = true;
+		}
+		(*p_sig_callbacks[byte])();
+	}
+	return 0;
+}
+
+static void p_sig_start_watcher()
+{
+	int				flags;
+
+	if (p_sig_pipe[0] != -1) {
+		return;
+	}
+	if (pipe(p_sig_pipe) == -1) { abort(); }
+	flags = fcntl(p_sig_pipe[1], F_GETFL);
+	if (fcntl(p_sig_pipe[1], F_SETFL, flags | O_NONBLOCK) == -1) {
+		abort();
+	}
+	create_detached_thread(p_sig_watcher, 0);
+}
+
+static void p_sig_install_deferred(
+	int				sig,
+	p_sig_handler_func_type		f,
+	int				is_termination)
+{
+	struct sigaction		action;
+
+	if (sig <= 0 || sig >= P_SIG_MAX) { abort(); }
+	p_sig_start_watcher();
+	p_sig_callbacks[sig] = f;
+	p_sig_is_termination[sig] = is_termination;
+
+	action.sa_handler = p_unix_deferred_sig_handler;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = 0 | SA_RESTART;
+	if (sigaction(sig, &action, 0) == -1) { abort(); }
+}
+
+#if !defined(P_USE_ORBIX)
+static void p_register_signal_handler_deferred(p_sig_handler_func_type f)
+{
+	p_sig_install_deferred(SIGINT, f, 1);
+	p_sig_install_deferred(SIGTERM, f, 1);
+	p_sig_install_deferred(SIGHUP, f, 1);
+}
+#endif
+
+static void p_register_signal_callback(int sig, p_sig_handler_func_type f)
+{
+	p_sig_install_deferred(sig, f, 0);
+}
+#endif /* !WIN32 */
+
+
 #endif /* P_REG_SIG_HANDLER_H_ */
@@ -0,0 +1,346 @@
+//-----------------------------------------------------------------------
+// Copyright (c) 2002-2005 IONA Technologies. All rights reserved.
+// This software is provided "as is".
+//
+// File:	p_thread_attr.h
+//
+// Public API:
+//	#define P_THREAD_ATTR_MAX_CPUS	...
+//	#define P_SCHED_DEFAULT		...
+//	#define P_SCHED_OTHER		...
+//	#define P_SCHED_FIFO		...
+//	#define P_SCHED_RR		...
+//	struct p_thread_attr {
+//		unsigned long	stack_size;	// bytes; 0 means the default
+//		const char *	name;		// 0 means no name
+//		int		sched_policy;	// one of P_SCHED_*
+//		int		sched_priority;
+//		int		numa_node;	// -1 means any node
+//		int		num_cpus;	// 0 means any CPU
+//		int		cpus[P_THREAD_ATTR_MAX_CPUS];
+//	};
+//	void p_thread_attr_init(p_thread_attr * attr);
+//	void p_thread_attr_add_cpu(p_thread_attr * attr, int cpu);
+//
+// Description:	Attributes for the threads that are started by
+//		create_joinable_thread() and create_detached_thread().
+//		A thread is pinned to the CPUs in "cpus". If "numa_node"
+//		is set then it is pinned to the CPUs of that NUMA node
+//		(or, if "cpus" is also set, to the CPUs that are in both)
+//		and, as operating systems allocate memory on the node
+//		of the thread that first touches it, its memory will
+//		usually be local to that node.
+//
+// Portability:
+//	You must "#define WIN32" for Windows version.
+//	Otherwise you get the POSIX version.
+//
+//	The CPU set and NUMA node are honoured only on Linux and
+//	Windows, and the name only on Linux. On POSIX systems, if
+//	the thread cannot be created with the scheduling policy or
+//	CPU set (for example, because the process may not use
+//	SCHED_FIFO) then it is created without them. On Windows,
+//	"sched_priority" is passed to SetThreadPriority() if
+//	"sched_policy" is not P_SCHED_DEFAULT, and CPUs above 63 are
+//	ignored.
+//----------------------------------------------------------------------
+
+#ifndef P_THREAD_ATTR_H_
+#define P_THREAD_ATTR_H_
+
+
+
+
+
+//--------
+// #include's
+//--------
+#include <assert.h>
+#if defined(WIN32)
+#	include <windows.h>
+#else
+#	include <pthread.h>
+#	include <sched.h>
+#	include <limits.h>
+#	include <string.h>
+#	if defined(__linux__)
+#		include <stdio.h>
+#		include <stdlib.h>
+#	endif
+#endif
+
+
+
+
+
+#define P_THREAD_ATTR_MAX_CPUS	256
+
+#define P_SCHED_DEFAULT		0
+#define P_SCHED_OTHER		1
+#define P_SCHED_FIFO		2
+#define P_SCHED_RR		3
+
+struct p_thread_attr {
+	unsigned long	stack_size;
+	const char *	name;
+	int		sched_policy;
+	int		sched_priority;
+	int		numa_node;
+	int		num_cpus;
+	int		cpus[P_THREAD_ATTR_MAX_CPUS];
+};
+
+
+inline void
+p_thread_attr_init(p_thread_attr * attr)
+{
+	attr->stack_size     = 0;
+	attr->name           = 0;
+	attr->sched_policy   = P_SCHED_DEFAULT;
+	attr->sched_priority = 0;
+	attr->numa_node      = -1;
+	attr->num_cpus       = 0;
+}
+
+
+inline void
+p_thread_attr_add_cpu(p_thread_attr * attr, int cpu)
+{
+	assert(attr->num_cpus < P_THREAD_ATTR_MAX_CPUS);
+	attr->cpus[attr->num_cpus] = cpu;
+	attr->num_cpus ++;
+}
+
+
+
+
+
+#if defined(WIN32)
+//--------
+// Windows implementation. The thread must have been created suspended.
+//--------
+
+inline void
+_p_thread_attr_apply(HANDLE thread_handle, const p_thread_attr * attr)
+{
+	DWORD_PTR		mask;
+	ULONGLONG		node_mask;
+	int			i;
+
+	mask = 0;
+	for (i = 0; i < attr->num_cpus; i++) {
+		if (attr->cpus[i] >= 0 && attr->cpus[i] < 64) {
+			mask |= ((DWORD_PTR)1) << attr->cpus[i];
+		}
+	}
+	if (attr->numa_node >= 0
+	    && GetNumaNodeProcessorMask((UCHAR)attr->numa_node, &node_mask))
+	{
+		if (attr->num_cpus > 0) {
+			mask &= (DWORD_PTR)node_mask;
+		} else {
+			mask = (DWORD_PTR)node_mask;
+		}
+	}
+	if (mask != 0) {
+		SetThreadAffinityMask(thread_handle, mask);
+	}
+	if (attr->sched_policy != P_SCHED_DEFAULT) {
+		SetThreadPriority(thread_handle, attr->sched_priority);
+	}
+}
+#else
+//--------
+// POSIX implementation
+//--------
+
+#if defined(__linux__)
+//--------
+// Adds the CPUs of a NUMA node to "set". The CPUs are listed in sysfs
+// as, for example, "0-3,8-11".
+//--------
+inline bool
+_p_thread_attr_numa_cpus(int node, cpu_set_t * set)
+{
+	char			path[64];
+	char			buf[1024];
+	char *			p;
+	char *			end;
+	FILE *			fp;
+	long			first;
+	long			last;
+
+	sprintf(path, "/sys/devices/system/node/node%d/cpulist", node);
+	fp = fopen(path, "r");
+	if (fp == 0) {
+		return false;
+	}
+	p = fgets(buf, sizeof(buf), fp);
+	fclose(fp);
+	if (p == 0) {
+		return false;
+	}
+
+	CPU_ZERO(set);
+	while (*p >= '0' && *p <= '9') {
+		first = strtol(p, &end, 10);
+		last = first;
+		if (*end == '-') {
+			last = strtol(end + 1, &end, 10);
+		}
+		for (; first <= last && first < CPU_SETSIZE; first++) {
+			CPU_SET((int)first, set);
+		}
+		p = (*end == ',') ? end + 1 : end;
+	}
+	return true;
+}
+#endif
+
+
+//--------
+// Sets the attributes that must be given to pthread_create()
+//--------
+inline void
+_p_thread_attr_apply_before(pthread_attr_t * pattr, const p_thread_attr * attr)
+{
+	int			status;
+	size_t			stack_size;
+	struct sched_param	param;
+
+	if (attr->stack_size != 0) {
+		stack_size = attr->stack_size;
+		if (stack_size < (size_t)PTHREAD_STACK_MIN) {
+			stack_size = (size_t)PTHREAD_STACK_MIN;
+		}
+		status = pthread_attr_setstacksize(pattr, stack_size);
+		assert(status == 0);
+	}
+
+	//--------
+	// An unsupported policy or a priority that is out of range for
+	// the policy leaves the thread with the scheduling of its creator.
+	//--------
+	if (attr->sched_policy != P_SCHED_DEFAULT) {
+		switch (attr->sched_policy) {
+		case P_SCHED_FIFO:
+			status = pthread_attr_setschedpolicy(pattr, SCHED_FIFO);
+			break;
+		case P_SCHED_RR:
+			status = pthread_attr_setschedpolicy(pattr, SCHED_RR);
+			break;
+		default:
+			status = pthread_attr_setschedpolicy(pattr, SCHED_OTHER);
+			break;
+		}
+		if (status == 0) {
+			memset(&param, 0, sizeof(param));
+			param.sched_priority = attr->sched_priority;
+			status = pthread_attr_setschedparam(pattr, &param);
+		}
+		if (status == 0) {
+			pthread_attr_setinheritsched(pattr,
+						PTHREAD_EXPLICIT_SCHED);
+		}
+	}
+
+#if defined(__linux__)
+	cpu_set_t		cpus;
+	cpu_set_t		node_cpus;
+	int			i;
+	bool			pin;
+
+	pin = false;
+	CPU_ZERO(&cpus);
+	for (i = 0; i < attr->num_cpus; i++) {
+		if (attr->cpus[i] >= 0 && attr->cpus[i] < CPU_SETSIZE) {
+			CPU_SET(attr->cpus[i], &cpus);
+			pin = true;
+		}
+	}
+	if (attr->numa_node >= 0
+	    && _p_thread_attr_numa_cpus(attr->numa_node, &node_cpus))
+	{
+		if (pin) {
+			CPU_AND(&cpus, &cpus, &node_cpus);
+		} else {
+			cpus = node_cpus;
+			pin = true;
+		}
+	}
+	if (pin && CPU_COUNT(&cpus) > 0) {
+		status = pthread_attr_setaffinity_np(pattr, sizeof(cpus), &cpus);
+		assert(status == 0);
+	}
+#endif
+}
+
+
+//--------
+// Sets the attributes that can be set only after the thread exists
+//--------
+inline void
+_p_thread_attr_apply_after(pthread_t thread_id, const p_thread_attr * attr)
+{
+#if defined(__linux__)
+	char			name[16];	// Linux limit, including '\0'
+
+	if (attr->name != 0) {
+		strncpy(name, attr->name, sizeof(name) - 1);
+		name[sizeof(name) - 1] = '\0';
+		pthread_setname_np(thread_id, name);
+	}
+#endif
+}
+
+
+//--------
+// Calls pthread_create() with "pattr", to which "attr" has been applied
+// by _p_thread_attr_apply_before(). pthread_create() fails with EPERM
+// if the caller may not use the scheduling policy of "attr", and with
+// EINVAL if none of its CPUs is online. In that case "pattr" is set
+// up again with only the stack size of "attr" (and the detach state
+// it had), and the thread is created with that. Callers that create
+// several threads with "pattr" therefore retry just once. Returns the
+// status of the last pthread_create().
+//--------
+inline int
+_p_thread_attr_create(
+	pthread_t *		thread_id,
+	pthread_attr_t *	pattr,
+	const p_thread_attr *	attr,
+	void *			(*f)(void *),
+	void *			arg)
+{
+	int			status;
+	int			detach_state;
+	p_thread_attr		fallback;
+
+	status = pthread_create(thread_id, pattr, f, arg);
+	if (status == 0 || attr == 0) {
+		return status;
+	}
+	if (attr->sched_policy == P_SCHED_DEFAULT
+	    && attr->num_cpus == 0
+	    && attr->numa_node < 0)
+	{
+		return status;
+	}
+
+	detach_state = PTHREAD_CREATE_JOINABLE;
+	pthread_attr_getdetachstate(pattr, &detach_state);
+	pthread_attr_destroy(pattr);
+	pthread_attr_init(pattr);
+	pthread_attr_setdetachstate(pattr, detach_state);
+	p_thread_attr_init(&fallback);
+	fallback.stack_size = attr->stack_size;
+	_p_thread_attr_apply_before(pattr, &fallback);
+	return pthread_create(thread_id, pattr, f, arg);
+}
+#endif
+
+
+
+
+
+#endif /* P_THREAD_ATTR_H_ */